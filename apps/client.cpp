@@ -1,7 +1,6 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
-#include <chrono>
 #include <iostream>
 #include <cerrno>
 #include <cstring>
@@ -9,15 +8,16 @@
 #include <span>
 
 #include "wire.hpp"
+#include "clock.hpp"
 #include "codec.hpp"
+#include "metrics.hpp"
 #include "order_book.hpp"
+#include "stage_latency.hpp"
 
 static const char* kSockPath = "/tmp/demo.sock";
 
-static uint64_t now_ns() noexcept {
-    using namespace std::chrono;
-    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
-}
+// TSC-backed where available; same time base as the engine's ACK stamps
+using clk::now_ns;
 
 static bool read_exact(int fd, void *buf, size_t n) {
     uint8_t* p = static_cast<uint8_t*>(buf);
@@ -58,6 +58,24 @@ static bool write_all(int fd, const void *buf, size_t n) {
     return true;
 }
 
+// Reads one frame and decodes it as an ACK; false on EOF, a bad frame or another type.
+static bool read_ack(int fd, AckBody& out) {
+    Header h{};
+    if (!read_exact(fd, &h, sizeof(Header)) || h.size < sizeof(Header) || h.size - sizeof(Header) > kMaxFrame) {
+        return false;
+    }
+    std::vector<uint8_t> body(h.size - sizeof(Header));
+    if (!read_exact(fd, body.data(), body.size()) || static_cast<MsgType>(h.type) != MsgType::ACK) {
+        return false;
+    }
+    try {
+        out = codec::decode_body<AckBody>(std::span<const uint8_t>(body));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
 int main() {
     int server_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
     if (server_fd < 0) {
@@ -221,6 +239,80 @@ int main() {
         std::cerr << "client: expected ACK for CANCEL but got message type " << int(cancel_ack_hdr.type) << "\n";
     }
 
+    // Step 4: rest a bid and an ask, then pull both with one MASS_CANCEL
+    std::cout << "\nclient: sending two NEW orders and a MASS_CANCEL for instrument " << body.instrument_id << "\n";
+    std::vector<uint8_t> batch;
+    for (uint8_t side : {uint8_t(OrderSide::Bid), uint8_t(OrderSide::Ask)}) {
+        OrderNewBody quote = body;
+        quote.client_order_id = 100 + side;
+        quote.side = side;
+        quote.price_ticks = side == uint8_t(OrderSide::Bid) ? 90 : 120;
+        Header qh = codec::make_header(MsgType::NEW, sizeof(OrderNewBody), 2 + side, now_ns());
+        const std::vector<uint8_t> q = codec::pack(qh, quote);
+        batch.insert(batch.end(), q.begin(), q.end());
+    }
+    MassCancelBody mass{};
+    mass.client_order_id = 200;
+    mass.instrument_id = body.instrument_id;
+    mass.side = kBothSides;
+    Header mh = codec::make_header(MsgType::MASS_CANCEL, sizeof(MassCancelBody), 4, now_ns());
+    const std::vector<uint8_t> m = codec::pack(mh, mass);
+    batch.insert(batch.end(), m.begin(), m.end());
+    if (!write_all(server_fd, batch.data(), batch.size())) {
+        std::cerr << "client: failed to send MASS_CANCEL\n";
+        ::close(server_fd);
+        return 1;
+    }
+    for (int i = 0; i < 3; ++i) {
+        AckBody a{};
+        if (!read_ack(server_fd, a)) {
+            std::cerr << "client: failed to receive ACK " << i + 1 << " of the MASS_CANCEL batch\n";
+            ::close(server_fd);
+            return 1;
+        }
+        if (a.client_order_id == mass.client_order_id) {
+            std::cout << "MASS_CANCEL ACK: cid=" << a.client_order_id
+                      << " status=" << int(a.status) << (a.status == 0 ? " (ACCEPTED)" : " (REJECTED)")
+                      << " cancelled=" << a.cancelled_count << "\n";
+        }
+    }
+
+    // Step 5: the server's counters, which by now include everything above
+    std::cout << "\nclient: sending STATS_REQUEST\n";
+    StatsRequestBody sreq{};
+    sreq.request_id = 300;
+    Header sh = codec::make_header(MsgType::STATS_REQUEST, sizeof(StatsRequestBody), 5, now_ns());
+    const std::vector<uint8_t> sframe = codec::pack(sh, sreq);
+    Header rh{};
+    if (!write_all(server_fd, sframe.data(), sframe.size()) || !read_exact(server_fd, &rh, sizeof(Header)) ||
+        static_cast<MsgType>(rh.type) != MsgType::STATS || rh.size != sizeof(Header) + sizeof(StatsBody)) {
+        std::cerr << "client: failed to get STATS\n";
+        ::close(server_fd);
+        return 1;
+    }
+    StatsBody stats{};
+    if (!read_exact(server_fd, &stats, sizeof(StatsBody))) {
+        std::cerr << "client: failed to read STATS body\n";
+        ::close(server_fd);
+        return 1;
+    }
+    std::cout << "STATS: request=" << stats.request_id;
+    for (uint32_t i = 0; i < stats.num_values && i < kNumMetrics; ++i) {
+        std::cout << " " << metric_name(static_cast<Metric>(i)) << "=" << stats.values[i];
+    }
+    std::cout << "\n";
+    for (uint32_t i = 0; i < stats.num_latency; ++i) {
+        LatencyBody lat{};
+        if (!read_exact(server_fd, &rh, sizeof(Header)) || static_cast<MsgType>(rh.type) != MsgType::LATENCY ||
+            rh.size != sizeof(Header) + sizeof(LatencyBody) || !read_exact(server_fd, &lat, sizeof(LatencyBody))) {
+            std::cerr << "client: failed to read LATENCY " << i + 1 << " of " << stats.num_latency << "\n";
+            ::close(server_fd);
+            return 1;
+        }
+        std::cout << "LATENCY: " << latency_stage_name(static_cast<LatencyStage>(lat.stage)) << " n=" << lat.count
+                  << " p50=" << lat.p50_ns << " p99=" << lat.p99_ns << " max=" << lat.max_ns << "\n";
+    }
+
     std::cout << "\nclient: workflow completed successfully\n";
     
     ::close(server_fd);
@@ -0,0 +1,85 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "capture.hpp"
+#include "flow_gen.hpp"
+
+// Writes a seeded synthetic order flow to a capture file (see capture.hpp).
+// The file drives replay, loadgen --capture and the benchmarks, so numbers
+// taken on different machines or commits see exactly the same requests.
+
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " --out file --count N [--seed n] [--rate msgs/s] [--instruments N]\n"
+              << "          [--mid px] [--mid-vol ticks] [--mid-reversion 1/s] [--depth-mean ticks]\n"
+              << "          [--qty-mean q] [--cancel-share r] [--cancel-depth ticks] [--sweep-prob r] [--sweep-ticks n]\n";
+}
+
+int main(int argc, char** argv) {
+    FlowGenConfig cfg;
+    std::string out_path;
+    uint64_t count = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--out" && has_value) {
+            out_path = argv[++i];
+        } else if (arg == "--count" && has_value) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && has_value) {
+            cfg.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--rate" && has_value) {
+            cfg.rate = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--instruments" && has_value) {
+            cfg.num_instruments = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--mid" && has_value) {
+            cfg.mid_px = std::strtoll(argv[++i], nullptr, 10);
+        } else if (arg == "--mid-vol" && has_value) {
+            cfg.mid_vol = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--mid-reversion" && has_value) {
+            cfg.mid_reversion = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--depth-mean" && has_value) {
+            cfg.depth_mean = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--qty-mean" && has_value) {
+            cfg.qty_mean = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--cancel-share" && has_value) {
+            cfg.cancel_share = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--cancel-depth" && has_value) {
+            cfg.cancel_depth_ticks = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--sweep-prob" && has_value) {
+            cfg.sweep_prob = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--sweep-ticks" && has_value) {
+            cfg.sweep_ticks = std::strtoll(argv[++i], nullptr, 10);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (out_path.empty() || count == 0 || cfg.rate <= 0 || cfg.num_instruments == 0 || cfg.depth_mean < 1.0 ||
+        cfg.qty_mean < 1.0 || cfg.cancel_depth_ticks <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    CaptureWriter writer;
+    if (!writer.open(out_path, cfg.seed)) {
+        return 1;
+    }
+    FlowGenerator gen(cfg);
+    for (uint64_t i = 0; i < count; ++i) {
+        FlowEvent ev = gen.next();
+        if (ev.type == MsgType::NEW) {
+            writer.append(MsgType::NEW, ev.new_order, ev.ts_ns);
+        } else {
+            writer.append(MsgType::CANCEL, ev.cancel, ev.ts_ns);
+        }
+    }
+    if (!writer.close()) {
+        std::cerr << "flowgen: failed writing " << out_path << "\n";
+        return 1;
+    }
+    std::cout << "flowgen: wrote " << writer.frames() << " frames to " << out_path
+              << " (news=" << gen.news() << " cancels=" << gen.cancels() << " sweeps=" << gen.sweeps()
+              << " resting at end=" << gen.resting() << ")\n";
+    return 0;
+}
@@ -0,0 +1,428 @@
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "wire.hpp"
+#include "capture.hpp"
+#include "clock.hpp"
+#include "codec.hpp"
+#include "latency_histogram.hpp"
+#include "order_book.hpp"
+
+// Open-loop load generator. Orders go out on a fixed schedule whatever the
+// server is doing; ACKs are matched back by client_order_id. RTT is measured
+// from the intended send time, so a stalled server shows up in the tail
+// instead of silently slowing the generator down (coordinated omission).
+
+static const char* kSockPath = "/tmp/demo.sock";
+
+// TSC-backed where available; same time base as the engine's ACK stamps
+using clk::now_ns;
+
+struct LoadConfig {
+    std::string socket_path = kSockPath;
+    double rate = 10'000;             // messages per second
+    uint64_t count = 0;               // 0 = rate * duration
+    double duration_s = 5.0;
+    std::vector<uint32_t> instruments{1};
+    std::vector<uint32_t> weights{1};
+    double cancel_ratio = 0.2;        // share of messages that cancel a resting order
+    double aggressive = 0.1;          // share of NEWs that cross the spread (IOC)
+    int64_t mid_px = 10'000;
+    int64_t depth = 10;               // passive orders rest within this many ticks of mid
+    int32_t max_qty = 100;
+    uint64_t seed = 1;
+    double drain_s = 2.0;             // wait this long for the last responses
+    bool json = false;
+    std::string capture_path;         // replay this flow instead of generating one
+    bool rate_set = false;            // with a capture: pace at --rate, not the file's timestamps
+};
+
+struct InFlight {
+    uint64_t intended_ns;
+    uint64_t sent_ns;
+    uint32_t instrument_id;
+    bool rests; // passive NEW: remember its exch id for later cancels
+};
+
+// "1,2,3" or "1:5,2:1" (instrument:weight)
+static bool parse_instruments(const std::string& text, LoadConfig& cfg) {
+    cfg.instruments.clear();
+    cfg.weights.clear();
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) end = text.size();
+        const std::string item = text.substr(pos, end - pos);
+        const size_t colon = item.find(':');
+        const unsigned long id = std::strtoul(item.c_str(), nullptr, 10);
+        const unsigned long w = colon == std::string::npos ? 1 : std::strtoul(item.c_str() + colon + 1, nullptr, 10);
+        if (id == 0 || w == 0) {
+            return false;
+        }
+        cfg.instruments.push_back(static_cast<uint32_t>(id));
+        cfg.weights.push_back(static_cast<uint32_t>(w));
+        pos = end + 1;
+    }
+    return !cfg.instruments.empty();
+}
+
+static bool set_nonblocking(int fd) {
+    int fl = ::fcntl(fd, F_GETFL, 0);
+    return fl >= 0 && ::fcntl(fd, F_SETFL, fl | O_NONBLOCK) == 0;
+}
+
+// Writes as much of out[head..] as the socket accepts. Returns false on error.
+static bool flush_out(int fd, std::vector<uint8_t>& out, size_t& head) {
+    while (head < out.size()) {
+        ssize_t n = ::write(fd, out.data() + head, out.size() - head);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        head += size_t(n);
+    }
+    if (head == out.size()) {
+        out.clear();
+        head = 0;
+    }
+    return true;
+}
+
+class FlowGen {
+public:
+    explicit FlowGen(const LoadConfig& cfg)
+        : cfg_(cfg), rng_(cfg.seed), pick_instr_(cfg.weights.begin(), cfg.weights.end()) {}
+
+    // Appends the next message to out. Returns the in-flight record for it.
+    InFlight next(uint64_t cid, std::unordered_map<uint32_t, std::vector<uint64_t>>& live,
+                  std::vector<uint8_t>& out) {
+        InFlight f{};
+        f.instrument_id = cfg_.instruments[pick_instr_(rng_)];
+        std::vector<uint64_t>& resting = live[f.instrument_id];
+        if (!resting.empty() && unit_(rng_) < cfg_.cancel_ratio) {
+            std::uniform_int_distribution<size_t> pick(0, resting.size() - 1);
+            const size_t i = pick(rng_);
+            OrderCancelBody c{};
+            c.client_order_id = cid;
+            c.exch_order_id = resting[i];
+            c.instrument_id = f.instrument_id;
+            resting[i] = resting.back();
+            resting.pop_back();
+            append(out, MsgType::CANCEL, c);
+            return f;
+        }
+
+        OrderNewBody o{};
+        o.client_order_id = cid;
+        o.instrument_id = f.instrument_id;
+        o.side = static_cast<uint8_t>(unit_(rng_) < 0.5 ? OrderSide::Bid : OrderSide::Ask);
+        o.qty = std::uniform_int_distribution<int32_t>(1, cfg_.max_qty)(rng_);
+        const int64_t sign = o.side == static_cast<uint8_t>(OrderSide::Bid) ? -1 : 1;
+        if (unit_(rng_) < cfg_.aggressive) {
+            // crosses every passive level, leftover discarded
+            o.price_ticks = cfg_.mid_px - sign * cfg_.depth;
+            o.flags = TIF_IOC;
+        } else {
+            o.price_ticks = cfg_.mid_px + sign * std::uniform_int_distribution<int64_t>(1, cfg_.depth)(rng_);
+            f.rests = true;
+        }
+        append(out, MsgType::NEW, o);
+        return f;
+    }
+
+private:
+    template <typename BodyT>
+    static void append(std::vector<uint8_t>& out, MsgType type, const BodyT& body) {
+        Header h = codec::make_header(type, sizeof(BodyT), 0, now_ns());
+        const uint8_t* hp = reinterpret_cast<const uint8_t*>(&h);
+        const uint8_t* bp = reinterpret_cast<const uint8_t*>(&body);
+        out.insert(out.end(), hp, hp + sizeof(Header));
+        out.insert(out.end(), bp, bp + sizeof(BodyT));
+    }
+
+    const LoadConfig& cfg_;
+    std::mt19937_64 rng_;
+    std::discrete_distribution<size_t> pick_instr_;
+    std::uniform_real_distribution<double> unit_{0.0, 1.0};
+};
+
+// Copies one recorded request into the send buffer, stamped with the real send
+// time. Returns its client_order_id.
+static uint64_t append_captured(const CaptureFile::Frame& f, std::vector<uint8_t>& out) {
+    Header h = f.hdr;
+    h.ts_ns = now_ns();
+    const uint8_t* hp = reinterpret_cast<const uint8_t*>(&h);
+    out.insert(out.end(), hp, hp + sizeof(Header));
+    out.insert(out.end(), f.body.begin(), f.body.end());
+    if (h.type == static_cast<uint8_t>(MsgType::CANCEL)) {
+        return codec::decode_body<OrderCancelBody>(f.body).client_order_id;
+    }
+    return codec::decode_body<OrderNewBody>(f.body).client_order_id;
+}
+
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " [--rate msgs/s] [--count N | --duration s] [--instruments 1:5,2:1]\n"
+              << "          [--cancel-ratio r] [--aggressive r] [--mid px] [--depth ticks] [--max-qty q]\n"
+              << "          [--seed n] [--drain s] [--socket path] [--json]\n"
+              << "       " << argv0 << " --capture file [--rate msgs/s] [--count N] [--drain s] [--socket path] [--json]\n"
+              << "  --capture  send the requests recorded by flowgen (server must be freshly started)\n";
+}
+
+static void print_pcts(const char* label, const LatencyHistogram& h) {
+    std::cout << "loadgen: " << label << " p50=" << h.percentile(50) / 1000.0
+              << " p99=" << h.percentile(99) / 1000.0
+              << " p99.9=" << h.percentile(99.9) / 1000.0
+              << " max=" << h.max() / 1000.0 << " us\n";
+}
+
+static void json_pcts(const char* key, const LatencyHistogram& h) {
+    std::cout << "\"" << key << "\":{\"p50\":" << h.percentile(50) << ",\"p99\":" << h.percentile(99)
+              << ",\"p999\":" << h.percentile(99.9) << ",\"max\":" << h.max() << "}";
+}
+
+int main(int argc, char** argv) {
+    LoadConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--rate" && has_value) {
+            cfg.rate = std::strtod(argv[++i], nullptr);
+            cfg.rate_set = true;
+        } else if (arg == "--count" && has_value) {
+            cfg.count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--duration" && has_value) {
+            cfg.duration_s = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--instruments" && has_value) {
+            if (!parse_instruments(argv[++i], cfg)) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (arg == "--cancel-ratio" && has_value) {
+            cfg.cancel_ratio = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--aggressive" && has_value) {
+            cfg.aggressive = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--mid" && has_value) {
+            cfg.mid_px = std::strtoll(argv[++i], nullptr, 10);
+        } else if (arg == "--depth" && has_value) {
+            cfg.depth = std::strtoll(argv[++i], nullptr, 10);
+        } else if (arg == "--max-qty" && has_value) {
+            cfg.max_qty = static_cast<int32_t>(std::strtol(argv[++i], nullptr, 10));
+        } else if (arg == "--seed" && has_value) {
+            cfg.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--drain" && has_value) {
+            cfg.drain_s = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--socket" && has_value) {
+            cfg.socket_path = argv[++i];
+        } else if (arg == "--json") {
+            cfg.json = true;
+        } else if (arg == "--capture" && has_value) {
+            cfg.capture_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (cfg.rate <= 0 || cfg.depth < 1 || cfg.max_qty < 1 || cfg.mid_px <= cfg.depth) {
+        usage(argv[0]);
+        return 2;
+    }
+    uint64_t total = cfg.count ? cfg.count : static_cast<uint64_t>(cfg.rate * cfg.duration_s);
+
+    CaptureFile cap;
+    CaptureFile::Frame frame{}; // next frame to send, read ahead for its timestamp
+    const bool from_capture = !cfg.capture_path.empty();
+    if (from_capture) {
+        if (!cap.open(cfg.capture_path)) {
+            return 1;
+        }
+        total = cfg.count ? std::min(cfg.count, cap.num_frames()) : cap.num_frames();
+        cap.next(frame);
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, cfg.socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || !set_nonblocking(fd)) {
+        std::perror("loadgen: connect to server failed");
+        return 1;
+    }
+
+    FlowGen gen(cfg);
+    std::unordered_map<uint64_t, InFlight> in_flight;
+    std::unordered_map<uint32_t, std::vector<uint64_t>> live; // resting exch ids per instrument
+    in_flight.reserve(1024);
+    std::vector<uint8_t> out;
+    size_t out_head = 0;
+    std::vector<uint8_t> in;
+    uint8_t rbuf[64 * 1024];
+
+    LatencyHistogram rtt;            // from the intended send time
+    LatencyHistogram rtt_uncorrected; // from when the message was actually written
+    // rtt_uncorrected split by the ACK's engine timestamps (same host, same
+    // steady clock): client write -> engine recv -> engine ack -> client read
+    LatencyHistogram wire_in, engine_time, wire_out;
+    uint64_t acked = 0, rejected = 0;
+    uint64_t sent = 0;
+    uint64_t last_send_ns = 0, last_ack_ns = 0;
+    bool failed = false;
+
+    const uint64_t start = now_ns() + 1'000'000; // first message 1ms out
+    const double interval_ns = 1e9 / cfg.rate;
+    const bool file_timing = from_capture && !cfg.rate_set;
+    // only ever asked for the next message, i.e. the frame read ahead
+    auto intended = [&](uint64_t i) {
+        return file_timing ? start + frame.hdr.ts_ns : start + static_cast<uint64_t>(double(i) * interval_ns);
+    };
+    uint64_t last_intended = start;
+
+    for (;;) {
+        uint64_t now = now_ns();
+        // catch up with the schedule: if we fell behind, the backlog goes out
+        // now and its latency still counts from when it should have been sent
+        while (sent < total && intended(sent) <= now) {
+            InFlight f{};
+            f.intended_ns = intended(sent);
+            uint64_t cid = sent + 1;
+            if (from_capture) {
+                cid = append_captured(frame, out);
+                cap.next(frame);
+            } else {
+                f = gen.next(cid, live, out);
+                f.intended_ns = intended(sent);
+            }
+            f.sent_ns = now;
+            last_intended = f.intended_ns;
+            in_flight.emplace(cid, f);
+            ++sent;
+            last_send_ns = now;
+        }
+        if (!flush_out(fd, out, out_head)) {
+            std::cerr << "loadgen: write failed: " << std::strerror(errno) << "\n";
+            failed = true;
+            break;
+        }
+
+        bool closed = false;
+        for (;;) {
+            ssize_t n = ::read(fd, rbuf, sizeof(rbuf));
+            if (n == 0) {
+                closed = true;
+                break;
+            }
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                closed = errno != EAGAIN && errno != EWOULDBLOCK;
+                break;
+            }
+            in.insert(in.end(), rbuf, rbuf + n);
+        }
+        const uint64_t recv_ns = now_ns();
+        size_t off = 0;
+        while (in.size() - off >= sizeof(Header)) {
+            Header h = codec::decode<Header>(in.data() + off, sizeof(Header));
+            if (h.size < sizeof(Header) || in.size() - off < h.size) {
+                break;
+            }
+            if (static_cast<MsgType>(h.type) == MsgType::ACK) {
+                auto ack = codec::decode_body<AckBody>(std::span<const uint8_t>(in.data() + off + sizeof(Header),
+                                                                                 h.size - sizeof(Header)));
+                auto it = in_flight.find(ack.client_order_id);
+                if (it != in_flight.end()) {
+                    rtt.record(recv_ns - it->second.intended_ns);
+                    rtt_uncorrected.record(recv_ns - it->second.sent_ns);
+                    if (it->second.sent_ns <= ack.ts_engine_recv_ns && ack.ts_engine_recv_ns <= ack.ts_engine_ack_ns &&
+                        ack.ts_engine_ack_ns <= recv_ns) {
+                        wire_in.record(ack.ts_engine_recv_ns - it->second.sent_ns);
+                        engine_time.record(ack.ts_engine_ack_ns - ack.ts_engine_recv_ns);
+                        wire_out.record(recv_ns - ack.ts_engine_ack_ns);
+                    }
+                    if (ack.status != 0) {
+                        ++rejected;
+                    } else if (it->second.rests) {
+                        live[it->second.instrument_id].push_back(ack.exch_order_id);
+                    }
+                    in_flight.erase(it);
+                    ++acked;
+                    last_ack_ns = recv_ns;
+                }
+            }
+            off += h.size;
+        }
+        in.erase(in.begin(), in.begin() + static_cast<std::ptrdiff_t>(off));
+
+        if (closed) {
+            std::cerr << "loadgen: server closed the session\n";
+            break;
+        }
+        if (sent == total && in_flight.empty()) {
+            break;
+        }
+        now = now_ns();
+        if (sent == total && now > last_intended + static_cast<uint64_t>(cfg.drain_s * 1e9)) {
+            break;
+        }
+
+        // sleep until the next scheduled send (0 = spin when it is under 1ms away)
+        int timeout_ms = 1;
+        if (sent < total) {
+            const uint64_t due = intended(sent);
+            timeout_ms = due > now ? int((due - now) / 1'000'000) : 0;
+        }
+        pollfd pfd{fd, short(POLLIN | (out.empty() ? 0 : POLLOUT)), 0};
+        ::poll(&pfd, 1, timeout_ms);
+    }
+    ::close(fd);
+
+    const uint64_t lost = in_flight.size();
+    const double send_s = last_send_ns > start ? double(last_send_ns - start) / 1e9 : 0.0;
+    const double ack_s = last_ack_ns > start ? double(last_ack_ns - start) / 1e9 : 0.0;
+    const double send_rate = send_s > 0 ? double(sent) / send_s : 0.0;
+    const double ack_rate = ack_s > 0 ? double(acked) / ack_s : 0.0;
+
+    if (cfg.json) {
+        std::cout << "{\"benchmark\":\"loadgen\",\"target_rate\":" << (file_timing ? 0.0 : cfg.rate) << ",\"sent\":" << sent
+                  << ",\"acked\":" << acked << ",\"rejected\":" << rejected << ",\"lost\":" << lost
+                  << ",\"send_rate\":" << send_rate << ",\"ack_rate\":" << ack_rate << ",";
+        json_pcts("rtt_ns", rtt);
+        std::cout << ",";
+        json_pcts("rtt_uncorrected_ns", rtt_uncorrected);
+        std::cout << ",\"breakdown_ns\":{";
+        json_pcts("wire_in", wire_in);
+        std::cout << ",";
+        json_pcts("engine", engine_time);
+        std::cout << ",";
+        json_pcts("wire_out", wire_out);
+        std::cout << "}}\n";
+    } else {
+        std::cout << "loadgen: sent=" << sent << " acked=" << acked << " rejected=" << rejected
+                  << " lost=" << lost << "\n";
+        if (file_timing) {
+            std::cout << "loadgen: paced by capture timestamps, achieved send " << send_rate;
+        } else {
+            std::cout << "loadgen: target " << cfg.rate << " msg/s, achieved send " << send_rate;
+        }
+        std::cout << " msg/s, ack " << ack_rate << " msg/s\n";
+        print_pcts("rtt from intended send", rtt);
+        print_pcts("rtt from actual send  ", rtt_uncorrected);
+        print_pcts("  wire in (to engine) ", wire_in);
+        print_pcts("  engine              ", engine_time);
+        print_pcts("  wire out (to client)", wire_out);
+    }
+    return failed || lost > 0 ? 1 : 0;
+}
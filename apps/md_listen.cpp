@@ -0,0 +1,309 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "wire.hpp"
+#include "codec.hpp"
+#include "consumer_book.hpp"
+#include "md_publisher.hpp"
+
+// Market-data subscriber: prints the UDP feed and repairs gaps through the
+// server's retransmit service. With --book it joins mid-session from a
+// snapshot and maintains that instrument's book.
+
+static bool read_exact(int fd, void *buf, size_t n) {
+    uint8_t* p = static_cast<uint8_t*>(buf);
+    size_t done = 0;
+    while (done < n) {
+        ssize_t read_bytes = ::read(fd, p + done, n - done);
+        if (read_bytes == 0) {
+            return false; // peer closed
+        }
+        if (read_bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        done += size_t(read_bytes);
+    }
+    return true;
+}
+
+static void print_frame(const Header& h, std::span<const uint8_t> body, const char* tag) {
+    switch (static_cast<MsgType>(h.type)) {
+        case MsgType::TRADE: {
+            auto t = codec::decode_body<TradeBody>(body);
+            std::cout << tag << "seq=" << h.seqno << " TRADE instr=" << t.instrument_id
+                      << " px=" << t.price_ticks << " qty=" << t.qty
+                      << " maker=" << t.resting_exch_order_id << " taker=" << t.taking_exch_order_id << "\n";
+            break;
+        }
+        case MsgType::BOOK_UPDATE: {
+            auto u = codec::decode_body<LevelUpdateBody>(body);
+            std::cout << tag << "seq=" << h.seqno << " LEVEL instr=" << u.instrument_id
+                      << " side=" << (u.side == 0 ? "B" : "A") << " px=" << u.price_ticks
+                      << " qty=" << u.total_qty << " orders=" << u.order_count
+                      << " action=" << int(u.action) << "\n";
+            break;
+        }
+        case MsgType::BBO: {
+            auto q = codec::decode_body<BboBody>(body);
+            std::cout << tag << "seq=" << h.seqno << " BBO instr=" << q.instrument_id
+                      << " bid=" << q.bid_total_qty << "@" << q.bid_price_ticks << " (" << q.bid_order_count << ")"
+                      << " ask=" << q.ask_total_qty << "@" << q.ask_price_ticks << " (" << q.ask_order_count << ")\n";
+            break;
+        }
+        case MsgType::BAR: {
+            auto b = codec::decode_body<BarBody>(body);
+            std::cout << tag << "seq=" << h.seqno << " BAR instr=" << b.instrument_id
+                      << " start=" << b.start_ns << " interval_ms=" << b.interval_ns / 1'000'000
+                      << " o=" << b.open_ticks << " h=" << b.high_ticks << " l=" << b.low_ticks
+                      << " c=" << b.close_ticks << " vol=" << b.volume << " trades=" << b.trade_count
+                      << " vwap=" << (b.volume ? double(b.notional) / double(b.volume) : 0.0) << "\n";
+            break;
+        }
+        default:
+            std::cout << tag << "seq=" << h.seqno << " type=" << int(h.type) << "\n";
+            break;
+    }
+}
+
+// Fetch [begin, end) from the retransmit server; returns the next seqno still missing.
+static uint64_t fill_gap(int fd, uint64_t begin, uint64_t end, SnapshotSync* sync) {
+    while (begin < end) {
+        RetransRequestBody req{};
+        req.begin_seqno = begin;
+        req.count = static_cast<uint32_t>(end - begin);
+        Header h = codec::make_header(MsgType::RETRANS_REQUEST, sizeof(req), 0, 0);
+        auto bytes = codec::pack(h, req);
+        if (::write(fd, bytes.data(), bytes.size()) != ssize_t(bytes.size())) {
+            return begin;
+        }
+        uint8_t rbuf[sizeof(Header) + sizeof(RetransResponseBody)];
+        if (!read_exact(fd, rbuf, sizeof(rbuf))) {
+            return begin;
+        }
+        auto resp = codec::decode_expected<RetransResponseBody>(std::span<const uint8_t>(rbuf, sizeof(rbuf)),
+                                                                MsgType::RETRANS_RESPONSE);
+        if (resp.begin_seqno != begin) {
+            std::cerr << "md_listen: frames " << begin << ".." << resp.begin_seqno - 1 << " are gone\n";
+        }
+        for (uint32_t i = 0; i < resp.count; ++i) {
+            Header fh{};
+            uint8_t fbody[kMdMaxFrame];
+            if (!read_exact(fd, &fh, sizeof(fh)) || fh.size < sizeof(Header) || fh.size > kMdMaxFrame ||
+                !read_exact(fd, fbody, fh.size - sizeof(Header))) {
+                return begin;
+            }
+            std::span<const uint8_t> body(fbody, fh.size - sizeof(Header));
+            print_frame(fh, body, "[retrans] ");
+            if (sync) {
+                sync->on_frame(fh, body);
+            }
+        }
+        if (resp.count == 0) {
+            return begin;
+        }
+        begin = resp.begin_seqno + resp.count;
+    }
+    return begin;
+}
+
+// Ask the retransmit server for a snapshot and read it back (blocking).
+static bool fetch_snapshot(int fd, uint32_t instrument_id, BookSnapshot& out) {
+    SnapshotRequestBody req{};
+    req.instrument_id = instrument_id;
+    Header h = codec::make_header(MsgType::SNAPSHOT_REQUEST, sizeof(req), 0, 0);
+    auto bytes = codec::pack(h, req);
+    if (::write(fd, bytes.data(), bytes.size()) != ssize_t(bytes.size())) {
+        return false;
+    }
+    uint8_t sbuf[sizeof(Header) + sizeof(SnapshotBody)];
+    if (!read_exact(fd, sbuf, sizeof(sbuf))) {
+        return false;
+    }
+    auto body = codec::decode_expected<SnapshotBody>(std::span<const uint8_t>(sbuf, sizeof(sbuf)), MsgType::SNAPSHOT);
+    out.md_seqno = body.md_seqno;
+    out.instrument_id = body.instrument_id;
+    out.found = body.status == 0;
+    out.levels.resize(body.num_levels);
+    for (LevelUpdateBody& u : out.levels) {
+        uint8_t lbuf[sizeof(Header) + sizeof(LevelUpdateBody)];
+        if (!read_exact(fd, lbuf, sizeof(lbuf))) {
+            return false;
+        }
+        u = codec::decode_expected<LevelUpdateBody>(std::span<const uint8_t>(lbuf, sizeof(lbuf)), MsgType::BOOK_UPDATE);
+    }
+    return out.found;
+}
+
+static void print_bbo(const SnapshotSync& sync) {
+    int64_t px;
+    SnapshotSync::Level l;
+    std::cout << "  book:";
+    if (sync.best_bid(px, l)) std::cout << " bid " << l.total_qty << "@" << px << " (" << l.order_count << ")";
+    if (sync.best_ask(px, l)) std::cout << " ask " << l.total_qty << "@" << px << " (" << l.order_count << ")";
+    std::cout << "\n";
+}
+
+static int connect_retrans(const std::string& unix_path, int tcp_port) {
+    if (!unix_path.empty()) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, unix_path.c_str(), sizeof(addr.sun_path) - 1);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            return fd;
+        }
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    if (tcp_port > 0) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(tcp_port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            return fd;
+        }
+        if (fd >= 0) ::close(fd);
+    }
+    return -1;
+}
+
+int main(int argc, char** argv) {
+    sockaddr_in listen_addr{};
+    bool have_udp = false;
+    std::string retrans_unix;
+    int retrans_tcp = 0;
+    uint64_t max_frames = 0; // 0 = run forever
+    uint32_t book_instrument = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--udp" && i + 1 < argc) {
+            have_udp = parse_udp_endpoint(argv[++i], listen_addr);
+        } else if (arg == "--retrans-unix" && i + 1 < argc) {
+            retrans_unix = argv[++i];
+        } else if (arg == "--retrans-tcp" && i + 1 < argc) {
+            retrans_tcp = std::atoi(argv[++i]);
+        } else if (arg == "--book" && i + 1 < argc) {
+            book_instrument = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--count" && i + 1 < argc) {
+            max_frames = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            have_udp = false;
+            break;
+        }
+    }
+    if (!have_udp) {
+        std::cerr << "usage: " << argv[0] << " --udp ip:port [--retrans-unix path | --retrans-tcp port] [--book instrument] [--count N]\n";
+        return 2;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    const bool mcast = IN_MULTICAST(ntohl(listen_addr.sin_addr.s_addr));
+    sockaddr_in bind_addr = listen_addr;
+    if (mcast) {
+        bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    }
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&bind_addr), sizeof(bind_addr)) < 0) {
+        std::perror("md_listen: bind");
+        return 1;
+    }
+    if (mcast) {
+        ip_mreq mreq{};
+        mreq.imr_multiaddr = listen_addr.sin_addr;
+        mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+        if (::setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            std::perror("md_listen: join multicast group");
+            return 1;
+        }
+    }
+    std::cout << "md_listen: subscribed\n";
+
+    int retrans_fd = -1;
+    uint64_t expected = 1;
+    uint64_t seen = 0;
+    std::unique_ptr<SnapshotSync> sync;
+    if (book_instrument != 0) {
+        sync = std::make_unique<SnapshotSync>(book_instrument);
+        expected = 0; // join wherever the stream is; the snapshot covers history
+    }
+    uint8_t dgram[kMdMaxDatagram];
+    while (max_frames == 0 || seen < max_frames) {
+        ssize_t n = ::recv(fd, dgram, sizeof(dgram), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::perror("md_listen: recv");
+            break;
+        }
+        size_t off = 0;
+        while (off + sizeof(Header) <= size_t(n)) {
+            Header h = codec::decode<Header>(dgram + off, size_t(n) - off);
+            if (h.size < sizeof(Header) || off + h.size > size_t(n)) {
+                std::cerr << "md_listen: malformed datagram\n";
+                break;
+            }
+            if (expected == 0) {
+                expected = h.seqno;
+            }
+            if (h.seqno > expected) {
+                std::cerr << "md_listen: gap " << expected << ".." << h.seqno - 1 << "\n";
+                if (retrans_fd < 0) {
+                    retrans_fd = connect_retrans(retrans_unix, retrans_tcp);
+                }
+                if (retrans_fd >= 0) {
+                    fill_gap(retrans_fd, expected, h.seqno, sync.get());
+                }
+                seen += h.seqno - expected;
+                expected = h.seqno;
+            }
+            if (h.seqno == expected) {
+                std::span<const uint8_t> body(dgram + off + sizeof(Header), h.size - sizeof(Header));
+                print_frame(h, body, "");
+                if (sync) {
+                    sync->on_frame(h, body);
+                }
+                ++expected;
+                ++seen;
+            }
+            off += h.size;
+        }
+
+        if (sync && sync->state() == SnapshotSync::State::Buffering) {
+            // first frames are buffered; the snapshot is taken after them, so it bridges
+            if (retrans_fd < 0) {
+                retrans_fd = connect_retrans(retrans_unix, retrans_tcp);
+            }
+            BookSnapshot snap;
+            if (retrans_fd < 0 || !fetch_snapshot(retrans_fd, book_instrument, snap) || !sync->apply_snapshot(snap)) {
+                std::cerr << "md_listen: could not sync instrument " << book_instrument << " from a snapshot\n";
+                break;
+            }
+            std::cout << "md_listen: synced from snapshot at seq=" << snap.md_seqno
+                      << " levels=" << snap.levels.size() << "\n";
+        }
+        if (sync) {
+            print_bbo(*sync);
+        }
+    }
+
+    if (retrans_fd >= 0) ::close(retrans_fd);
+    ::close(fd);
+    return 0;
+}
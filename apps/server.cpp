@@ -1,65 +1,445 @@
+#include <poll.h>
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
+#include <csignal>
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <algorithm>
 #include <cstdint>
 #include <chrono>
 #include <vector>
+#include <memory>
 #include <span>
+#include <string>
 
 #include "wire.hpp"
+#include "arena.hpp"
+#include "bar_aggregator.hpp"
+#include "clock.hpp"
 #include "codec.hpp"
 #include "engine.hpp"
+#include "md_publisher.hpp"
+#include "metrics.hpp"
+#include "session_queue.hpp"
+#include "stage_latency.hpp"
 
 static const char* kSockPath = "/tmp/demo.sock";
+static constexpr uint32_t kMaxBarInstruments = 256; // bars are kept for instrument ids below this, or every listed one
+static bool g_log_messages = true; // --quiet turns off the per-message log
+static volatile std::sig_atomic_t g_dump_requested = 0; // SIGUSR1: print counters and stage latencies
 
-static uint64_t now_ns() noexcept {
-    using namespace std::chrono;
-    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+// TSC-backed where available; same time base as the engine's ACK stamps
+using clk::now_ns;
+
+// One connected order-entry client. Sockets are non-blocking: input is
+// buffered until a whole frame is present, output goes through a bounded queue.
+struct Session {
+    int fd;
+    uint32_t id;
+    std::vector<uint8_t> in;
+    SessionOutQueue out;
+    bool closing = false;
+};
+
+struct ServerCounters {
+    uint64_t conflated = 0;
+    uint64_t dropped = 0;
+    uint64_t slow_disconnects = 0;
+};
+
+static bool set_nonblocking(int fd) {
+    int fl = ::fcntl(fd, F_GETFL, 0);
+    return fl >= 0 && ::fcntl(fd, F_SETFL, fl | O_NONBLOCK) == 0;
+}
+
+template <typename BodyT>
+static void queue_reliable(Session& s, MsgType type, const BodyT& body) {
+    Header h = codec::make_header(type, sizeof(BodyT), 0, now_ns());
+    uint8_t frame[sizeof(Header) + sizeof(BodyT)];
+    std::memcpy(frame, &h, sizeof(Header));
+    std::memcpy(frame + sizeof(Header), &body, sizeof(BodyT));
+    s.out.push_reliable(frame, sizeof(frame));
 }
 
-static bool read_exact(int fd, void *buf, size_t n) {
-    uint8_t* p = static_cast<uint8_t*>(buf);
-    size_t done = 0;
-    while (done < n) {
-        ssize_t read_bytes = ::read(fd, p + done, n - done);
-        if (read_bytes == 0) {
+// ACK stamped -> queued, and the whole request from its first byte.
+static void record_reply(LatencyStage total, uint64_t frame_ns, uint64_t ack_ns) {
+    const uint64_t queued_ns = latency::stamp();
+    latency::record(LatencyStage::Encode, ack_ns, queued_ns);
+    latency::record(total, frame_ns, queued_ns);
+}
+
+// Reads whatever is available. Returns false once the peer has closed or errored.
+static bool read_available(Session& s) {
+    uint8_t buf[64 * 1024];
+    for (;;) {
+        ssize_t n = ::read(s.fd, buf, sizeof(buf));
+        if (n == 0) {
             return false; // peer closed
         }
-        if (read_bytes < 0) {
+        if (n < 0) {
             if (errno == EINTR) {
                 continue;
             }
-            return false;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        s.in.insert(s.in.end(), buf, buf + n);
+        metrics::count(Metric::BytesIn, uint64_t(n));
+        if (size_t(n) < sizeof(buf)) {
+            return true;
         }
-        // casting from signed to unsigned
-        done += size_t(read_bytes);
     }
-    return true;
 }
 
-static bool write_all(int fd, const void *buf, size_t n) {
-    const uint8_t* p = static_cast<const uint8_t*>(buf);
-    while (n > 0) {
-        ssize_t written_bytes = ::write(fd, p, n);
-        if (written_bytes == 0) {
-            return false; // peer closed
+// Snapshot requests arrive on the publisher thread; the engine thread only
+// copies the level aggregates and hands them back.
+static void serve_snapshots(const Engine& engine, MdPublisher& md) {
+    SnapshotRequest req;
+    while (md.next_snapshot_request(req)) {
+        auto snap = std::make_unique<BookSnapshot>();
+        engine.snapshot(req.instrument_id, md.last_seqno(), *snap);
+        md.deliver_snapshot(req, std::move(snap));
+    }
+}
+
+// End of a batch: one BBO per instrument whose top of book changed, on the
+// market-data feed and (conflated per instrument) on sessions that asked for it.
+static void publish_bbos(std::vector<std::unique_ptr<Session>>& sessions, Engine& engine, MdPublisher& md,
+                         bool session_bbo, std::vector<BboBody>& bbos) {
+    bbos.clear();
+    engine.flush_bbo(bbos);
+    const uint64_t ts = now_ns();
+    for (const BboBody& bbo : bbos) {
+        md.publish(MsgType::BBO, bbo, ts);
+        if (!session_bbo) {
+            continue;
         }
-        if (written_bytes < 0) {
-            if (errno == EINTR) {
-                continue;
+        Header h = codec::make_header(MsgType::BBO, sizeof(BboBody), 0, ts);
+        uint8_t frame[sizeof(Header) + sizeof(BboBody)];
+        std::memcpy(frame, &h, sizeof(Header));
+        std::memcpy(frame + sizeof(Header), &bbo, sizeof(BboBody));
+        for (auto& s : sessions) {
+            if (!s->closing) {
+                s->out.push_conflatable(bbo.instrument_id, frame, sizeof(frame));
             }
-            return false;
         }
-        p += size_t(written_bytes);
-        n -= size_t(written_bytes);
     }
-    return true;
 }
 
-int main() {
+// Closes the bars whose interval is over and publishes everything completed
+// since the last pass on the market-data feed.
+static void publish_bars(BarAggregator& bars, MdPublisher& md) {
+    const uint64_t ts = now_ns();
+    bars.close_expired(clk::to_wall_ns(ts)); // bars run on wall time, see BarBody
+    BarBody bar;
+    while (bars.try_pop(bar)) {
+        md.publish(MsgType::BAR, bar, ts);
+    }
+}
+
+// Pulls the GTT and DAY orders that are due; their levels go out in bulk.
+static void expire_orders(Engine& engine, MdPublisher& md) {
+    const EngineResult res = engine.expire(now_ns());
+    if (res.ack.cancelled_count == 0) {
+        return;
+    }
+    const uint64_t md_ts = now_ns();
+    for (const auto& level : res.levels) {
+        md.publish(MsgType::BOOK_UPDATE, level, md_ts);
+    }
+    std::cout << "server: " << res.ack.cancelled_count << " orders expired\n";
+}
+
+// Ends the opening auction: every instrument uncrosses at its own price.
+static void uncross_all(Engine& engine, MdPublisher& md, BarAggregator* bars) {
+    size_t trades = 0;
+    int64_t volume = 0;
+    for (uint32_t id = 1; id <= engine.num_instruments(); ++id) {
+        const EngineResult res = engine.uncross(id);
+        const uint64_t md_ts = now_ns();
+        for (const auto& trade : res.trades) {
+            md.publish(MsgType::TRADE, trade, md_ts);
+            volume += trade.qty;
+        }
+        if (bars) {
+            bars->on_trades(res.trades, clk::to_wall_ns(md_ts));
+        }
+        for (const auto& level : res.levels) {
+            md.publish(MsgType::BOOK_UPDATE, level, md_ts);
+        }
+        trades += res.trades.size();
+    }
+    std::cout << "server: opening auction uncrossed, " << trades << " trades, volume " << volume << "\n";
+}
+
+// Runs one complete frame from a session through the engine.
+static void handle_frame(Session& session, const Header& h, std::span<const uint8_t> body,
+                             Engine& engine, MdPublisher& md, BarAggregator* bars) {
+    const uint64_t frame_ns = latency::stamp();
+    if (g_log_messages) {
+        std::cout << "got header type=" << int(h.type)
+                  << " ver=" << int(h.version)
+                  << " size=" << h.size << "\n";
+    }
+
+    switch (static_cast<MsgType>(h.type)) {
+        case MsgType::NEW:
+            metrics::count(Metric::MsgsNew);
+            try {
+                auto m = codec::decode_body<OrderNewBody>(body);
+                latency::record(LatencyStage::Decode, frame_ns, latency::stamp());
+                if (g_log_messages) {
+                    std::cout << "NEW: cid=" << m.client_order_id
+                            << " side=" << int(m.side)
+                            << " qty=" << m.qty
+                            << " px=" << m.price_ticks
+                            << " instr=" << m.instrument_id
+                            << " flags=0x" << std::hex << int(m.flags) << std::dec << "\n";
+                }
+                bool rest_leftover = ((m.flags & TIF_IOC) == 0); // TODO: properly manage flags
+                EngineResult res = engine.on_new(m, rest_leftover, session.id);
+                queue_reliable(session, MsgType::ACK, res.ack);
+                record_reply(LatencyStage::NewTotal, frame_ns, res.ack.ts_engine_ack_ns);
+
+                // market data goes out through the publisher thread, sequenced there
+                const uint64_t md_ts = now_ns();
+                for (const auto& trade : res.trades) {
+                    md.publish(MsgType::TRADE, trade, md_ts);
+                }
+                if (bars) {
+                    bars->on_trades(res.trades, clk::to_wall_ns(md_ts));
+                }
+                for (const auto& level : res.levels) {
+                    md.publish(MsgType::BOOK_UPDATE, level, md_ts);
+                }
+
+            } catch (const std::exception& e) {
+                std::cerr << "decode NEW failed: " << e.what() << "\n";
+            }
+            break;
+        case MsgType::CANCEL:
+            metrics::count(Metric::MsgsCancel);
+            try {
+                auto m = codec::decode_body<OrderCancelBody>(body);
+                latency::record(LatencyStage::Decode, frame_ns, latency::stamp());
+                if (g_log_messages) {
+                    std::cout << "CANCEL: cid=" << m.client_order_id << "\n";
+                }
+
+                EngineResult res = engine.on_cancel(m, session.id);
+                queue_reliable(session, MsgType::ACK, res.ack);
+                record_reply(LatencyStage::CancelTotal, frame_ns, res.ack.ts_engine_ack_ns);
+                for (const auto& level : res.levels) {
+                    md.publish(MsgType::BOOK_UPDATE, level, now_ns());
+                }
+
+            } catch (const std::exception& e) {
+                std::cerr << "decode CANCEL failed: " << e.what() << "\n";
+            }
+            break;
+        case MsgType::MASS_CANCEL:
+            metrics::count(Metric::MsgsMassCancel);
+            try {
+                auto m = codec::decode_body<MassCancelBody>(body);
+                latency::record(LatencyStage::Decode, frame_ns, latency::stamp());
+                // a session can only pull its own orders
+                EngineResult res = engine.on_mass_cancel(m, session.id);
+                if (g_log_messages) {
+                    std::cout << "MASS_CANCEL: cid=" << m.client_order_id << " instr=" << m.instrument_id
+                              << " side=" << int(m.side) << " cancelled=" << res.ack.cancelled_count << "\n";
+                }
+                queue_reliable(session, MsgType::ACK, res.ack);
+                record_reply(LatencyStage::MassCancelTotal, frame_ns, res.ack.ts_engine_ack_ns);
+                const uint64_t md_ts = now_ns();
+                for (const auto& level : res.levels) {
+                    md.publish(MsgType::BOOK_UPDATE, level, md_ts);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "decode MASS_CANCEL failed: " << e.what() << "\n";
+            }
+            break;
+        case MsgType::STATS_REQUEST:
+            metrics::count(Metric::MsgsStatsRequest);
+            try {
+                auto m = codec::decode_body<StatsRequestBody>(body);
+                latency::record(LatencyStage::Decode, frame_ns, latency::stamp());
+                // read after counting this request, so the reply includes it
+                StatsBody stats = metrics::stats_body(m.request_id, now_ns());
+                const std::vector<LatencyBody> stages = latency::latency_bodies(m.request_id);
+                stats.num_latency = static_cast<uint32_t>(stages.size());
+                queue_reliable(session, MsgType::STATS, stats);
+                for (const LatencyBody& stage : stages) {
+                    queue_reliable(session, MsgType::LATENCY, stage);
+                }
+                latency::record(LatencyStage::StatsTotal, frame_ns, latency::stamp());
+            } catch (const std::exception& e) {
+                std::cerr << "decode STATS_REQUEST failed: " << e.what() << "\n";
+            }
+            break;
+        case MsgType::ACK:
+            metrics::count(Metric::MsgsOther);
+            std::cout << "got header type=ACK" << "\n";
+            break;
+        case MsgType::TRADE:
+            metrics::count(Metric::MsgsOther);
+            std::cout << "got header type=TRADE" << "\n";
+            break;
+        case MsgType::RESERVED:
+            metrics::count(Metric::MsgsOther);
+            std::cout << "got header type=RESERVED" << "\n" << "\n";
+            break;
+        default:
+            metrics::count(Metric::MsgsOther);
+            std::cout << "got header type=UNKNOWN(" << int(h.type) << ")" << "\n";
+            break;
+    }
+}
+
+// Consumes every complete frame in s.in. Returns false on a malformed frame.
+static bool process_input(Session& s, Engine& engine, MdPublisher& md, BarAggregator* bars) {
+    size_t off = 0;
+    bool ok = true;
+    while (s.in.size() - off >= sizeof(Header)) {
+        Header h = codec::decode<Header>(s.in.data() + off, sizeof(Header));
+        if (h.size < sizeof(Header) || h.size - sizeof(Header) > kMaxFrame) {
+            std::cerr << "server: bad frame size\n";
+            ok = false;
+            break;
+        }
+        if (s.in.size() - off < h.size) {
+            break; // rest of the frame hasn't arrived yet
+        }
+        std::span<const uint8_t> body(s.in.data() + off + sizeof(Header), h.size - sizeof(Header));
+        handle_frame(s, h, body, engine, md, bars);
+        off += h.size;
+    }
+    s.in.erase(s.in.begin(), s.in.begin() + static_cast<std::ptrdiff_t>(off));
+    return ok;
+}
+
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " [--md-udp ip:port]... [--retrans-unix path] [--retrans-tcp port]\n"
+              << "          [--session-bbo] [--out-watermark bytes] [--out-cap bytes] [--bars ms,...]\n"
+              << "          [--universe file] [--opening-auction ms] [--day-length ms] [--stats-interval ms]\n"
+              << "          [--arena pages] [--serve-forever] [--quiet]\n"
+              << "  --md-udp        market-data destination (unicast or loopback multicast group), repeatable\n"
+              << "  --retrans-unix  serve market-data gap fills on this UNIX stream socket\n"
+              << "  --retrans-tcp   serve market-data gap fills on 127.0.0.1:port\n"
+              << "  --session-bbo   also send top-of-book updates on order-entry sessions (conflated)\n"
+              << "  --out-watermark per-session backlog above which top-of-book updates are conflated\n"
+              << "  --out-cap       per-session backlog limit; sessions above it for 1s are disconnected\n"
+              << "  --bars          publish OHLCV/VWAP bars of these intervals (ms), e.g. 1000,60000,\n"
+              << "                  aligned to wall-clock (UTC) interval boundaries\n"
+              << "  --universe      instruments to list, with sizing hints (default: AAPL, MSFT, META)\n"
+              << "  --opening-auction collect orders without matching for this long after startup, then uncross\n"
+              << "  --day-length    accept DAY orders; they expire this long after startup\n"
+              << "  --stats-interval print every counter and stage latency (also served by STATS_REQUEST,\n"
+              << "                  and on SIGUSR1) this often\n"
+              << "  --arena         books in a huge-page arena on this thread's NUMA node; pages:\n"
+              << "                  auto, explicit (hugetlbfs), transparent or normal (falls back in that order)\n"
+              << "  --serve-forever keep running after the last session disconnects\n"
+              << "  --quiet         don't log every message (for load tests)\n";
+}
+
+int main(int argc, char** argv) {
+    MdPublisherConfig md_cfg;
+    OutQueueConfig out_cfg;
+    bool session_bbo = false;
+    bool serve_forever = false;
+    std::vector<uint64_t> bar_intervals_ns;
+    std::string universe_path;
+    uint64_t auction_ms = 0;
+    uint64_t day_ms = 0;
+    uint64_t stats_interval_ns = 0;
+    bool use_arena = false;
+    ArenaConfig arena_cfg;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--md-udp" && i + 1 < argc) {
+            sockaddr_in dst{};
+            if (!parse_udp_endpoint(argv[++i], dst)) {
+                std::cerr << "server: bad --md-udp endpoint " << argv[i] << "\n";
+                return 2;
+            }
+            md_cfg.udp_destinations.push_back(dst);
+        } else if (arg == "--retrans-unix" && i + 1 < argc) {
+            md_cfg.retrans_unix_path = argv[++i];
+        } else if (arg == "--retrans-tcp" && i + 1 < argc) {
+            md_cfg.retrans_tcp_port = std::atoi(argv[++i]);
+        } else if (arg == "--session-bbo") {
+            session_bbo = true;
+        } else if (arg == "--out-watermark" && i + 1 < argc) {
+            out_cfg.watermark = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--out-cap" && i + 1 < argc) {
+            out_cfg.cap = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--bars" && i + 1 < argc) {
+            const std::string list = argv[++i];
+            size_t pos = 0;
+            while (pos <= list.size()) {
+                size_t end = list.find(',', pos);
+                if (end == std::string::npos) end = list.size();
+                const uint64_t ms = std::strtoull(list.substr(pos, end - pos).c_str(), nullptr, 10);
+                if (ms == 0) {
+                    usage(argv[0]);
+                    return 2;
+                }
+                bar_intervals_ns.push_back(ms * 1'000'000);
+                pos = end + 1;
+            }
+        } else if (arg == "--universe" && i + 1 < argc) {
+            universe_path = argv[++i];
+        } else if (arg == "--opening-auction" && i + 1 < argc) {
+            auction_ms = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--day-length" && i + 1 < argc) {
+            day_ms = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--stats-interval" && i + 1 < argc) {
+            stats_interval_ns = std::strtoull(argv[++i], nullptr, 10) * 1'000'000;
+        } else if (arg == "--arena" && i + 1 < argc) {
+            if (!parse_arena_pages(argv[++i], arena_cfg.pages)) {
+                usage(argv[0]);
+                return 2;
+            }
+            use_arena = true;
+        } else if (arg == "--serve-forever") {
+            serve_forever = true;
+        } else if (arg == "--quiet") {
+            g_log_messages = false;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGUSR1, [](int) { g_dump_requested = 1; });
+
+    // listed before any socket is opened: books are presized off the hot path
+    std::vector<InstrumentSpec> universe;
+    const auto load_start = std::chrono::steady_clock::now();
+    if (!universe_path.empty() && !load_universe(universe_path, universe)) {
+        return 2;
+    }
+    // built here, on the engine thread, so the arena prefers its NUMA node
+    std::unique_ptr<Arena> arena = use_arena ? std::make_unique<Arena>(arena_cfg) : nullptr;
+    Engine engine = universe.empty() ? Engine(std::move(arena)) : Engine(universe, std::move(arena));
+    if (!universe.empty()) {
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - load_start);
+        std::cout << "server: " << engine.num_instruments() << " instruments listed in " << ms.count() << " ms\n";
+    }
+
+    if (const Arena* a = engine.arena()) {
+        std::cout << "server: books in an arena, " << arena_pages_name(a->backing()) << " pages, "
+                  << (a->node() >= 0 ? "node " + std::to_string(a->node()) : std::string("no NUMA binding")) << "\n";
+    }
+
+    MdPublisher md(std::move(md_cfg));
+    if (!md.start()) {
+        std::cerr << "server: failed to start market-data publisher\n";
+        return 1;
+    }
+
     int srv = ::socket(AF_UNIX, SOCK_STREAM, 0);
     if (srv < 0) {
         std::perror("socket");
@@ -77,7 +457,7 @@ int main() {
         return 1;
     }
 
-    if (::listen(srv, 1) < 0) {
+    if (::listen(srv, 16) < 0 || !set_nonblocking(srv)) {
         std::perror("listen");
         ::close(srv);
         return 1;
@@ -85,109 +465,155 @@ int main() {
 
     std::cout << "server: listening on " << kSockPath << "\n";
 
-    int client_fd;
-    for (;;) {
-        client_fd = ::accept(srv, nullptr, nullptr);
-        if (client_fd >= 0) break;
-        if (errno == EINTR) continue;
-        std::perror("accept"); ::close(srv); return 1;
-    }
-    std::cout << "server: client connected\n";
-    
-    Engine engine;
-    static uint64_t md_seqno = 0;
-    
-    while (true) {
-        Header h{};
-        if (!read_exact(client_fd, &h, sizeof(Header))) {
-            std::cout << "server: client disconnected\n";
-            break;
+    uint64_t auction_end = 0;
+    if (auction_ms > 0) {
+        for (uint32_t id = 1; id <= engine.num_instruments(); ++id) {
+            engine.start_auction(id);
         }
-        
-        std::cout << "got header type=" << int(h.type)
-                  << " ver=" << int(h.version)
-                  << " size=" << h.size << "\n";
-        
-        if (h.size < sizeof(Header) || h.size - sizeof(Header) > kMaxFrame) {
-            std::cerr << "server: bad frame size\n";
-            break;
+        auction_end = now_ns() + auction_ms * 1'000'000;
+        std::cout << "server: opening auction for " << auction_ms << " ms\n";
+    }
+    if (day_ms > 0) {
+        engine.set_day_end(now_ns() + day_ms * 1'000'000);
+        std::cout << "server: DAY orders expire in " << day_ms << " ms\n";
+    }
+
+    std::unique_ptr<BarAggregator> bars;
+    if (!bar_intervals_ns.empty()) {
+        const uint32_t bar_instruments = std::max<uint32_t>(kMaxBarInstruments, uint32_t(engine.num_instruments()) + 1);
+        bars = std::make_unique<BarAggregator>(bar_instruments, bar_intervals_ns);
+    }
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::vector<pollfd> pfds;
+    std::vector<BboBody> bbos;
+    ServerCounters counters;
+    uint32_t next_session_id = 1;
+    bool had_session = false;
+    uint64_t next_stats_dump = stats_interval_ns ? now_ns() + stats_interval_ns : 0;
+
+    while (serve_forever || !had_session || !sessions.empty()) {
+        pfds.clear();
+        pfds.push_back(pollfd{srv, POLLIN, 0});
+        for (const auto& s : sessions) {
+            short ev = POLLIN;
+            if (s->out.has_output()) {
+                ev |= POLLOUT;
+            }
+            pfds.push_back(pollfd{s->fd, ev, 0});
         }
-        
-        const size_t body_len = h.size - sizeof(Header);
-        std::vector<uint8_t> body(body_len);
-        if (!read_exact(client_fd, body.data(), body_len)) {
-            std::cerr << "server: failed to read body\n";
+        // short timeout: snapshot requests from the publisher thread are served between polls
+        if (::poll(pfds.data(), pfds.size(), 1) < 0 && errno != EINTR) {
+            std::perror("poll");
             break;
         }
-        
-        switch (static_cast<MsgType>(h.type)) {
-            case MsgType::NEW:
-                try {
-                    auto m = codec::decode_body<OrderNewBody>(std::span<const uint8_t>(body));
-                    std::cout << "NEW: cid=" << m.client_order_id
-                            << " side=" << int(m.side)
-                            << " qty=" << m.qty
-                            << " px=" << m.price_ticks
-                            << " instr=" << m.instrument_id
-                            << " flags=0x" << std::hex << int(m.flags) << std::dec << "\n";
-                    bool rest_leftover = ((m.flags & TIF_IOC) == 0); // TODO: properly manage flags
-                    EngineResult res = engine.on_new(m, rest_leftover);
-                    Header ack_hdr = codec::make_header(MsgType::ACK, sizeof(AckBody), 0, now_ns());
-                    auto ack_bytes = codec::pack(ack_hdr, res.ack);
-                    if (!write_all(client_fd, ack_bytes.data(), ack_bytes.size())) {
-                        std::cerr << "server: failed to send ACK\n";
-                        goto client_loop_exit;
-                    }
-                    
-                    for (const auto& trade : res.trades) {
-                        Header trade_hdr = codec::make_header(MsgType::TRADE, sizeof(TradeBody), ++md_seqno, now_ns());
-                        auto trade_bytes = codec::pack(trade_hdr, trade);
-                        if (!write_all(client_fd, trade_bytes.data(), trade_bytes.size())) {
-                            std::cerr << "server: failed to send TRADE\n";
-                            goto client_loop_exit;
-                        }
-                    }
-
-                } catch (const std::exception& e) {
-                    std::cerr << "decode NEW failed: " << e.what() << "\n";
+        serve_snapshots(engine, md);
+
+        // requests first, in session order
+        for (size_t i = 0; i < sessions.size(); ++i) {
+            Session& s = *sessions[i];
+            if (pfds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+                const bool open = read_available(s);
+                if (!process_input(s, engine, md, bars.get()) || !open) {
+                    s.closing = true;
                 }
-                break;
-            case MsgType::CANCEL:
-                try {
-                    auto m = codec::decode_body<OrderCancelBody>(std::span<const uint8_t>(body));
-                    std::cout << "CANCEL: cid=" << m.client_order_id << "\n";
-                            
-                    EngineResult res = engine.on_cancel(m);
-                    Header ack_hdr = codec::make_header(MsgType::ACK, sizeof(AckBody), 0, now_ns());
-                    auto ack_bytes = codec::pack(ack_hdr, res.ack);
-                    if (!write_all(client_fd, ack_bytes.data(), ack_bytes.size())) {
-                        std::cerr << "server: failed to send ACK\n";
-                        goto client_loop_exit;
-                    }
-
-                } catch (const std::exception& e) {
-                    std::cerr << "decode CANCEL failed: " << e.what() << "\n";
+            }
+        }
+        if (auction_end != 0 && now_ns() >= auction_end) {
+            uncross_all(engine, md, bars.get());
+            auction_end = 0;
+        }
+        expire_orders(engine, md);
+        // everything read this pass is one batch: at most one quote per instrument
+        publish_bbos(sessions, engine, md, session_bbo, bbos);
+        if (bars) {
+            publish_bars(*bars, md);
+        }
+
+        // then output: never blocks, a slow reader only grows its own queue
+        const uint64_t now = now_ns();
+        for (auto& s : sessions) {
+            if (s->closing) {
+                continue;
+            }
+            const bool had_output = s->out.has_output();
+            const uint64_t write_ns = had_output ? latency::stamp() : 0;
+            const bool flushed = s->out.flush(s->fd);
+            if (had_output) {
+                latency::record(LatencyStage::Write, write_ns, latency::stamp());
+            }
+            if (!flushed) {
+                s->closing = true;
+            } else if (s->out.should_disconnect(now)) {
+                std::cerr << "server: session " << s->id << " over output cap, disconnecting\n";
+                ++counters.slow_disconnects;
+                s->closing = true;
+            }
+        }
+
+        bool pulled_quotes = false;
+        for (size_t i = 0; i < sessions.size();) {
+            Session& s = *sessions[i];
+            if (!s.closing) {
+                ++i;
+                continue;
+            }
+            // cancel-on-disconnect: its quotes must not outlive the session
+            const EngineResult pulled = engine.cancel_session(s.id);
+            const uint64_t md_ts = now_ns();
+            for (const auto& level : pulled.levels) {
+                md.publish(MsgType::BOOK_UPDATE, level, md_ts);
+            }
+            pulled_quotes = pulled_quotes || !pulled.levels.empty();
+            std::cout << "server: client disconnected, " << pulled.ack.cancelled_count << " resting orders cancelled\n";
+            metrics::count(Metric::SessionsClosed);
+            s.out.discard();
+            counters.conflated += s.out.conflated();
+            counters.dropped += s.out.dropped();
+            ::close(s.fd);
+            sessions.erase(sessions.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        if (pulled_quotes) {
+            // the new top of book goes out now, even if that was the last session
+            publish_bbos(sessions, engine, md, session_bbo, bbos);
+        }
+
+        if (g_dump_requested || (next_stats_dump != 0 && now >= next_stats_dump)) {
+            std::cout << "server: stats " << metrics::format(metrics::read()) << "\n"
+                      << latency::format() << std::flush;
+            g_dump_requested = 0;
+            if (next_stats_dump != 0) {
+                next_stats_dump = now + stats_interval_ns;
+            }
+        }
+
+        if (pfds[0].revents & POLLIN) {
+            for (;;) {
+                int fd = ::accept(srv, nullptr, nullptr);
+                if (fd < 0) {
+                    break;
                 }
-                break;
-            case MsgType::ACK:
-                std::cout << "got header type=ACK" << "\n";
-                break;
-            case MsgType::TRADE:
-                std::cout << "got header type=TRADE" << "\n";
-                break;
-            case MsgType::RESERVED:
-                std::cout << "got header type=RESERVED" << "\n" << "\n";
-                break;
-            default:
-                std::cout << "got header type=UNKNOWN(" << int(h.type) << ")" << "\n";
-                break;
-        }
-    }
-    
-client_loop_exit:
+                if (!set_nonblocking(fd)) {
+                    ::close(fd);
+                    continue;
+                }
+                auto s = std::make_unique<Session>(Session{fd, next_session_id++, {}, SessionOutQueue(out_cfg)});
+                sessions.push_back(std::move(s));
+                had_session = true;
+                metrics::count(Metric::SessionsOpened);
+                std::cout << "server: client connected\n";
+            }
+        }
+    }
 
+    for (auto& s : sessions) {
+        ::close(s->fd);
+    }
+    md.stop();
+    std::cout << "server: published " << md.frames_published() << " market-data frames\n";
+    std::cout << "server: top-of-book updates conflated=" << counters.conflated
+              << " dropped=" << counters.dropped
+              << " slow_disconnects=" << counters.slow_disconnects << "\n";
     ::unlink(kSockPath);
-    ::close(client_fd);
     ::close(srv);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,129 @@
+// bench/bench_arena.cpp
+// Cancel and match latency on large books whose nodes come from the heap, an
+// arena on normal pages and an arena on huge pages (arena.hpp). Orders go in
+// at random levels, so a level's queue and the id index are spread over the
+// whole footprint and every operation is a few TLB lookups away from the
+// last one. Cases are tagged arena:0/1 and huge:1 when the arena got huge
+// pages (explicit or transparent). --max-depth 10000000 adds the 10M book.
+#include "bench_harness.hpp"
+#include "arena.hpp"
+#include "order_book.hpp"
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+static constexpr int64_t kMid = 1'000'000;
+static constexpr int32_t kQty = 10;
+static constexpr uint64_t kLevels = 1000;     // per side
+static constexpr uint64_t kOpsPerRep = 1000;
+
+struct Xorshift {
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    uint64_t next() {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x;
+    }
+};
+
+// One book of `depth` resting orders, half per side, with the ids that rest.
+struct BigBook {
+    std::unique_ptr<Arena> arena;
+    std::unique_ptr<OrderBook> book;
+    std::vector<uint64_t> live; // resting ids, any order
+    uint64_t next_id = 1;
+    Xorshift rng;
+
+    BigBook(uint64_t depth, std::optional<ArenaPages> pages) {
+        if (pages) {
+            ArenaConfig cfg;
+            cfg.pages = *pages;
+            arena = std::make_unique<Arena>(cfg);
+        }
+        book = std::make_unique<OrderBook>(1, arena.get());
+        book->reserve(depth);
+        live.reserve(depth);
+        for (uint64_t i = 0; i < depth; ++i) {
+            add(i % 2 ? OrderSide::Ask : OrderSide::Bid);
+        }
+    }
+
+    void add(OrderSide side) {
+        const int64_t offset = 1 + int64_t(rng.next() % kLevels);
+        book->add_resting(next_id, side, side == OrderSide::Bid ? kMid - offset : kMid + offset, kQty);
+        live.push_back(next_id++);
+    }
+};
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    bench::Runner runner("arena", opt);
+    runner.calibrate();
+    const uint64_t depths[] = {100'000, 1'000'000, 10'000'000};
+
+    for (uint64_t depth : depths) {
+        if (depth > opt.max_depth) {
+            break;
+        }
+        for (std::optional<ArenaPages> pages :
+             {std::optional<ArenaPages>{}, std::optional<ArenaPages>{ArenaPages::Normal},
+              std::optional<ArenaPages>{ArenaPages::Auto}}) {
+            BigBook bb(depth, pages);
+            const bool huge = bb.arena && (bb.arena->backing() == ArenaPages::Explicit ||
+                                           bb.arena->backing() == ArenaPages::Transparent);
+            const bench::Params params = {{"depth", depth}, {"arena", bb.arena != nullptr}, {"huge", huge}};
+            std::cerr << "bench: " << depth << " orders, "
+                      << (bb.arena ? std::string("arena, ") + arena_pages_name(bb.arena->backing()) + " pages" : "heap")
+                      << "\n";
+
+            // --- cancel random resting orders; each is replaced (untimed) on the same side
+            runner.run("cancel_random", params, [&] {
+                std::vector<uint64_t> ids(kOpsPerRep);
+                for (uint64_t& id : ids) {
+                    const size_t i = bb.rng.next() % bb.live.size();
+                    id = bb.live[i];
+                    bb.live[i] = bb.live.back();
+                    bb.live.pop_back();
+                }
+                const uint64_t t0 = bench::now_ns();
+                for (uint64_t id : ids) {
+                    bb.book->cancel_order(id);
+                }
+                const uint64_t ns = bench::now_ns() - t0;
+                for (uint64_t id : ids) {
+                    bb.add(id % 2 ? OrderSide::Bid : OrderSide::Ask);
+                }
+                return bench::Sample{ns, kOpsPerRep};
+            });
+
+            // --- bids filling one order each at the best ask; the asks are replaced (untimed)
+            runner.run("match_1", params, [&] {
+                std::vector<TradeBody> trades;
+                trades.reserve(kOpsPerRep);
+                const uint64_t t0 = bench::now_ns();
+                for (uint64_t i = 0; i < kOpsPerRep; ++i) {
+                    bb.book->match_taker(0, OrderSide::Bid, kMid + int64_t(kLevels), kQty, trades, 1, 0);
+                }
+                const uint64_t ns = bench::now_ns() - t0;
+                for (uint64_t i = 0; i < kOpsPerRep; ++i) {
+                    bb.add(OrderSide::Ask);
+                }
+                bench::do_not_optimize(trades.size());
+                return bench::Sample{ns, kOpsPerRep};
+            });
+            if (bb.arena) {
+                runner.report("arena_footprint", params,
+                              {{"mapped_mb", double(bb.arena->mapped_bytes()) / double(1 << 20)},
+                               {"used_mb", double(bb.arena->used_bytes()) / double(1 << 20)},
+                               {"node", double(bb.arena->node())}});
+            }
+        }
+    }
+    runner.finish();
+    return 0;
+}
@@ -0,0 +1,145 @@
+// bench/bench_client_ids.cpp
+// The per-session client order id index (flat_id_map.hpp) against
+// std::unordered_map holding the same ids: a lookup of a live id, a lookup
+// of an absent one (the duplicate check on every NEW) and an erase + insert
+// pair (an order leaving and a new one resting), with 10k to 1M live ids.
+// Ids are random 64-bit values; cases are tagged flat:1 for FlatIdMap. Then
+// the engine: a cancel by client order id against one by exchange id.
+// ns_per_op is per id.
+#include "bench_harness.hpp"
+#include "engine.hpp"
+#include "flat_id_map.hpp"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+static constexpr uint64_t kOps = 1'000'000;
+static constexpr uint32_t kSession = 1;
+
+struct Xorshift {
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    uint64_t next() {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x;
+    }
+};
+
+// The same operations on either map.
+struct Flat {
+    FlatIdMap<uint64_t> m;
+    void insert(uint64_t k, uint64_t v) { m.insert(k, v); }
+    void erase(uint64_t k) { m.erase(k); }
+    const uint64_t* find(uint64_t k) const { return m.find(k); }
+};
+struct Std {
+    std::unordered_map<uint64_t, uint64_t> m;
+    void insert(uint64_t k, uint64_t v) { m.emplace(k, v); }
+    void erase(uint64_t k) { m.erase(k); }
+    const uint64_t* find(uint64_t k) const {
+        const auto it = m.find(k);
+        return it == m.end() ? nullptr : &it->second;
+    }
+};
+
+template <typename Map>
+static void run_map(bench::Runner& runner, bool flat, uint64_t n) {
+    Map map;
+    Xorshift rng;
+    std::vector<uint64_t> live(n);
+    for (uint64_t& k : live) {
+        k = rng.next() | 1;
+        map.insert(k, k);
+    }
+    const bench::Params params = {{"ids", n}, {"flat", flat}};
+
+    runner.run("find_hit", params, [&] {
+        uint64_t sum = 0;
+        Xorshift pick;
+        const uint64_t t0 = bench::now_ns();
+        for (uint64_t k = 0; k < kOps; ++k) {
+            sum += *map.find(live[pick.next() % n]);
+        }
+        const uint64_t ns = bench::now_ns() - t0;
+        bench::do_not_optimize(sum);
+        return bench::Sample{ns, kOps};
+    });
+
+    runner.run("find_miss", params, [&] {
+        uint64_t hits = 0;
+        Xorshift fresh{0x1234567};
+        const uint64_t t0 = bench::now_ns();
+        for (uint64_t k = 0; k < kOps; ++k) {
+            hits += map.find(fresh.next() & ~1ull) != nullptr; // even: never live
+        }
+        const uint64_t ns = bench::now_ns() - t0;
+        bench::do_not_optimize(hits);
+        return bench::Sample{ns, kOps};
+    });
+
+    runner.run("erase_insert", params, [&] {
+        Xorshift pick{0x2545f4914f6cdd1dull};
+        const uint64_t t0 = bench::now_ns();
+        for (uint64_t k = 0; k < kOps; ++k) {
+            uint64_t& slot = live[pick.next() % n];
+            map.erase(slot);
+            slot = rng.next() | 1;
+            map.insert(slot, slot);
+        }
+        return bench::Sample{bench::now_ns() - t0, kOps};
+    });
+}
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    bench::Runner runner("client_ids", opt);
+    runner.calibrate();
+
+    for (uint64_t n : {10'000ull, 100'000ull, 1'000'000ull}) {
+        if (n > opt.max_depth) {
+            break;
+        }
+        run_map<Flat>(runner, true, n);
+        run_map<Std>(runner, false, n);
+    }
+
+    // --- engine: rest n orders, cancel them all by client or exchange id
+    for (uint64_t n : {10'000ull, 100'000ull}) {
+        if (n > opt.max_depth) {
+            break;
+        }
+        for (const bool by_cid : {false, true}) {
+            runner.run("engine_cancel", {{"orders", n}, {"by_cid", by_cid}}, [&] {
+                auto engine = std::make_unique<Engine>();
+                engine->reserve_client_ids(kSession, n);
+                std::vector<uint64_t> exch(n);
+                OrderNewBody o{};
+                o.instrument_id = 1;
+                o.qty = 10;
+                for (uint64_t i = 0; i < n; ++i) {
+                    o.client_order_id = (i + 1) * 0x9e3779b97f4a7c15ull;
+                    o.price_ticks = 1000 + int64_t(i % 500);
+                    exch[i] = engine->on_new(o, true, kSession).ack.exch_order_id;
+                }
+                OrderCancelBody c{};
+                uint64_t ok = 0;
+                const uint64_t t0 = bench::now_ns();
+                for (uint64_t i = 0; i < n; ++i) {
+                    c.client_order_id = (i + 1) * 0x9e3779b97f4a7c15ull;
+                    c.instrument_id = by_cid ? 0 : 1;
+                    c.exch_order_id = by_cid ? 0 : exch[i];
+                    ok += engine->on_cancel(c, kSession).ack.status == 0;
+                }
+                const uint64_t ns = bench::now_ns() - t0;
+                bench::do_not_optimize(ok);
+                return bench::Sample{ns, n};
+            });
+        }
+    }
+    runner.finish();
+    return 0;
+}
@@ -0,0 +1,67 @@
+// bench/bench_clock.cpp
+// Timestamp cost: clk::now_ns() (TSC-backed when invariant) against
+// steady_clock::now() and a bare rdtsc, and how far clk::now_ns() strays from
+// steady_clock over a few seconds of resyncs. For the effect on the engine,
+// run bench_engine as is and with MARKETFEED_CLOCK=steady.
+#include "bench_harness.hpp"
+#include "clock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+static constexpr uint64_t kCalls = 1'000'000;
+
+static uint64_t steady_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename Clock>
+static bench::Sample time_calls(Clock&& clock) {
+    uint64_t sum = 0;
+    const uint64_t t0 = bench::now_ns();
+    for (uint64_t i = 0; i < kCalls; ++i) {
+        sum += clock();
+    }
+    const uint64_t ns = bench::now_ns() - t0;
+    bench::do_not_optimize(sum);
+    return bench::Sample{ns, kCalls};
+}
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    bench::Runner runner("clock", opt);
+    runner.calibrate();
+    const bool tsc = clk::source() == clk::Source::Tsc;
+
+    runner.run("steady_clock", {}, [] { return time_calls(steady_ns); });
+    runner.run("clk_now", {{"tsc", tsc}}, [] { return time_calls(clk::now_ns); });
+#ifdef MARKETFEED_HAVE_TSC
+    runner.run("rdtsc", {}, [] { return time_calls([] { return uint64_t(__rdtsc()); }); });
+#endif
+
+    // --- distance from steady_clock, sampled every 50ms for 3s (covers the doubling resyncs)
+    int64_t worst = 0;
+    double sum = 0.0;
+    int samples = 0;
+    for (int i = 0; i < 60; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const int64_t before = int64_t(steady_ns());
+        const int64_t mine = int64_t(clk::now_ns());
+        const int64_t after = int64_t(steady_ns());
+        // outside [before, after] is error; inside, it's within the read window
+        const int64_t off = mine < before ? before - mine : mine > after ? mine - after : 0;
+        worst = std::max(worst, off);
+        sum += double(off);
+        ++samples;
+    }
+    runner.report("offset_from_steady", {{"tsc", tsc}, {"seconds", 3}},
+                  {{"max_ns", double(worst)}, {"mean_ns", sum / samples}, {"tsc_hz", clk::tsc_hz()}});
+
+    runner.finish();
+    return 0;
+}
@@ -0,0 +1,143 @@
+// bench/bench_consumer_book.cpp
+// ConsumerBooks on recorded market data: frames/sec applying a whole feed,
+// and top-N queries on the resulting books. --capture takes either a feed
+// recorded with `replay --md-out` or an order-flow capture (run through an
+// Engine here to produce its feed); without it the feed comes from 1M
+// generated requests.
+#include "bench_harness.hpp"
+#include "capture.hpp"
+#include "consumer_book.hpp"
+#include "engine.hpp"
+#include "flow_gen.hpp"
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Wire frames back to back, as they arrive from the publisher.
+struct Feed {
+    std::vector<uint8_t> bytes;
+    uint64_t frames = 0;
+
+    template <typename BodyT>
+    void append(MsgType type, const BodyT& body) {
+        Header h = codec::make_header(type, sizeof(BodyT), ++frames, 0);
+        const size_t at = bytes.size();
+        bytes.resize(at + sizeof(Header) + sizeof(BodyT));
+        std::memcpy(bytes.data() + at, &h, sizeof(Header));
+        std::memcpy(bytes.data() + at + sizeof(Header), &body, sizeof(BodyT));
+    }
+
+    void append_result(const EngineResult& res) {
+        for (const TradeBody& t : res.trades) {
+            append(MsgType::TRADE, t);
+        }
+        for (const LevelUpdateBody& u : res.levels) {
+            append(MsgType::BOOK_UPDATE, u);
+        }
+    }
+};
+
+static bool load_feed(const bench::Options& opt, Feed& feed) {
+    auto engine = std::make_unique<Engine>();
+    if (opt.capture.empty()) {
+        FlowGenConfig cfg;
+        cfg.num_instruments = 3;
+        FlowGenerator gen(cfg);
+        for (int i = 0; i < 1'000'000; ++i) {
+            FlowEvent ev = gen.next();
+            feed.append_result(ev.type == MsgType::NEW
+                                   ? engine->on_new(ev.new_order, (ev.new_order.flags & TIF_IOC) == 0)
+                                   : engine->on_cancel(ev.cancel));
+        }
+        return true;
+    }
+    CaptureFile cap;
+    if (!cap.open(opt.capture)) {
+        return false;
+    }
+    CaptureFile::Frame f;
+    while (cap.next(f)) {
+        switch (static_cast<MsgType>(f.hdr.type)) {
+            case MsgType::TRADE:
+                feed.append(MsgType::TRADE, codec::decode_body<TradeBody>(f.body));
+                break;
+            case MsgType::BOOK_UPDATE:
+                feed.append(MsgType::BOOK_UPDATE, codec::decode_body<LevelUpdateBody>(f.body));
+                break;
+            case MsgType::NEW: {
+                auto m = codec::decode_body<OrderNewBody>(f.body);
+                feed.append_result(engine->on_new(m, (m.flags & TIF_IOC) == 0));
+                break;
+            }
+            case MsgType::CANCEL:
+                feed.append_result(engine->on_cancel(codec::decode_body<OrderCancelBody>(f.body)));
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    Feed feed;
+    if (!load_feed(opt, feed)) {
+        return 1;
+    }
+    bench::Runner runner("consumer_book", opt);
+    runner.calibrate();
+
+    // --- apply the whole feed; reset() keeps capacity, as a long-running consumer would
+    ConsumerBooks books;
+    bool in_sequence = true;
+    runner.run("apply_feed", {{"frames", feed.frames}}, [&] {
+        books.reset();
+        const uint8_t* p = feed.bytes.data();
+        const uint8_t* end = p + feed.bytes.size();
+        const uint64_t t0 = bench::now_ns();
+        while (p < end) {
+            Header h;
+            std::memcpy(&h, p, sizeof(Header));
+            const auto r = books.on_frame(h, std::span<const uint8_t>(p + sizeof(Header), h.size - sizeof(Header)));
+            in_sequence = in_sequence && r != ConsumerBooks::Result::Gap;
+            p += h.size;
+        }
+        return bench::Sample{bench::now_ns() - t0, feed.frames};
+    });
+    if (!in_sequence) {
+        std::cerr << "bench_consumer_book: feed has sequence gaps\n";
+        return 1;
+    }
+
+    // --- top-N of both sides, round-robin over the instruments the feed touched
+    std::vector<uint32_t> instruments;
+    for (uint32_t id = 0; id < ConsumerBooks::kMaxInstruments; ++id) {
+        const ConsumerBook* b = books.book(id);
+        if (b != nullptr && b->num_levels(0) + b->num_levels(1) > 0) {
+            instruments.push_back(id);
+        }
+    }
+    for (uint64_t depth : {1, 5, 20}) {
+        if (instruments.empty()) {
+            break;
+        }
+        runner.run("top", {{"n", depth}}, [&] {
+            constexpr uint64_t kQueries = 100'000;
+            ConsumerLevel out[20];
+            const uint64_t t0 = bench::now_ns();
+            for (uint64_t i = 0; i < kQueries; ++i) {
+                const ConsumerBook* b = books.book(instruments[i % instruments.size()]);
+                const size_t n = b->top(uint8_t(i & 1), std::span<ConsumerLevel>(out, depth));
+                bench::do_not_optimize(out[0].total_qty + int64_t(n));
+            }
+            return bench::Sample{bench::now_ns() - t0, kQueries};
+        });
+    }
+    runner.finish();
+    return 0;
+}
@@ -0,0 +1,195 @@
+// bench/bench_engine.cpp
+// Engine throughput on realistic flow (a FlowGenerator stream, or a capture
+// file with --capture), bar aggregation over its trades, pulling a session's
+// quotes with one MASS_CANCEL or a disconnect against a stream of single
+// cancels, and the codec calls on the order-entry path.
+#include "bar_aggregator.hpp"
+#include "bench_harness.hpp"
+#include "capture.hpp"
+#include "codec.hpp"
+#include "engine.hpp"
+#include "flow_gen.hpp"
+#include <iostream>
+#include <memory>
+#include <vector>
+
+struct Request {
+    MsgType type;
+    OrderNewBody new_order;
+    OrderCancelBody cancel;
+};
+
+static bool load_flow(const bench::Options& opt, std::vector<Request>& out) {
+    if (!opt.capture.empty()) {
+        CaptureFile cap;
+        if (!cap.open(opt.capture)) {
+            return false;
+        }
+        CaptureFile::Frame f;
+        while (cap.next(f)) {
+            Request r{};
+            r.type = static_cast<MsgType>(f.hdr.type);
+            if (r.type == MsgType::NEW) {
+                r.new_order = codec::decode_body<OrderNewBody>(f.body);
+            } else if (r.type == MsgType::CANCEL) {
+                r.cancel = codec::decode_body<OrderCancelBody>(f.body);
+            } else {
+                continue;
+            }
+            out.push_back(r);
+        }
+        return true;
+    }
+    FlowGenConfig cfg;
+    cfg.num_instruments = 3;
+    FlowGenerator gen(cfg);
+    for (int i = 0; i < 200'000; ++i) {
+        FlowEvent ev = gen.next();
+        out.push_back(Request{ev.type, ev.new_order, ev.cancel});
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    std::vector<Request> flow;
+    if (!load_flow(opt, flow)) {
+        return 1;
+    }
+    bench::Runner runner("engine", opt);
+    runner.calibrate();
+
+    // --- whole flow through a fresh engine (construction not timed)
+    runner.run("engine_flow", {{"messages", flow.size()}}, [&] {
+        auto engine = std::make_unique<Engine>();
+        const uint64_t t0 = bench::now_ns();
+        for (const Request& r : flow) {
+            if (r.type == MsgType::NEW) {
+                EngineResult res = engine->on_new(r.new_order, (r.new_order.flags & TIF_IOC) == 0);
+                bench::do_not_optimize(res.ack.exch_order_id);
+            } else {
+                EngineResult res = engine->on_cancel(r.cancel);
+                bench::do_not_optimize(res.ack.status);
+            }
+        }
+        return bench::Sample{bench::now_ns() - t0, flow.size()};
+    });
+
+    // --- bars (1s and 1min) over the flow's trades, one trade per microsecond;
+    // completed bars are drained as the server would
+    std::vector<TradeBody> trades;
+    {
+        auto engine = std::make_unique<Engine>();
+        for (const Request& r : flow) {
+            EngineResult res = r.type == MsgType::NEW ? engine->on_new(r.new_order, (r.new_order.flags & TIF_IOC) == 0)
+                                                      : engine->on_cancel(r.cancel);
+            trades.insert(trades.end(), res.trades.begin(), res.trades.end());
+        }
+    }
+    if (!trades.empty()) {
+        runner.run("bar_on_trade", {{"trades", trades.size()}}, [&] {
+            BarAggregator bars(256, {1'000'000'000, 60'000'000'000});
+            BarBody bar;
+            uint64_t ts = 0;
+            const uint64_t t0 = bench::now_ns();
+            for (const TradeBody& t : trades) {
+                bars.on_trade(t, ts += 1000);
+                while (bars.try_pop(bar)) {
+                    bench::do_not_optimize(bar.volume);
+                }
+            }
+            return bench::Sample{bench::now_ns() - t0, trades.size()};
+        });
+    }
+
+    // --- pull 100k resting orders over 2x1000 levels: one MASS_CANCEL (session
+    // filter, or none as an admin kill would) or the session's disconnect
+    // against one CANCEL per order; ns per order cancelled, ACKs and level
+    // updates included
+    constexpr uint64_t kResting = 100'000;
+    auto quoted = [&] {
+        auto engine = std::make_unique<Engine>();
+        for (uint64_t i = 0; i < kResting; ++i) {
+            OrderNewBody o{};
+            o.client_order_id = i + 1;
+            o.instrument_id = 1;
+            o.side = uint8_t(i & 1);
+            o.price_ticks = (i & 1) ? 10'001 + int64_t(i / 2 % 1000) : 10'000 - int64_t(i / 2 % 1000);
+            o.qty = 10;
+            engine->on_new(o, true, 1);
+        }
+        return engine;
+    };
+    runner.run("cancel_each", {{"orders", kResting}}, [&] {
+        auto engine = quoted();
+        const uint64_t t0 = bench::now_ns();
+        for (uint64_t id = 1; id <= kResting; ++id) {
+            OrderCancelBody c{};
+            c.exch_order_id = id;
+            c.client_order_id = id;
+            c.instrument_id = 1;
+            EngineResult res = engine->on_cancel(c);
+            bench::do_not_optimize(res.ack.status);
+        }
+        return bench::Sample{bench::now_ns() - t0, kResting};
+    });
+    for (const uint32_t session : {1u, kAnyOwner}) {
+        runner.run("mass_cancel", {{"orders", kResting}, {"session_filter", session != kAnyOwner}}, [&] {
+            auto engine = quoted();
+            MassCancelBody m{};
+            m.instrument_id = 1;
+            m.side = kBothSides;
+            const uint64_t t0 = bench::now_ns();
+            EngineResult res = engine->on_mass_cancel(m, session);
+            const uint64_t t1 = bench::now_ns();
+            bench::do_not_optimize(res.levels.data());
+            return bench::Sample{t1 - t0, res.ack.cancelled_count};
+        });
+    }
+    runner.run("cancel_session", {{"orders", kResting}}, [&] {
+        auto engine = quoted();
+        const uint64_t t0 = bench::now_ns();
+        EngineResult res = engine->cancel_session(1);
+        const uint64_t t1 = bench::now_ns();
+        bench::do_not_optimize(res.levels.data());
+        return bench::Sample{t1 - t0, res.ack.cancelled_count};
+    });
+
+    constexpr uint64_t kCodecOps = 100'000;
+    OrderNewBody body{};
+    body.client_order_id = 42;
+    body.price_ticks = 101;
+    body.qty = 30;
+    body.instrument_id = 1;
+
+    // --- codec: encode a NEW frame (allocates, as the client does)
+    runner.run("codec_pack_new", {}, [&] {
+        const uint64_t t0 = bench::now_ns();
+        for (uint64_t i = 0; i < kCodecOps; ++i) {
+            Header h = codec::make_header(MsgType::NEW, sizeof(OrderNewBody), i, 0);
+            std::vector<uint8_t> bytes = codec::pack(h, body);
+            bench::do_not_optimize(bytes.data());
+        }
+        return bench::Sample{bench::now_ns() - t0, kCodecOps};
+    });
+
+    // --- codec: header + body decode, as the server does per frame
+    Header h = codec::make_header(MsgType::NEW, sizeof(OrderNewBody), 0, 0);
+    const std::vector<uint8_t> frame = codec::pack(h, body);
+    runner.run("codec_decode_new", {}, [&] {
+        const uint64_t t0 = bench::now_ns();
+        for (uint64_t i = 0; i < kCodecOps; ++i) {
+            Header dh = codec::decode<Header>(frame.data(), frame.size());
+            auto m = codec::decode_body<OrderNewBody>(
+                std::span<const uint8_t>(frame.data() + sizeof(Header), dh.size - sizeof(Header)));
+            bench::do_not_optimize(m.price_ticks);
+        }
+        return bench::Sample{bench::now_ns() - t0, kCodecOps};
+    });
+
+    runner.finish();
+    return 0;
+}
@@ -0,0 +1,105 @@
+// bench/bench_expiry.cpp
+// Bulk order expiry off the timer wheel (timer_wheel.hpp). A book of N
+// resting orders, all with an expiry, is expired in one Engine::expire()
+// call: DAY orders due on the same tick (the session boundary), and GTT
+// orders spread over an hour of lifetimes, so the wheel cascades them down
+// as it goes. cancel_session over the same orders is the bulk cancel
+// without a wheel, for comparison; new_rest times the insert with and
+// without a timer. ns_per_op is per order.
+#include "bench_harness.hpp"
+#include "clock.hpp"
+#include "engine.hpp"
+#include <memory>
+
+static constexpr int64_t kMid = 1'000'000;
+static constexpr int64_t kLevels = 1000; // per side
+static constexpr uint64_t kSec = 1'000'000'000;
+static constexpr uint32_t kSession = 1;
+
+static OrderNewBody order(uint64_t i, uint8_t flags) {
+    OrderNewBody o{};
+    o.client_order_id = i + 1;
+    o.instrument_id = 1 + uint32_t(i % 3);
+    o.side = uint8_t((i / 3) & 1);
+    const int64_t offset = 1 + int64_t(i / 6 % uint64_t(kLevels));
+    o.price_ticks = o.side == 0 ? kMid - offset : kMid + offset;
+    o.qty = 10;
+    o.flags = flags;
+    if (flags & TIF_GTT) {
+        o.expire_after_s = uint16_t(1 + i % 3600);
+    }
+    return o;
+}
+
+// An engine holding n non-crossing orders of the session, timed by `flags`.
+static std::unique_ptr<Engine> build(uint64_t n, uint8_t flags) {
+    auto engine = std::make_unique<Engine>();
+    engine->set_day_end(clk::now_ns() + 3600 * kSec);
+    for (uint64_t i = 0; i < n; ++i) {
+        engine->on_new(order(i, flags), true, kSession);
+    }
+    return engine;
+}
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    bench::Runner runner("expiry", opt);
+    runner.calibrate();
+    const uint64_t counts[] = {10'000, 100'000, 1'000'000};
+
+    for (uint64_t n : counts) {
+        if (n > opt.max_depth) {
+            break;
+        }
+        const bench::Params params = {{"orders", n}};
+
+        // --- every order expires on the same tick
+        runner.run("expire_day", params, [&] {
+            auto engine = build(n, TIF_DAY);
+            const uint64_t t0 = bench::now_ns();
+            const EngineResult r = engine->expire(engine->day_end() + kSec);
+            const uint64_t ns = bench::now_ns() - t0;
+            bench::do_not_optimize(r.levels.size());
+            return bench::Sample{ns, r.ack.cancelled_count};
+        });
+
+        // --- lifetimes of 1..3600 s, all past due at once
+        runner.run("expire_gtt_spread", params, [&] {
+            auto engine = build(n, TIF_GTT);
+            const uint64_t t0 = bench::now_ns();
+            const EngineResult r = engine->expire(clk::now_ns() + 3601 * kSec);
+            const uint64_t ns = bench::now_ns() - t0;
+            bench::do_not_optimize(r.levels.size());
+            return bench::Sample{ns, r.ack.cancelled_count};
+        });
+
+        // --- the same orders pulled through the session's list instead
+        runner.run("cancel_session", params, [&] {
+            auto engine = build(n, 0);
+            const uint64_t t0 = bench::now_ns();
+            const EngineResult r = engine->cancel_session(kSession);
+            const uint64_t ns = bench::now_ns() - t0;
+            bench::do_not_optimize(r.levels.size());
+            return bench::Sample{ns, r.ack.cancelled_count};
+        });
+
+        // --- insert cost: resting with and without a timer
+        for (const uint8_t flags : {uint8_t(0), TIF_GTT}) {
+            runner.run("new_rest", {{"orders", n}, {"timed", flags != 0}}, [&] {
+                auto engine = std::make_unique<Engine>();
+                const uint64_t t0 = bench::now_ns();
+                for (uint64_t i = 0; i < n; ++i) {
+                    engine->on_new(order(i, flags), true, kSession);
+                }
+                const uint64_t ns = bench::now_ns() - t0;
+                bench::do_not_optimize(engine->num_resting_orders());
+                return bench::Sample{ns, n};
+            });
+        }
+    }
+    runner.finish();
+    return 0;
+}
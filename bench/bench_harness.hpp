@@ -0,0 +1,248 @@
+// bench/bench_harness.hpp
+// Minimal benchmark harness shared by the bench_* executables.
+//  - Pins the process to one core (--cpu, default: the core it started on)
+//  - Each case runs --warmup unrecorded repetitions, then --reps recorded ones
+//  - A repetition times its own measured region and reports (ns, ops), so
+//    setup and restore work stay out of the numbers
+//  - Results: ns/op min / p10 / median / p90 / max / mean over repetitions,
+//    printed as one JSON document on stdout (progress goes to stderr);
+//    non-timing cases (e.g. bytes per order) go through report(); --samples
+//    adds every repetition's ns/op, sorted (the perf gate tests on them)
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace bench {
+
+inline uint64_t now_ns() noexcept {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Keeps the compiler from discarding a computed value.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Sample {
+    uint64_t ns;
+    uint64_t ops;
+};
+
+struct Options {
+    int reps = 11;
+    int warmup = 2;
+    int cpu = -1;                  // -1 = the core we started on
+    std::string filter;            // run only cases whose id contains one of these (comma-separated)
+    uint64_t max_depth = 1'000'000;
+    std::string capture;           // capture file for benchmarks that replay flow
+    bool samples = false;          // print each repetition's ns/op too
+};
+
+inline void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " [--reps N] [--warmup N] [--cpu N] [--filter text] [--max-depth N]"
+              << " [--capture file] [--samples]\n";
+}
+
+// Returns false on an unknown argument.
+inline bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--reps" && has_value) {
+            opt.reps = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--warmup" && has_value) {
+            opt.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--cpu" && has_value) {
+            opt.cpu = std::atoi(argv[++i]);
+        } else if (arg == "--filter" && has_value) {
+            opt.filter = argv[++i];
+        } else if (arg == "--max-depth" && has_value) {
+            opt.max_depth = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--capture" && has_value) {
+            opt.capture = argv[++i];
+        } else if (arg == "--samples") {
+            opt.samples = true;
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Pins the calling thread; returns the core actually used (-1 if unsupported).
+inline int pin_to_cpu(int cpu) {
+#ifdef __linux__
+    if (cpu < 0) {
+        cpu = sched_getcpu();
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        std::cerr << "bench: could not pin to cpu " << cpu << ", running unpinned\n";
+        return -1;
+    }
+    return cpu;
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+// Integer parameters identifying a case, e.g. {{"depth", 1000}, {"fills", 10}}.
+using Params = std::vector<std::pair<std::string, uint64_t>>;
+
+class Runner {
+public:
+    Runner(std::string benchmark, const Options& opt) : benchmark_(std::move(benchmark)), opt_(opt) {
+        cpu_ = pin_to_cpu(opt.cpu);
+    }
+
+    static std::string case_id(const std::string& name, const Params& params) {
+        std::string id = name;
+        for (const auto& [k, v] : params) {
+            id += "/" + k + ":" + std::to_string(v);
+        }
+        return id;
+    }
+
+    bool selected(const std::string& name, const Params& params) const {
+        if (opt_.filter.empty()) {
+            return true;
+        }
+        const std::string id = case_id(name, params);
+        size_t pos = 0;
+        while (pos <= opt_.filter.size()) {
+            size_t end = opt_.filter.find(',', pos);
+            if (end == std::string::npos) end = opt_.filter.size();
+            if (end > pos && id.find(opt_.filter.substr(pos, end - pos)) != std::string::npos) {
+                return true;
+            }
+            pos = end + 1;
+        }
+        return false;
+    }
+
+    // rep() runs one repetition and returns the time spent in its measured
+    // region and the number of operations done there.
+    template <typename Rep>
+    void run(const std::string& name, const Params& params, Rep&& rep) {
+        if (!selected(name, params)) {
+            return;
+        }
+        std::cerr << "bench: " << case_id(name, params) << "\n";
+        for (int i = 0; i < opt_.warmup; ++i) {
+            rep();
+        }
+        std::vector<double> ns_per_op;
+        uint64_t ops = 0;
+        for (int i = 0; i < opt_.reps; ++i) {
+            const Sample s = rep();
+            ops += s.ops;
+            ns_per_op.push_back(s.ops ? double(s.ns) / double(s.ops) : 0.0);
+        }
+        std::sort(ns_per_op.begin(), ns_per_op.end());
+        double sum = 0.0;
+        for (double v : ns_per_op) sum += v;
+
+        std::ostringstream out;
+        out << "{\"name\":\"" << name << "\"";
+        for (const auto& [k, v] : params) {
+            out << ",\"" << k << "\":" << v;
+        }
+        out << ",\"ops\":" << ops << ",\"ns_per_op\":{"
+            << "\"min\":" << ns_per_op.front()
+            << ",\"p10\":" << pct(ns_per_op, 10)
+            << ",\"median\":" << pct(ns_per_op, 50)
+            << ",\"p90\":" << pct(ns_per_op, 90)
+            << ",\"max\":" << ns_per_op.back()
+            << ",\"mean\":" << sum / double(ns_per_op.size()) << "}";
+        if (opt_.samples) {
+            out << ",\"samples\":[";
+            for (size_t i = 0; i < ns_per_op.size(); ++i) {
+                out << (i ? "," : "") << ns_per_op[i];
+            }
+            out << "]";
+        }
+        out << "}";
+        results_.push_back(out.str());
+    }
+
+    // Records a case measured by something other than time (bytes, counts);
+    // the metrics are printed as given, in place of ns_per_op.
+    void report(const std::string& name, const Params& params,
+                const std::vector<std::pair<std::string, double>>& metrics) {
+        if (!selected(name, params)) {
+            return;
+        }
+        std::ostringstream out;
+        out << "{\"name\":\"" << name << "\"";
+        for (const auto& [k, v] : params) {
+            out << ",\"" << k << "\":" << v;
+        }
+        for (const auto& [k, v] : metrics) {
+            out << ",\"" << k << "\":" << v;
+        }
+        out << "}";
+        results_.push_back(out.str());
+    }
+
+    // Fixed CPU-bound reference work (a dependent integer chain over an
+    // L1-resident table). Comparing other cases against it takes most of the
+    // machine and frequency out of a cross-run comparison (see tests/perf).
+    void calibrate() {
+        run("calibrate", {}, [] {
+            constexpr uint64_t kSteps = 1'000'000;
+            uint64_t table[256];
+            for (uint64_t i = 0; i < 256; ++i) {
+                table[i] = i * 0x9e3779b97f4a7c15ull;
+            }
+            uint64_t x = 1;
+            const uint64_t t0 = now_ns();
+            for (uint64_t i = 0; i < kSteps; ++i) {
+                x = (x ^ table[x & 255]) * 0xff51afd7ed558ccdull + i;
+            }
+            const uint64_t t1 = now_ns();
+            do_not_optimize(x);
+            return Sample{t1 - t0, kSteps};
+        });
+    }
+
+    // Prints the JSON document.
+    void finish() const {
+        std::cout << "{\"benchmark\":\"" << benchmark_ << "\",\"cpu\":" << cpu_ << ",\"reps\":" << opt_.reps
+                  << ",\"warmup\":" << opt_.warmup << ",\"results\":[";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            std::cout << (i ? ",\n" : "\n") << results_[i];
+        }
+        std::cout << "\n]}\n";
+    }
+
+private:
+    // nearest-rank percentile over sorted samples
+    static double pct(const std::vector<double>& sorted, double p) {
+        const size_t rank = size_t(p / 100.0 * double(sorted.size() - 1) + 0.5);
+        return sorted[std::min(rank, sorted.size() - 1)];
+    }
+
+    std::string benchmark_;
+    Options opt_;
+    int cpu_ = -1;
+    std::vector<std::string> results_;
+};
+
+} // namespace bench
@@ -0,0 +1,146 @@
+// bench/bench_level_sweep.cpp
+// One price level swept whole by a taker: the book's LevelQueue (a
+// std::list of BookOrder through CountingAllocator) against LevelRing
+// (level_ring.hpp), 10 to 10k makers of 1..20 lots, optionally with a
+// quarter of them cancelled first (holes:1; the list just unlinks them).
+// Each rep rebuilds the level untimed, then times one sweep of its total
+// quantity; ns_per_op is per maker filled. Then the prefix sum alone,
+// SSE2 (simd:1) against the scalar loop, per quantity scanned.
+#include "bench_harness.hpp"
+#include "level_ring.hpp"
+#include "order_book.hpp"
+#include <vector>
+
+struct Xorshift {
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    uint64_t next() {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x;
+    }
+};
+
+static TradeBody make_proto() {
+    TradeBody t{};
+    t.price_ticks = 1000;
+    t.taking_exch_order_id = 1;
+    t.instrument_id = 1;
+    t.liquidity_flag = 1;
+    return t;
+}
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    bench::Runner runner("level_sweep", opt);
+    runner.calibrate();
+
+    const TradeBody proto = make_proto();
+    for (uint64_t n : {10ull, 100ull, 1'000ull, 10'000ull}) {
+        if (n > opt.max_depth) {
+            break;
+        }
+        std::vector<int32_t> qty(n);
+        Xorshift rng;
+        for (int32_t& q : qty) {
+            q = 1 + int32_t(rng.next() % 20);
+        }
+        for (const bool holes : {false, true}) {
+            auto cancelled = [&](uint64_t i) { return holes && i % 4 == 1; };
+            const uint64_t makers = holes ? n - (n + 2) / 4 : n;
+            std::vector<TradeBody> out;
+            out.reserve(n + 1);
+
+            runner.run("list", {{"makers", n}, {"holes", holes}}, [&] {
+                MemoryCounter mem;
+                LevelQueue level{LevelQueue::allocator_type(&mem)};
+                int32_t total = 0;
+                std::vector<LevelQueue::iterator> its(n);
+                for (uint64_t i = 0; i < n; ++i) {
+                    its[i] = level.insert(level.end(), BookOrder{i + 1, qty[i], 0});
+                }
+                for (uint64_t i = 0; i < n; ++i) {
+                    if (cancelled(i)) {
+                        level.erase(its[i]);
+                    } else {
+                        total += qty[i];
+                    }
+                }
+                out.clear();
+                const uint64_t t0 = bench::now_ns();
+                // as OrderBook::match_taker walks a level
+                int32_t left = total;
+                TradeBody t = proto;
+                while (left > 0 && !level.empty()) {
+                    BookOrder& m = level.front();
+                    const int32_t q = std::min(left, m.qty);
+                    t.qty = q;
+                    t.resting_exch_order_id = m.exch_order_id;
+                    out.push_back(t);
+                    left -= q;
+                    m.qty -= q;
+                    if (m.qty == 0) {
+                        level.pop_front();
+                    }
+                }
+                const uint64_t ns = bench::now_ns() - t0;
+                bench::do_not_optimize(out.data());
+                return bench::Sample{ns, makers};
+            });
+
+            runner.run("ring", {{"makers", n}, {"holes", holes}}, [&] {
+                LevelRing level;
+                int32_t total = 0;
+                std::vector<uint64_t> handles(n);
+                for (uint64_t i = 0; i < n; ++i) {
+                    handles[i] = level.push_back(i + 1, qty[i]);
+                }
+                for (uint64_t i = 0; i < n; ++i) {
+                    if (cancelled(i)) {
+                        level.cancel(handles[i]);
+                    } else {
+                        total += qty[i];
+                    }
+                }
+                out.clear();
+                const uint64_t t0 = bench::now_ns();
+                const LevelRing::Sweep s = level.sweep(total, proto, out);
+                const uint64_t ns = bench::now_ns() - t0;
+                bench::do_not_optimize(s.removed);
+                bench::do_not_optimize(out.data());
+                return bench::Sample{ns, makers};
+            });
+        }
+    }
+
+    // --- the prefix sum alone over 4096 quantities, budget past all of them
+    {
+        std::vector<int32_t> qty(4096);
+        Xorshift rng;
+        for (int32_t& q : qty) {
+            q = int32_t(rng.next() % 21);
+        }
+        constexpr uint64_t kScans = 1000;
+        for (const bool simd : {false, true}) {
+            runner.run("prefix", {{"qtys", qty.size()}, {"simd", simd}}, [&] {
+                size_t n = 0;
+                const uint64_t t0 = bench::now_ns();
+                for (uint64_t k = 0; k < kScans; ++k) {
+                    int64_t sum = 0;
+                    n += simd ? level_ring::consumed_prefix(qty.data(), qty.size(), INT64_MAX, sum)
+                              : level_ring::consumed_prefix_scalar(qty.data(), qty.size(), INT64_MAX, sum);
+                    bench::do_not_optimize(sum);
+                }
+                const uint64_t ns = bench::now_ns() - t0;
+                bench::do_not_optimize(n);
+                return bench::Sample{ns, kScans * qty.size()};
+            });
+        }
+    }
+
+    runner.finish();
+    return 0;
+}
@@ -0,0 +1,75 @@
+// bench/bench_memory.cpp
+// Memory cost of resting orders: grows one book to 10k .. 50M orders (capped
+// by --max-depth) and reports, at each size, process RSS growth per order
+// next to the bytes the book's counting allocators account for, split into
+// levels / orders / index. The RSS - accounted gap is the heap's per-block
+// overhead plus fragmentation.
+#include "bench_harness.hpp"
+#include "order_book.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+static int64_t rss_bytes() {
+    long pages = 0, resident = 0;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (f == nullptr) {
+        return 0;
+    }
+    if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    std::fclose(f);
+    return int64_t(resident) * ::sysconf(_SC_PAGESIZE);
+}
+
+static void release_free_memory() {
+#ifdef __GLIBC__
+    ::malloc_trim(0);
+#endif
+}
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    bench::Runner runner("memory", opt);
+    const uint64_t sizes[] = {10'000, 100'000, 1'000'000, 10'000'000, 50'000'000};
+    const uint64_t levels_per_side[] = {100, 10'000};
+
+    for (uint64_t levels : levels_per_side) {
+        release_free_memory();
+        const int64_t rss0 = rss_bytes();
+        auto book = std::make_unique<OrderBook>();
+        uint64_t id = 1;
+        for (uint64_t size : sizes) {
+            if (size > opt.max_depth) {
+                break;
+            }
+            while (book->num_orders() < size) {
+                const int64_t offset = int64_t((id / 2) % levels);
+                book->add_resting(id, OrderSide::Bid, 1'000'000 - offset, 10);
+                book->add_resting(id + 1, OrderSide::Ask, 1'000'001 + offset, 10);
+                id += 2;
+            }
+            const double n = double(book->num_orders());
+            const BookMemory& m = book->memory();
+            runner.report("bytes_per_order", {{"orders", book->num_orders()}, {"levels", 2 * levels}},
+                          {{"rss_bytes", double(rss_bytes() - rss0) / n},
+                           {"accounted_bytes", double(m.bytes()) / n},
+                           {"level_bytes", double(m.levels.bytes) / n},
+                           {"order_bytes", double(m.orders.bytes) / n},
+                           {"index_bytes", double(m.index.bytes) / n},
+                           {"blocks", double(m.levels.blocks + m.orders.blocks + m.index.blocks) / n}});
+            std::cerr << "bench: " << book->num_orders() << " orders, " << 2 * levels << " levels\n";
+        }
+    }
+    runner.finish();
+    return 0;
+}
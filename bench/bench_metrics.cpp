@@ -0,0 +1,160 @@
+// bench/bench_metrics.cpp
+// What the counters cost: one increment on the thread's own shard against an
+// atomic fetch_add, the same from several threads at once (per-thread padded
+// shards against one shared counter), reading the totals, and how many
+// increments an engine message makes; the same for a stage latency record
+// (stage_latency.hpp), alone and with the clock read it needs. For the
+// end-to-end cost, compare bench_engine's engine_flow between a default build
+// and one configured with -DMARKETFEED_METRICS=OFF.
+#include "bench_harness.hpp"
+#include "engine.hpp"
+#include "flow_gen.hpp"
+#include "metrics.hpp"
+#include "stage_latency.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static constexpr uint64_t kIncrements = 1'000'000; // per thread per repetition
+
+// Runs body(thread index) on n threads started together; returns wall ns.
+template <typename Body>
+static uint64_t run_threads(uint64_t n, Body&& body) {
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < n; ++t) {
+        threads.emplace_back([&, t] {
+            while (!go.load(std::memory_order_acquire)) {
+            }
+            body(t);
+        });
+    }
+    const uint64_t t0 = bench::now_ns();
+    go.store(true, std::memory_order_release);
+    for (std::thread& th : threads) {
+        th.join();
+    }
+    return bench::now_ns() - t0;
+}
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    bench::Runner runner("metrics", opt);
+    runner.calibrate();
+
+    // --- one thread: the production increment against a locked add
+    runner.run("count", {}, [] {
+        const uint64_t t0 = bench::now_ns();
+        for (uint64_t i = 0; i < kIncrements; ++i) {
+            metrics::count(Metric::MsgsOther);
+        }
+        return bench::Sample{bench::now_ns() - t0, kIncrements};
+    });
+    std::atomic<uint64_t> shared{0};
+    runner.run("shared_atomic", {}, [&] {
+        const uint64_t t0 = bench::now_ns();
+        for (uint64_t i = 0; i < kIncrements; ++i) {
+            shared.fetch_add(1, std::memory_order_relaxed);
+        }
+        return bench::Sample{bench::now_ns() - t0, kIncrements};
+    });
+
+    // --- several threads: own shards vs one contended line (meaningful with >= that many cores)
+    for (uint64_t threads : {2, 4}) {
+        runner.run("count", {{"threads", threads}}, [&] {
+            const uint64_t ns = run_threads(threads, [](uint64_t) {
+                for (uint64_t i = 0; i < kIncrements; ++i) {
+                    metrics::count(Metric::MsgsOther);
+                }
+            });
+            return bench::Sample{ns, threads * kIncrements};
+        });
+        runner.run("shared_atomic", {{"threads", threads}}, [&] {
+            const uint64_t ns = run_threads(threads, [&](uint64_t) {
+                for (uint64_t i = 0; i < kIncrements; ++i) {
+                    shared.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+            return bench::Sample{ns, threads * kIncrements};
+        });
+    }
+    bench::do_not_optimize(shared.load());
+
+    // --- stage latency: one record (values spread over ~1k buckets), and with its stamp
+    runner.run("latency_record", {}, [] {
+        const uint64_t t0 = bench::now_ns();
+        for (uint64_t i = 0; i < kIncrements; ++i) {
+            latency::record(LatencyStage::Write, (i * 2654435761u) & 0xfffff);
+        }
+        return bench::Sample{bench::now_ns() - t0, kIncrements};
+    });
+    runner.run("latency_stamp_record", {}, [] {
+        const uint64_t t0 = bench::now_ns();
+        uint64_t prev = latency::stamp();
+        for (uint64_t i = 0; i < kIncrements; ++i) {
+            const uint64_t now = latency::stamp();
+            latency::record(LatencyStage::Write, prev, now);
+            prev = now;
+        }
+        return bench::Sample{bench::now_ns() - t0, kIncrements};
+    });
+    runner.run("latency_read", {}, [] {
+        constexpr uint64_t kReads = 100;
+        const uint64_t t0 = bench::now_ns();
+        for (uint64_t i = 0; i < kReads; ++i) {
+            bench::do_not_optimize(latency::read(LatencyStage::Write).count());
+        }
+        return bench::Sample{bench::now_ns() - t0, kReads};
+    });
+
+    // --- aggregation, over every shard registered so far
+    runner.run("read", {{"shards", metrics::num_shards()}}, [] {
+        constexpr uint64_t kReads = 10'000;
+        const uint64_t t0 = bench::now_ns();
+        for (uint64_t i = 0; i < kReads; ++i) {
+            bench::do_not_optimize(metrics::read()[0]);
+        }
+        return bench::Sample{bench::now_ns() - t0, kReads};
+    });
+
+    // --- increments per engine message on generated flow
+    FlowGenConfig cfg;
+    cfg.num_instruments = 3;
+    FlowGenerator gen(cfg);
+    auto engine = std::make_unique<Engine>();
+    constexpr uint64_t kMessages = 200'000;
+    const MetricValues before = metrics::read();
+    uint64_t records_before = 0;
+    for (size_t s = 0; s < kNumLatencyStages; ++s) {
+        records_before += latency::read(static_cast<LatencyStage>(s)).count();
+    }
+    for (uint64_t i = 0; i < kMessages; ++i) {
+        FlowEvent ev = gen.next();
+        if (ev.type == MsgType::NEW) {
+            engine->on_new(ev.new_order, (ev.new_order.flags & TIF_IOC) == 0);
+        } else {
+            engine->on_cancel(ev.cancel);
+        }
+    }
+    const MetricValues after = metrics::read();
+    // events counted, excluding FilledQty: an upper bound on count() calls (fills in one NEW are one call)
+    uint64_t events = 0;
+    for (Metric m : {Metric::OrdersAccepted, Metric::Rejects, Metric::Fills, Metric::OrdersCancelled,
+                     Metric::LevelsCreated, Metric::LevelsDeleted}) {
+        events += after[size_t(m)] - before[size_t(m)];
+    }
+    uint64_t records = 0;
+    for (size_t s = 0; s < kNumLatencyStages; ++s) {
+        records += latency::read(static_cast<LatencyStage>(s)).count();
+    }
+    runner.report("increments_per_message", {{"messages", kMessages}},
+                  {{"events", double(events) / double(kMessages)},
+                   {"latency_records", double(records - records_before) / double(kMessages)}});
+
+    runner.finish();
+    return 0;
+}
@@ -0,0 +1,258 @@
+// bench/bench_orderbook.cpp
+// ns/op of the OrderBook primitives across book depths (10 .. 1M resting
+// orders): add, cancel at the front / middle / back of a level's queue,
+// match with 1 / 10 / 100 fills, best-quote queries. Then the auction:
+// equilibrium price and uncross of 10k .. 1M orders accumulated in a call
+// phase, against feeding the same orders through continuous matching.
+#include "bench_harness.hpp"
+#include "order_book.hpp"
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <set>
+#include <vector>
+
+static constexpr int64_t kMid = 1'000'000;
+static constexpr int32_t kQty = 10;
+static constexpr uint64_t kOpsPerRep = 1000; // timed operations (fills, for match) per repetition
+
+// A book of `depth` resting orders, half per side, spread round-robin over up
+// to 100 levels per side. Bid queues are mirrored so cancels can pick an
+// order by queue position.
+struct BookFixture {
+    OrderBook book;
+    uint64_t next_id = 1;
+    uint64_t per_side = 0;
+    uint64_t levels = 0;
+    std::vector<std::deque<uint64_t>> bid_queues; // FIFO order per level
+
+    explicit BookFixture(uint64_t depth) {
+        per_side = std::max<uint64_t>(1, depth / 2);
+        levels = std::min<uint64_t>(per_side, 100);
+        bid_queues.resize(levels);
+        for (uint64_t i = 0; i < per_side; ++i) {
+            const uint64_t l = i % levels;
+            add_bid(l);
+            book.add_resting(next_id++, OrderSide::Ask, ask_px(l), kQty);
+        }
+    }
+
+    static int64_t bid_px(uint64_t level) { return kMid - 1 - int64_t(level); }
+    static int64_t ask_px(uint64_t level) { return kMid + 1 + int64_t(level); }
+
+    void add_bid(uint64_t level) {
+        book.add_resting(next_id, OrderSide::Bid, bid_px(level), kQty);
+        bid_queues[level].push_back(next_id++);
+    }
+};
+
+enum class QueuePos { Front, Middle, Back };
+
+static const char* pos_name(QueuePos p) {
+    return p == QueuePos::Front ? "cancel_front" : p == QueuePos::Middle ? "cancel_middle" : "cancel_back";
+}
+
+struct AuctionOrder {
+    uint64_t id;
+    OrderSide side;
+    int64_t price_ticks;
+    int32_t qty;
+};
+
+static std::vector<AuctionOrder> auction_flow(uint64_t n) {
+    std::vector<AuctionOrder> flow;
+    flow.reserve(n);
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    for (uint64_t i = 0; i < n; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        flow.push_back({i + 1, (x & 1) ? OrderSide::Ask : OrderSide::Bid, kMid - 100 + int64_t((x >> 8) % 201),
+                        int32_t(1 + (x >> 32) % 10)});
+    }
+    return flow;
+}
+
+static std::unique_ptr<OrderBook> call_phase(const std::vector<AuctionOrder>& flow) {
+    auto book = std::make_unique<OrderBook>(1);
+    book->set_auction(true);
+    book->reserve(flow.size());
+    for (const AuctionOrder& o : flow) {
+        book->add_resting(o.id, o.side, o.price_ticks, o.qty);
+    }
+    return book;
+}
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    bench::Runner runner("orderbook", opt);
+    runner.calibrate();
+    const uint64_t depths[] = {10, 100, 1'000, 10'000, 100'000, 1'000'000};
+
+    for (uint64_t depth : depths) {
+        if (depth > opt.max_depth) {
+            break;
+        }
+        BookFixture fx(depth);
+
+        // --- add: new orders join the back of existing levels. Small books
+        // repeat add/remove rounds so every repetition times ~kOpsPerRep ops.
+        const uint64_t batch = std::min<uint64_t>(kOpsPerRep, fx.per_side);
+        runner.run("add", {{"depth", depth}}, [&] {
+            std::vector<uint64_t> ids(batch);
+            bench::Sample s{0, 0};
+            while (s.ops < kOpsPerRep) {
+                const uint64_t t0 = bench::now_ns();
+                for (uint64_t i = 0; i < batch; ++i) {
+                    ids[i] = fx.next_id++;
+                    fx.book.add_resting(ids[i], OrderSide::Bid, BookFixture::bid_px(i % fx.levels), kQty);
+                }
+                s.ns += bench::now_ns() - t0;
+                s.ops += batch;
+                for (uint64_t id : ids) {
+                    fx.book.cancel_order(id);
+                }
+            }
+            return s;
+        });
+
+        // --- cancel by queue position; cancelled orders are replaced at the back
+        for (QueuePos pos : {QueuePos::Front, QueuePos::Middle, QueuePos::Back}) {
+            runner.run(pos_name(pos), {{"depth", depth}}, [&] {
+                bench::Sample s{0, 0};
+                while (s.ops < kOpsPerRep) {
+                    const uint64_t qlen = fx.bid_queues[0].size();
+                    const uint64_t take = std::max<uint64_t>(1, std::min<uint64_t>(qlen / 2, (batch + fx.levels - 1) / fx.levels));
+                    std::vector<uint64_t> ids;
+                    std::vector<size_t> first(fx.levels);
+                    for (uint64_t l = 0; l < fx.levels; ++l) {
+                        std::deque<uint64_t>& q = fx.bid_queues[l];
+                        const uint64_t n = std::min<uint64_t>(take, q.size());
+                        first[l] = pos == QueuePos::Front ? 0 : pos == QueuePos::Back ? q.size() - n : (q.size() - n) / 2;
+                        for (uint64_t j = 0; j < n; ++j) {
+                            ids.push_back(q[first[l] + j]);
+                        }
+                    }
+                    const uint64_t t0 = bench::now_ns();
+                    for (uint64_t id : ids) {
+                        fx.book.cancel_order(id);
+                    }
+                    s.ns += bench::now_ns() - t0;
+                    s.ops += ids.size();
+                    for (uint64_t l = 0; l < fx.levels; ++l) {
+                        std::deque<uint64_t>& q = fx.bid_queues[l];
+                        const uint64_t n = std::min<uint64_t>(take, q.size());
+                        q.erase(q.begin() + std::ptrdiff_t(first[l]), q.begin() + std::ptrdiff_t(first[l] + n));
+                        for (uint64_t j = 0; j < n; ++j) {
+                            fx.add_bid(l);
+                        }
+                    }
+                }
+                return s;
+            });
+        }
+
+        // --- match: a bid taker sized to fill exactly `fills` resting asks
+        for (uint64_t fills : {1, 10, 100}) {
+            if (fills * 2 > fx.per_side) {
+                continue;
+            }
+            const uint64_t matches = std::max<uint64_t>(1, std::min<uint64_t>(256, fx.per_side / (4 * fills)));
+            std::vector<TradeBody> trades;
+            trades.reserve(matches * fills);
+            runner.run("match", {{"depth", depth}, {"fills", fills}}, [&] {
+                bench::Sample s{0, 0};
+                while (s.ops * fills < kOpsPerRep) {
+                    trades.clear();
+                    const uint64_t t0 = bench::now_ns();
+                    for (uint64_t m = 0; m < matches; ++m) {
+                        fx.book.match_taker(fx.next_id++, OrderSide::Bid, kMid + 1000, int32_t(fills) * kQty, trades, 1, 0);
+                    }
+                    s.ns += bench::now_ns() - t0;
+                    s.ops += matches;
+                    // put the liquidity back where it was taken
+                    for (const TradeBody& t : trades) {
+                        fx.book.add_resting(fx.next_id++, OrderSide::Ask, t.price_ticks, kQty);
+                    }
+                }
+                return s;
+            });
+        }
+
+        // --- best bid + best ask
+        runner.run("best_quote", {{"depth", depth}}, [&] {
+            constexpr uint64_t kQueries = 10'000;
+            const uint64_t t0 = bench::now_ns();
+            for (uint64_t i = 0; i < kQueries; ++i) {
+                int64_t bid_px, ask_px;
+                int32_t bid_qty, ask_qty;
+                fx.book.best_bid(bid_px, bid_qty);
+                fx.book.best_ask(ask_px, ask_qty);
+                bench::do_not_optimize(bid_px + ask_px + bid_qty + ask_qty);
+            }
+            return bench::Sample{bench::now_ns() - t0, kQueries};
+        });
+    }
+
+    // --- auction: orders accumulated without matching, prices +-100 ticks
+    // around kMid so roughly half of each side is executable
+    for (uint64_t orders : {10'000, 100'000, 1'000'000}) {
+        if (orders > opt.max_depth) {
+            break;
+        }
+        std::vector<AuctionOrder> flow = auction_flow(orders);
+        auto called = call_phase(flow);
+
+        runner.run("auction_price", {{"orders", orders}}, [&] {
+            constexpr uint64_t kCalls = 10;
+            const uint64_t t0 = bench::now_ns();
+            for (uint64_t i = 0; i < kCalls; ++i) {
+                bench::do_not_optimize(called->auction_price().volume);
+            }
+            return bench::Sample{bench::now_ns() - t0, kCalls};
+        });
+
+        // every repetition uncrosses its own freshly accumulated book; ns are per accumulated order
+        std::vector<TradeBody> trades;
+        std::vector<LevelUpdateBody> levels;
+        int64_t volume = 0;
+        runner.run("uncross", {{"orders", orders}}, [&] {
+            auto book = call_phase(flow);
+            trades.clear();
+            levels.clear();
+            const uint64_t t0 = bench::now_ns();
+            volume = book->uncross(book->auction_price(), trades, levels, 1);
+            return bench::Sample{bench::now_ns() - t0, orders};
+        });
+
+        // the same orders matched continuously, for comparison
+        OrderBook continuous;
+        std::vector<TradeBody> cont_trades;
+        int64_t cont_volume = 0;
+        for (const AuctionOrder& o : flow) {
+            const int32_t filled = continuous.match_taker(o.id, o.side, o.price_ticks, o.qty, cont_trades, 1,
+                                                          o.side == OrderSide::Bid ? 0 : 1);
+            cont_volume += filled;
+            if (filled < o.qty) {
+                continuous.add_resting(o.id, o.side, o.price_ticks, o.qty - filled);
+            }
+        }
+        std::set<int64_t> cont_prices;
+        for (const TradeBody& t : cont_trades) {
+            cont_prices.insert(t.price_ticks);
+        }
+        runner.report("auction_vs_continuous", {{"orders", orders}},
+                      {{"auction_trades", double(trades.size())},
+                       {"auction_volume", double(volume)},
+                       {"auction_prices", trades.empty() ? 0.0 : 1.0},
+                       {"continuous_trades", double(cont_trades.size())},
+                       {"continuous_volume", double(cont_volume)},
+                       {"continuous_prices", double(cont_prices.size())}});
+    }
+
+    runner.finish();
+    return 0;
+}
@@ -0,0 +1,77 @@
+// bench/bench_replay.cpp
+// Capture replay (replay.hpp), serial against partitioned by instrument over
+// 1..8 worker threads, on a generated flow over 16 instruments. Each rep
+// replays the whole capture into a sink that only counts, so ns_per_op is
+// per request including the split and merge passes; msgs/s is 1e9 over it.
+// Scaling needs that many free cores: with fewer, the threaded cases only
+// show the split / merge overhead.
+#include "bench_harness.hpp"
+#include "capture.hpp"
+#include "flow_gen.hpp"
+#include "replay.hpp"
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+static constexpr uint32_t kInstruments = 16;
+
+class CountingSink : public ReplaySink {
+public:
+    void on_result(const Header&, const AckBody& ack, std::span<const TradeBody> trades,
+                   std::span<const LevelUpdateBody>) override {
+        n += 1 + trades.size() + ack.status;
+    }
+    uint64_t n = 0;
+};
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    bench::Runner runner("replay", opt);
+    runner.calibrate();
+
+    const uint64_t events = std::min<uint64_t>(opt.max_depth, 1'000'000);
+    const std::string path = "/tmp/marketfeed_bench_replay_" + std::to_string(::getpid()) + ".cap";
+    {
+        CaptureWriter w;
+        if (!w.open(path, 1)) {
+            return 1;
+        }
+        FlowGenConfig cfg;
+        cfg.num_instruments = kInstruments;
+        FlowGenerator gen(cfg);
+        for (uint64_t i = 0; i < events; ++i) {
+            const FlowEvent ev = gen.next();
+            if (ev.type == MsgType::NEW) {
+                w.append(MsgType::NEW, ev.new_order, ev.ts_ns);
+            } else {
+                w.append(MsgType::CANCEL, ev.cancel, ev.ts_ns);
+            }
+        }
+        if (!w.close()) {
+            return 1;
+        }
+    }
+
+    CaptureFile cap;
+    if (!cap.open(path)) {
+        return 1;
+    }
+    for (const unsigned threads : {0u, 1u, 2u, 4u, 8u}) {
+        ReplayOptions ro;
+        ro.threads = threads;
+        ro.num_instruments = kInstruments;
+        runner.run("replay", {{"events", events}, {"threads", threads}}, [&] {
+            cap.rewind();
+            CountingSink sink;
+            const ReplayStats st = replay(cap, ro, sink);
+            bench::do_not_optimize(sink.n);
+            return bench::Sample{st.elapsed_ns, st.news + st.cancels};
+        });
+    }
+    std::remove(path.c_str());
+    runner.finish();
+    return 0;
+}
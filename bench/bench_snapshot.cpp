@@ -0,0 +1,53 @@
+// bench/bench_snapshot.cpp
+// Engine-thread cost of a book snapshot: copying level aggregates out of a
+// book holding 1M resting orders (--max-depth), for a few level densities.
+#include "bench_harness.hpp"
+#include "book_snapshot.hpp"
+#include "order_book.hpp"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    bench::Runner runner("snapshot", opt);
+    runner.calibrate();
+    const uint64_t total_orders = opt.max_depth;
+    const uint64_t levels_per_side[] = {100, 10'000, total_orders / 2};
+
+    for (uint64_t levels : levels_per_side) {
+        if (!runner.selected("snapshot", {{"orders", total_orders}, {"levels", 2 * levels}})) {
+            continue;
+        }
+        OrderBook book;
+        const uint64_t per_side = total_orders / 2;
+        uint64_t id = 1;
+        for (uint64_t i = 0; i < per_side; ++i) {
+            const int64_t offset = static_cast<int64_t>(i % levels);
+            book.add_resting(id++, OrderSide::Bid, 1'000'000 - offset, 10);
+            book.add_resting(id++, OrderSide::Ask, 1'000'001 + offset, 10);
+        }
+
+        bool ok = true;
+        runner.run("snapshot", {{"orders", book.num_orders()}, {"levels", 2 * levels}}, [&] {
+            BookSnapshot snap; // fresh per request, as the server does
+            const uint64_t t0 = bench::now_ns();
+            snap.md_seqno = 1;
+            snap.instrument_id = 1;
+            snap.found = true;
+            book.append_levels(snap.levels, 1);
+            const uint64_t t1 = bench::now_ns();
+            ok = ok && snap.levels.size() == 2 * levels;
+            return bench::Sample{t1 - t0, 1};
+        });
+        if (!ok) {
+            std::cerr << "bench_snapshot: unexpected level count\n";
+            return 1;
+        }
+    }
+    runner.finish();
+    return 0;
+}
@@ -0,0 +1,97 @@
+// bench/bench_startup.cpp
+// Listing a large instrument universe, presized from its hints versus the
+// lazy path (add_new_instrument by name, books grown as orders arrive):
+//  - list: time to build the engine, per instrument
+//  - opening_burst: the first messages after the open, generated flow spread
+//    over every instrument, on a freshly listed engine each repetition;
+//    opening_burst_latency reports the per-message tail over all of them
+// The expected_orders hint is twice the flow's mean resting orders per
+// instrument, as yesterday's statistics would give it.
+#include "bench_harness.hpp"
+#include "engine.hpp"
+#include "flow_gen.hpp"
+#include "instrument_universe.hpp"
+#include "latency_histogram.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+static std::unique_ptr<Engine> list(const std::vector<InstrumentSpec>& universe, bool presized) {
+    if (presized) {
+        return std::make_unique<Engine>(universe);
+    }
+    auto engine = std::make_unique<Engine>(std::span<const InstrumentSpec>{});
+    for (const InstrumentSpec& spec : universe) {
+        engine->add_new_instrument(spec.symbol);
+    }
+    return engine;
+}
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    constexpr uint32_t kInstruments = 20'000;
+    constexpr int kMessages = 1'000'000;
+
+    FlowGenConfig cfg;
+    cfg.num_instruments = kInstruments;
+    FlowGenerator gen(cfg);
+    std::vector<FlowEvent> flow;
+    flow.reserve(kMessages);
+    size_t peak_resting = 0;
+    for (int i = 0; i < kMessages; ++i) {
+        flow.push_back(gen.next());
+        peak_resting = std::max(peak_resting, gen.resting());
+    }
+
+    std::vector<InstrumentSpec> universe(kInstruments);
+    for (uint32_t i = 0; i < kInstruments; ++i) {
+        universe[i].symbol = "SYM" + std::to_string(i + 1);
+        universe[i].expected_orders = uint32_t(2 * peak_resting / kInstruments + 1);
+        universe[i].band_lo_ticks = cfg.mid_px / 2;
+        universe[i].band_hi_ticks = cfg.mid_px * 2;
+    }
+
+    bench::Runner runner("startup", opt);
+    runner.calibrate();
+    for (const bool presized : {false, true}) {
+        const bench::Params params{{"instruments", kInstruments}, {"presized", presized}};
+        runner.run("list", params, [&] {
+            const uint64_t t0 = bench::now_ns();
+            auto engine = list(universe, presized);
+            const uint64_t t1 = bench::now_ns();
+            bench::do_not_optimize(engine->num_instruments());
+            return bench::Sample{t1 - t0, kInstruments};
+        });
+
+        LatencyHistogram hist;
+        bench::Params burst = params;
+        burst.emplace_back("messages", flow.size());
+        runner.run("opening_burst", burst, [&] {
+            auto engine = list(universe, presized);
+            uint64_t total = 0;
+            for (const FlowEvent& ev : flow) {
+                const uint64_t t0 = bench::now_ns();
+                EngineResult res = ev.type == MsgType::NEW
+                                       ? engine->on_new(ev.new_order, (ev.new_order.flags & TIF_IOC) == 0)
+                                       : engine->on_cancel(ev.cancel);
+                const uint64_t ns = bench::now_ns() - t0;
+                bench::do_not_optimize(res.ack.exch_order_id);
+                hist.record(ns);
+                total += ns;
+            }
+            return bench::Sample{total, flow.size()};
+        });
+        if (hist.count() != 0) {
+            runner.report("opening_burst_latency", params,
+                          {{"p50_ns", double(hist.percentile(50))},
+                           {"p99_ns", double(hist.percentile(99))},
+                           {"p999_ns", double(hist.percentile(99.9))},
+                           {"max_ns", double(hist.max())}});
+        }
+    }
+    runner.finish();
+    return 0;
+}
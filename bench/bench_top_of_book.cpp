@@ -0,0 +1,192 @@
+// bench/bench_top_of_book.cpp
+// What the seqlock top-of-book cache (top_of_book.hpp) costs its writer, the
+// engine thread: a publish on its own, with 1 or 3 threads reading quotes
+// flat out on other cores (their reads pull the lines the writer dirties),
+// and a NEW + flush_bbo() batch with and without a cache attached. Also the
+// cost of a read. Reader threads avoid the writer's core; the cases with
+// readers are only meaningful with that many spare cores.
+#include "bench_harness.hpp"
+#include "engine.hpp"
+#include "top_of_book.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+static constexpr uint64_t kOps = 1'000'000;
+static constexpr uint64_t kQuotes = 1024; // prebuilt, so a publish is timed alone
+
+static BboBody quote(uint32_t instrument_id, uint64_t i) {
+    BboBody b{};
+    b.instrument_id = instrument_id;
+    b.bid_price_ticks = int64_t(1000 + i % 7);
+    b.ask_price_ticks = int64_t(1001 + i % 5);
+    b.bid_total_qty = int64_t(i);
+    b.ask_total_qty = int64_t(i + 1);
+    b.bid_order_count = uint32_t(i % 100);
+    b.ask_order_count = uint32_t(i % 90);
+    return b;
+}
+
+// Lets the calling thread run anywhere but the writer's core.
+static void avoid_cpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    if (cpu < 0 || sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return;
+    }
+    CPU_ZERO(&set);
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    for (long c = 0; c < n; ++c) {
+        if (c != cpu) {
+            CPU_SET(c, &set);
+        }
+    }
+    if (CPU_COUNT(&set) > 0) {
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+// Threads reading random instruments until stopped.
+struct Readers {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0};
+    std::vector<std::thread> threads;
+
+    Readers(const TopOfBookCache& cache, uint64_t n, uint32_t instruments, int writer_cpu) {
+        for (uint64_t r = 0; r < n; ++r) {
+            threads.emplace_back([&, r] {
+                avoid_cpu(writer_cpu);
+                uint64_t x = 0x9e3779b97f4a7c15ull * (r + 1);
+                uint64_t local = 0;
+                TopOfBook t;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    x ^= x << 13;
+                    x ^= x >> 7;
+                    x ^= x << 17;
+                    local += cache.read(1 + uint32_t(x % instruments), t);
+                }
+                reads.fetch_add(local, std::memory_order_relaxed);
+            });
+        }
+    }
+    ~Readers() {
+        stop.store(true, std::memory_order_relaxed);
+        for (std::thread& t : threads) {
+            t.join();
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    bench::Options opt;
+    if (!bench::parse_options(argc, argv, opt)) {
+        return 2;
+    }
+    bench::Runner runner("top_of_book", opt);
+    runner.calibrate();
+#ifdef __linux__
+    const int writer_cpu = sched_getcpu();
+#else
+    const int writer_cpu = -1;
+#endif
+
+    std::vector<BboBody> quotes(kQuotes);
+    for (uint64_t i = 0; i < kQuotes; ++i) {
+        quotes[i] = quote(0, i);
+    }
+    // instrument ids cycle through the cache; the fields through the prebuilt quotes
+    auto publish_ops = [&](TopOfBookCache& cache, uint32_t instruments, uint64_t& i) {
+        const uint64_t t0 = bench::now_ns();
+        uint32_t id = uint32_t(i % instruments);
+        for (uint64_t k = 0; k < kOps; ++k, ++i) {
+            BboBody q = quotes[i & (kQuotes - 1)];
+            id = id == instruments ? 1 : id + 1;
+            q.instrument_id = id;
+            cache.publish(q);
+        }
+        return bench::Sample{bench::now_ns() - t0, kOps};
+    };
+
+    // --- publish alone, over a footprint from one line to 20k lines
+    for (uint32_t instruments : {1u, 1000u, 20000u}) {
+        TopOfBookCache cache(instruments);
+        uint64_t i = 0;
+        runner.run("publish", {{"instruments", instruments}, {"readers", 0}}, [&] {
+            return publish_ops(cache, instruments, i);
+        });
+    }
+
+    // --- publish while other cores read the same lines
+    for (uint64_t readers : {1, 3}) {
+        for (uint32_t instruments : {1u, 1000u}) {
+            TopOfBookCache cache(instruments);
+            for (uint32_t id = 1; id <= instruments; ++id) {
+                cache.publish(quote(id, 0));
+            }
+            Readers rd(cache, readers, instruments, writer_cpu);
+            uint64_t i = 0;
+            runner.run("publish", {{"instruments", instruments}, {"readers", readers}}, [&] {
+                return publish_ops(cache, instruments, i);
+            });
+        }
+    }
+
+    // --- a read, no writer
+    {
+        constexpr uint32_t kInstruments = 1000;
+        TopOfBookCache cache(kInstruments);
+        for (uint32_t id = 1; id <= kInstruments; ++id) {
+            cache.publish(quote(id, id));
+        }
+        runner.run("read", {{"instruments", kInstruments}}, [&] {
+            TopOfBook t{};
+            int64_t sum = 0;
+            const uint64_t t0 = bench::now_ns();
+            for (uint64_t k = 0; k < kOps; ++k) {
+                cache.read(1 + uint32_t(k % kInstruments), t);
+                sum += t.bbo.bid_price_ticks;
+            }
+            const uint64_t ns = bench::now_ns() - t0;
+            bench::do_not_optimize(sum);
+            return bench::Sample{ns, kOps};
+        });
+    }
+
+    // --- engine batch of one top-changing NEW, with and without the cache
+    for (const bool attached : {false, true}) {
+        Engine engine;
+        TopOfBookCache cache(engine.num_instruments());
+        if (attached) {
+            engine.set_top_of_book(&cache);
+        }
+        std::vector<BboBody> bbos;
+        uint64_t i = 0;
+        runner.run("new_flush", {{"cache", attached}}, [&] {
+            OrderNewBody o{};
+            o.qty = 1;
+            const uint64_t t0 = bench::now_ns();
+            for (uint64_t k = 0; k < kOps / 10; ++k, ++i) {
+                // alternating bids and asks that never cross, each a new top
+                o.client_order_id = i + 1;
+                o.instrument_id = 1 + uint32_t(i % 3);
+                o.side = uint8_t(i / 3 & 1);
+                o.price_ticks = o.side == 0 ? int64_t(1'000'000 + i) : int64_t(1'000'000'000 - i);
+                engine.on_new(o, true);
+                bbos.clear();
+                engine.flush_bbo(bbos);
+            }
+            return bench::Sample{bench::now_ns() - t0, kOps / 10};
+        });
+    }
+    runner.finish();
+    return 0;
+}
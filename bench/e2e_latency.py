@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+# End-to-end order-entry latency: starts a fresh `server` per run, drives it
+# with `loadgen` (open loop, so requests are pipelined rather than one at a
+# time) over every order-entry transport the server offers, at a few rates,
+# and collects the RTT distributions plus the wire-in / engine / wire-out
+# split that loadgen derives from the ACK's engine timestamps.
+#
+#   bench/e2e_latency.py --server build/apps/server --loadgen build/apps/loadgen [--out e2e.json]
+#
+# Prints one JSON document (and a short table on stderr).
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+# transport -> (extra server args, extra loadgen args, path that appears once the server listens).
+# The server only accepts orders on its UNIX stream socket today; add entries here as transports appear.
+TRANSPORTS = {
+    "unix": ([], ["--socket", "/tmp/demo.sock"], "/tmp/demo.sock"),
+}
+
+
+def wait_for_path(path: str, timeout_s: float = 5.0) -> bool:
+    t0 = time.time()
+    while time.time() - t0 < timeout_s:
+        if os.path.exists(path):
+            return True
+        time.sleep(0.05)
+    return False
+
+
+def run_once(args, transport: str, rate: int) -> dict:
+    server_args, loadgen_args, ready = TRANSPORTS[transport]
+    try:
+        os.unlink(ready)
+    except FileNotFoundError:
+        pass
+    srv = subprocess.Popen([args.server, "--quiet"] + server_args,
+                           stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    try:
+        if not wait_for_path(ready):
+            raise RuntimeError(f"server did not start listening on {ready}")
+        cmd = [args.loadgen, "--rate", str(rate), "--count", str(args.count), "--instruments", args.instruments,
+               "--cancel-ratio", str(args.cancel_ratio), "--aggressive", str(args.aggressive),
+               "--json"] + loadgen_args
+        lg = subprocess.run(cmd, capture_output=True, text=True, timeout=args.count / rate + 30)
+        if lg.returncode != 0:
+            raise RuntimeError(f"loadgen exited with {lg.returncode}: {lg.stderr.strip()}")
+        report = json.loads(lg.stdout.strip().splitlines()[-1])
+    finally:
+        try:
+            srv.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            srv.kill()
+            srv.wait()
+    report.pop("benchmark", None)
+    return {"transport": transport, "rate": rate, **report}
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--server", required=True)
+    ap.add_argument("--loadgen", required=True)
+    ap.add_argument("--rates", default="10000,50000,100000", help="comma-separated target msg/s")
+    ap.add_argument("--count", type=int, default=100000, help="messages per run")
+    ap.add_argument("--transports", default=",".join(TRANSPORTS))
+    ap.add_argument("--instruments", default="1:3,2:1")
+    ap.add_argument("--cancel-ratio", type=float, default=0.2)
+    ap.add_argument("--aggressive", type=float, default=0.1)
+    ap.add_argument("--out", help="also write the JSON here")
+    args = ap.parse_args()
+
+    runs = []
+    for transport in args.transports.split(","):
+        if transport not in TRANSPORTS:
+            print(f"e2e_latency: unknown transport '{transport}' (have: {', '.join(TRANSPORTS)})", file=sys.stderr)
+            return 2
+        for rate in (int(r) for r in args.rates.split(",")):
+            runs.append(run_once(args, transport, rate))
+
+    print(f"{'transport':<10} {'rate':>8} {'lost':>6} {'rtt p50':>9} {'p99':>9} "
+          f"{'wire in':>9} {'engine':>9} {'wire out':>9}   (us, p50 unless noted)", file=sys.stderr)
+    for r in runs:
+        b = r["breakdown_ns"]
+        print(f"{r['transport']:<10} {r['rate']:>8} {r['lost']:>6} {r['rtt_uncorrected_ns']['p50'] / 1e3:>9.1f} "
+              f"{r['rtt_uncorrected_ns']['p99'] / 1e3:>9.1f} {b['wire_in']['p50'] / 1e3:>9.1f} "
+              f"{b['engine']['p50'] / 1e3:>9.2f} {b['wire_out']['p50'] / 1e3:>9.1f}", file=sys.stderr)
+
+    doc = json.dumps({"benchmark": "e2e_latency", "count": args.count, "runs": runs}, indent=1)
+    print(doc)
+    if args.out:
+        with open(args.out, "w") as f:
+            f.write(doc + "\n")
+    return 1 if any(r["lost"] for r in runs) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// Arena: engine-thread memory for book nodes and index tables, carved out of
+// large regions mapped with 2MB pages so a deep book touches few TLB entries.
+//  - Regions are tried as explicit huge pages (MAP_HUGETLB, needs a reserved
+//    hugetlbfs pool), then transparent huge pages (2MB-aligned mapping plus
+//    MADV_HUGEPAGE), then normal pages; a request for one kind falls back to
+//    the next, and backing() reports what the last region actually got
+//  - The first region is mapped on construction; pages are touched (and
+//    faulted in) only as blocks are handed out
+//  - Every region prefers the NUMA node of the thread that built the arena
+//    (mbind MPOL_PREFERRED), so build it on the engine thread
+//  - Blocks up to kMaxSmall bytes come in 16-byte size classes, larger ones
+//    in power-of-two classes up to kMaxPooled, each class with its own free
+//    list; anything larger (big hash bucket arrays) gets a mapping of its own
+//  - Single-threaded, like the books it serves; memory goes back to the OS
+//    only when the arena is destroyed (or, for large blocks, freed)
+// -----------------------------------------------------------------------------
+
+enum class ArenaPages : uint8_t {
+    Auto,        // explicit, else transparent, else normal
+    Explicit,    // MAP_HUGETLB
+    Transparent, // MADV_HUGEPAGE
+    Normal,      // 4K pages
+};
+
+const char* arena_pages_name(ArenaPages p);
+// "auto" / "explicit" / "transparent" / "normal"; false for anything else.
+bool parse_arena_pages(const char* s, ArenaPages& out);
+
+struct ArenaConfig {
+    size_t region_bytes = size_t(64) << 20; // mapped at a time, rounded up to 2MB
+    ArenaPages pages = ArenaPages::Auto;
+    bool bind_local_node = true;
+};
+
+class Arena {
+public:
+    static constexpr size_t kHugePage = size_t(2) << 20;
+    static constexpr size_t kAlign = 16;
+    static constexpr size_t kMaxSmall = 512;
+    static constexpr size_t kMaxPooled = size_t(1) << 20;
+
+    explicit Arena(const ArenaConfig& cfg = {});
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // kAlign-aligned; throws std::bad_alloc if no region can be mapped.
+    void* allocate(size_t bytes);
+    void deallocate(void* p, size_t bytes) noexcept;
+
+    ArenaPages backing() const { return backing_; }
+    int node() const { return node_; } // NUMA node the regions prefer; -1 if not bound
+    size_t mapped_bytes() const { return mapped_bytes_; }
+    size_t used_bytes() const { return used_bytes_; } // live blocks, rounded to their class
+    size_t num_regions() const { return regions_.size(); }
+
+private:
+    static constexpr size_t kNumSmall = kMaxSmall / kAlign;
+    static constexpr size_t kNumClasses = kNumSmall + 11; // then 1KB .. 1MB
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    struct Mapping {
+        void* addr;
+        size_t len;
+    };
+
+    static size_t class_of(size_t bytes);
+    static size_t class_size(size_t cls);
+
+    // Maps at least len bytes with the best backing available; nullptr on failure.
+    void* map(size_t& len);
+    void* carve(size_t bytes);
+
+    ArenaConfig cfg_;
+    ArenaPages backing_ = ArenaPages::Normal;
+    ArenaPages next_try_;  // where map() starts; moves down after a failure
+    int node_ = -1;
+    char* cur_ = nullptr;  // bump pointer in the newest region
+    char* end_ = nullptr;
+    std::array<FreeBlock*, kNumClasses> free_{};
+    std::vector<Mapping> regions_;
+    std::unordered_map<void*, Mapping> large_; // blocks above kMaxPooled
+    size_t mapped_bytes_ = 0;
+    size_t used_bytes_ = 0;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "spsc_ring.hpp"
+#include "wire.hpp"
+
+// -----------------------------------------------------------------------------
+// BarAggregator: streaming OHLCV / VWAP time bars over the engine's trades.
+//  - One open bar per (instrument, interval), stored structure-of-arrays in
+//    fixed arrays sized at construction; a trade touches the slots of its
+//    instrument only (adjacent), so on_trade() is O(intervals), no allocation
+//  - Bars are aligned to multiples of their interval on the caller's clock
+//    (the server passes wall time, clk::to_wall_ns()). A bar closes when a
+//    trade lands in a later interval, or when close_expired() sees its
+//    interval has ended; a trade stamped before the open bar (the clock
+//    stepped back) goes into that bar
+//  - Completed bars go into a bounded SPSC ring for whoever publishes them;
+//    if it is full the bar is dropped and counted, the engine never waits
+// -----------------------------------------------------------------------------
+
+class BarAggregator {
+public:
+    // Instrument ids 0 .. max_instruments-1; intervals in ns (e.g. 1s, 1min).
+    BarAggregator(uint32_t max_instruments, std::vector<uint64_t> intervals_ns, size_t out_capacity = 4096);
+
+    BarAggregator(const BarAggregator&) = delete;
+    BarAggregator& operator=(const BarAggregator&) = delete;
+
+    // Producer (engine) thread.
+    void on_trade(const TradeBody& t, uint64_t ts_ns);
+    void on_trades(std::span<const TradeBody> trades, uint64_t ts_ns) {
+        for (const TradeBody& t : trades) {
+            on_trade(t, ts_ns);
+        }
+    }
+    // Closes every open bar whose interval ended at or before now_ns. Cheap
+    // when nothing is due; call it from the event loop's timer.
+    void close_expired(uint64_t now_ns);
+
+    // Consumer side: completed bars in the order they closed.
+    bool try_pop(BarBody& out) { return out_.try_pop(out); }
+
+    // The bar still being built; false if it has no trades yet.
+    bool current(uint32_t instrument_id, size_t interval_index, BarBody& out) const;
+
+    const std::vector<uint64_t>& intervals() const { return intervals_; }
+    uint64_t bars_closed() const { return bars_closed_; }
+    uint64_t bars_dropped() const { return bars_dropped_; }     // ring was full
+    uint64_t trades_ignored() const { return trades_ignored_; } // instrument id out of range
+
+private:
+    size_t slot(uint32_t instrument_id, size_t k) const { return size_t(instrument_id) * intervals_.size() + k; }
+    BarBody make_bar(size_t s) const;
+    void close(size_t s);
+
+    uint32_t max_instruments_;
+    std::vector<uint64_t> intervals_;
+
+    // open bar state, indexed by slot(); count_ == 0 means no open bar
+    std::vector<int64_t>  open_;
+    std::vector<int64_t>  high_;
+    std::vector<int64_t>  low_;
+    std::vector<int64_t>  close_;
+    std::vector<int64_t>  volume_;
+    std::vector<int64_t>  notional_;
+    std::vector<uint64_t> start_;
+    std::vector<uint32_t> count_;
+
+    uint64_t next_expiry_ = UINT64_MAX; // earliest end among open bars (may be stale-early)
+    uint64_t bars_closed_ = 0;
+    uint64_t bars_dropped_ = 0;
+    uint64_t trades_ignored_ = 0;
+    SpscRing<BarBody> out_;
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "wire.hpp"
+
+// -----------------------------------------------------------------------------
+// Book snapshots for late joiners.
+//  - BookSnapshot: level-aggregated state of one instrument as of md_seqno
+//    (produced by Engine::snapshot on the engine thread, O(levels))
+//  - SnapshotSync (consumer_book.hpp): client-side helper that buffers
+//    incremental frames, applies a snapshot, then replays the newer ones
+// -----------------------------------------------------------------------------
+
+struct BookSnapshot {
+    uint64_t md_seqno = 0;      // last incremental frame reflected in levels
+    uint32_t instrument_id = 0;
+    bool     found = false;     // false if the instrument does not exist
+    std::vector<LevelUpdateBody> levels; // bids best-first, then asks best-first
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+
+#include "wire.hpp"
+
+// -----------------------------------------------------------------------------
+// Capture files: recorded order-entry flow (NEW / CANCEL requests), or the
+// market data it produces (TRADE / BOOK_UPDATE, written by replay --md-out).
+//  - A 32-byte CaptureFileHeader followed by wire frames exactly as a client
+//    sends them (Header + body). Header.seqno numbers the frames from 1 and
+//    Header.ts_ns is the arrival time relative to the start of the capture.
+//  - Every frame is a multiple of 8 bytes, so an mmap'd file can be walked in
+//    place without copying.
+//  - In a market-data capture Header.seqno is the md seqno.
+//  - CANCEL frames carry the exch_order_id the target got when the capture
+//    was made, i.e. they assume replay into a fresh Engine (which numbers
+//    accepted NEWs from 1).
+// -----------------------------------------------------------------------------
+
+inline constexpr char kCaptureMagic[8] = {'M', 'F', 'C', 'A', 'P', 'T', 'R', '\0'};
+inline constexpr uint32_t kCaptureVersion = 1;
+
+struct CaptureFileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_bytes;  // sizeof(CaptureFileHeader); frames start here
+    uint64_t num_frames;
+    uint64_t seed;          // generator seed, 0 if not synthetic
+};
+static_assert(sizeof(CaptureFileHeader) == 32, "CaptureFileHeader must be 32 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<CaptureFileHeader>, "CaptureFileHeader must be trivially copyable");
+
+class CaptureWriter {
+public:
+    CaptureWriter() = default;
+    ~CaptureWriter();
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    // Returns false (and logs) if the file can't be created.
+    bool open(const std::string& path, uint64_t seed);
+    // Patches the frame count into the file header. Returns false on I/O error.
+    bool close();
+
+    template <typename BodyT>
+    void append(MsgType type, const BodyT& body, uint64_t ts_ns) {
+        static_assert(sizeof(BodyT) % 8 == 0, "capture frames must stay 8-byte aligned");
+        Header h{};
+        h.type = static_cast<uint8_t>(type);
+        h.version = kProtocolVersion;
+        h.size = sizeof(Header) + sizeof(BodyT);
+        h.seqno = ++frames_;
+        h.ts_ns = ts_ns;
+        uint8_t frame[sizeof(Header) + sizeof(BodyT)];
+        std::memcpy(frame, &h, sizeof(Header));
+        std::memcpy(frame + sizeof(Header), &body, sizeof(BodyT));
+        if (std::fwrite(frame, sizeof(frame), 1, file_) != 1) {
+            failed_ = true;
+        }
+    }
+
+    uint64_t frames() const { return frames_; }
+
+private:
+    std::FILE* file_ = nullptr;
+    uint64_t frames_ = 0;
+    bool failed_ = false;
+};
+
+// Read-only, mmap'd view of a capture file.
+class CaptureFile {
+public:
+    struct Frame {
+        Header hdr;
+        std::span<const uint8_t> body;
+    };
+
+    CaptureFile() = default;
+    ~CaptureFile();
+    CaptureFile(const CaptureFile&) = delete;
+    CaptureFile& operator=(const CaptureFile&) = delete;
+
+    // Maps the file and validates the header and every frame boundary.
+    // Returns false (and logs) on a missing or malformed file.
+    bool open(const std::string& path);
+
+    const CaptureFileHeader& header() const { return hdr_; }
+    uint64_t num_frames() const { return hdr_.num_frames; }
+
+    // Sequential access: next() returns false past the last frame.
+    bool next(Frame& out) {
+        if (pos_ >= size_) {
+            return false;
+        }
+        std::memcpy(&out.hdr, data_ + pos_, sizeof(Header));
+        out.body = std::span<const uint8_t>(data_ + pos_ + sizeof(Header), out.hdr.size - sizeof(Header));
+        pos_ += out.hdr.size;
+        return true;
+    }
+    void rewind() { pos_ = hdr_.header_bytes; }
+
+    // Raw frame bytes (everything after the file header), e.g. to send as-is.
+    std::span<const uint8_t> frames() const {
+        return std::span<const uint8_t>(data_ + hdr_.header_bytes, size_ - hdr_.header_bytes);
+    }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t pos_ = 0;
+    CaptureFileHeader hdr_{};
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+#include "spsc_ring.hpp" // kCacheLine
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MARKETFEED_HAVE_TSC 1
+#endif
+
+// -----------------------------------------------------------------------------
+// clk: the timestamp source for the engine and the gateways.
+//  - now_ns() is in steady_clock nanoseconds (CLOCK_MONOTONIC), so stamps
+//    taken by different processes on one host compare directly (loadgen
+//    splits RTTs with the engine's ACK stamps)
+//  - With an invariant TSC it reads the counter and scales it: rdtsc, a
+//    few relaxed loads, a multiply. Calibrated against steady_clock on first
+//    use, then re-anchored at doubling intervals (up to kMaxResyncNs); each
+//    resync refits the rate over everything since the first anchor, so the
+//    drift from steady_clock stays within a few hundred ns
+//  - Without one (or with MARKETFEED_CLOCK=steady, or select(Steady)) every
+//    call is steady_clock::now()
+//  - Stamps stay steady-clock; to_wall_ns() converts one to system_clock
+//    time when it is shown
+// -----------------------------------------------------------------------------
+
+namespace clk {
+
+enum class Source : uint8_t { Tsc, Steady };
+
+inline constexpr uint64_t kMaxResyncNs = 1'000'000'000;
+
+namespace detail {
+
+__extension__ typedef unsigned __int128 u128;
+
+// TSC -> ns: ns0 + ((tsc - tsc0) * mult >> 32). Two copies: a resync writes
+// the idle one, then bumps `version` (conversions[version & 1] is current).
+// A reader that finds version changed under it retries on the slow path, so
+// it never mixes a stale tsc or a half-written copy with the new anchor.
+struct alignas(kCacheLine) Conversion {
+    std::atomic<uint64_t> tsc0{0};
+    std::atomic<uint64_t> ns0{0};
+    std::atomic<uint64_t> mult{0};      // ns per tick, 32.32 fixed point
+    std::atomic<uint64_t> resync_at{0}; // tsc past which the slow path re-anchors; 0 = TSC not in use
+};
+
+inline Conversion conversions[2];
+inline std::atomic<uint64_t> version{0};
+
+// First call, resync and steady_clock fallback.
+uint64_t slow_now_ns() noexcept;
+
+inline uint64_t scale(const Conversion& c, uint64_t tsc) noexcept {
+    const uint64_t delta = tsc - c.tsc0.load(std::memory_order_relaxed);
+    return c.ns0.load(std::memory_order_relaxed) +
+           static_cast<uint64_t>((u128(delta) * c.mult.load(std::memory_order_relaxed)) >> 32);
+}
+
+} // namespace detail
+
+inline uint64_t now_ns() noexcept {
+#ifdef MARKETFEED_HAVE_TSC
+    const uint64_t v = detail::version.load(std::memory_order_acquire);
+    const detail::Conversion& c = detail::conversions[v & 1];
+    const uint64_t tsc = __rdtsc();
+    if (tsc < c.resync_at.load(std::memory_order_relaxed)) [[likely]] {
+        const uint64_t ns = detail::scale(c, tsc);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (detail::version.load(std::memory_order_relaxed) == v) [[likely]] {
+            return ns;
+        }
+    }
+#endif
+    return detail::slow_now_ns();
+}
+
+// Picks the source (Tsc falls back to Steady if the TSC is not invariant) and
+// calibrates; returns the one in use. Optional: now_ns() does this on first
+// use, honouring MARKETFEED_CLOCK=steady.
+Source select(Source preferred);
+Source source();
+
+// system_clock ns for a now_ns() stamp (offset taken at the last resync).
+uint64_t to_wall_ns(uint64_t steady_ns) noexcept;
+
+// TSC ticks per second as calibrated so far; 0 on the steady_clock source.
+double tsc_hz();
+
+} // namespace clk
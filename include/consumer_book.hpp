@@ -0,0 +1,361 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "book_snapshot.hpp"
+#include "codec.hpp"
+#include "wire.hpp"
+
+// -----------------------------------------------------------------------------
+// Consumer-side order books rebuilt from the market-data feed.
+//  - ConsumerBook: one instrument's levels in flat per-side arrays, keys and
+//    aggregates stored separately. Both sides keep the best level last, so the
+//    usual churn at the top of the book inserts and erases at the end and a
+//    lookup there is a short backwards scan
+//  - ConsumerBooks: every instrument, indexed by instrument id. on_frame()
+//    checks the global md seqno and routes BOOK_UPDATE / TRADE frames
+//  - top() copies the best N levels into caller storage; nothing allocates
+//    once the arrays have reached their working size
+//  - SnapshotSync: one instrument joined late, from a snapshot plus the
+//    frames buffered meanwhile, kept in a ConsumerBook
+// -----------------------------------------------------------------------------
+
+struct ConsumerLevel {
+    int64_t  price_ticks = 0;
+    int64_t  total_qty = 0;
+    uint32_t order_count = 0;
+};
+
+class ConsumerBook {
+public:
+    // ADD / UPDATE set the level, DELETE removes it.
+    void apply(const LevelUpdateBody& u) {
+        Side& s = sides_[u.side & 1];
+        const int64_t key = key_of(u.side, u.price_ticks);
+        const size_t i = s.lower(key);
+        const bool found = i < s.keys.size() && s.keys[i] == key;
+        if (u.action == static_cast<uint8_t>(LevelAction::DELETE)) {
+            if (found) {
+                s.keys.erase(s.keys.begin() + std::ptrdiff_t(i));
+                s.aggs.erase(s.aggs.begin() + std::ptrdiff_t(i));
+            }
+            return;
+        }
+        if (found) {
+            s.aggs[i] = Agg{u.total_qty, u.order_count};
+        } else {
+            s.keys.insert(s.keys.begin() + std::ptrdiff_t(i), key);
+            s.aggs.insert(s.aggs.begin() + std::ptrdiff_t(i), Agg{u.total_qty, u.order_count});
+        }
+    }
+
+    // Trades don't move levels (the BOOK_UPDATEs that follow do); they only
+    // feed the last-trade and volume statistics.
+    void apply(const TradeBody& t) {
+        last_trade_px_ = t.price_ticks;
+        last_trade_qty_ = t.qty;
+        volume_ += t.qty;
+        ++num_trades_;
+    }
+
+    // Replace the levels with a snapshot's (trade statistics are kept).
+    void load(const BookSnapshot& snap) {
+        clear_levels();
+        for (const LevelUpdateBody& u : snap.levels) {
+            apply(u);
+        }
+    }
+
+    // Best-first copy of up to out.size() levels; returns how many were written.
+    size_t top(uint8_t side, std::span<ConsumerLevel> out) const {
+        const Side& s = sides_[side & 1];
+        const size_t n = std::min(out.size(), s.keys.size());
+        for (size_t k = 0; k < n; ++k) {
+            const size_t i = s.keys.size() - 1 - k;
+            out[k] = ConsumerLevel{price_of(side, s.keys[i]), s.aggs[i].total_qty, s.aggs[i].order_count};
+        }
+        return n;
+    }
+
+    bool best(uint8_t side, ConsumerLevel& out) const { return top(side, std::span<ConsumerLevel>(&out, 1)) == 1; }
+
+    bool level(uint8_t side, int64_t price_ticks, ConsumerLevel& out) const {
+        const Side& s = sides_[side & 1];
+        const int64_t key = key_of(side, price_ticks);
+        const size_t i = s.lower(key);
+        if (i == s.keys.size() || s.keys[i] != key) {
+            return false;
+        }
+        out = ConsumerLevel{price_ticks, s.aggs[i].total_qty, s.aggs[i].order_count};
+        return true;
+    }
+
+    size_t num_levels(uint8_t side) const { return sides_[side & 1].keys.size(); }
+    int64_t last_trade_px() const { return last_trade_px_; }
+    int32_t last_trade_qty() const { return last_trade_qty_; }
+    int64_t volume() const { return volume_; }
+    uint64_t num_trades() const { return num_trades_; }
+
+    // Empties the book but keeps the arrays' capacity.
+    void clear() {
+        clear_levels();
+        last_trade_px_ = 0;
+        last_trade_qty_ = 0;
+        volume_ = 0;
+        num_trades_ = 0;
+    }
+
+private:
+    struct Agg {
+        int64_t  total_qty;
+        uint32_t order_count;
+    };
+
+    // Keys ascend with the best level last: bids by price, asks by -price.
+    struct Side {
+        std::vector<int64_t> keys;
+        std::vector<Agg> aggs;
+
+        // First index whose key is >= key. Scans the last few slots (the top
+        // of the book, where most updates land) before binary searching.
+        size_t lower(int64_t key) const {
+            static constexpr size_t kScan = 8;
+            size_t i = keys.size();
+            const size_t stop = i > kScan ? i - kScan : 0;
+            while (i > stop && keys[i - 1] >= key) {
+                --i;
+            }
+            if (i == stop && stop > 0) {
+                return size_t(std::lower_bound(keys.begin(), keys.begin() + std::ptrdiff_t(stop), key) - keys.begin());
+            }
+            return i;
+        }
+    };
+
+    static int64_t key_of(uint8_t side, int64_t price_ticks) { return (side & 1) == 0 ? price_ticks : -price_ticks; }
+    static int64_t price_of(uint8_t side, int64_t key) { return (side & 1) == 0 ? key : -key; }
+
+    void clear_levels() {
+        for (Side& s : sides_) {
+            s.keys.clear();
+            s.aggs.clear();
+        }
+    }
+
+    Side sides_[2]; // [0]=bids, [1]=asks
+    int64_t last_trade_px_ = 0;
+    int32_t last_trade_qty_ = 0;
+    int64_t volume_ = 0;
+    uint64_t num_trades_ = 0;
+};
+
+// Books for every instrument on one feed. Frames must come in md seqno order:
+// a frame past the next expected seqno is reported as a Gap and not applied,
+// so the caller can fetch the missing range (retransmit) and feed the frame
+// again, or jump with set_next_seqno() after loading snapshots.
+class ConsumerBooks {
+public:
+    enum class Result : uint8_t {
+        Applied,   // BOOK_UPDATE or TRADE applied
+        Skipped,   // in sequence, but not a book frame (e.g. BBO)
+        Duplicate, // seqno already seen
+        Gap,       // seqno past next_seqno(); nothing applied
+    };
+
+    static constexpr uint32_t kMaxInstruments = 1u << 16; // ids at or above this are ignored
+
+    // Throws (via codec) if a book frame's body has the wrong size.
+    Result on_frame(const Header& h, std::span<const uint8_t> body) {
+        if (h.seqno < next_seqno_) {
+            return Result::Duplicate;
+        }
+        if (h.seqno > next_seqno_) {
+            ++gaps_;
+            return Result::Gap;
+        }
+        ++next_seqno_;
+        if (h.type == static_cast<uint8_t>(MsgType::BOOK_UPDATE)) {
+            const auto u = codec::decode_body<LevelUpdateBody>(body);
+            if (ConsumerBook* b = book_for(u.instrument_id)) {
+                b->apply(u);
+                return Result::Applied;
+            }
+        } else if (h.type == static_cast<uint8_t>(MsgType::TRADE)) {
+            const auto t = codec::decode_body<TradeBody>(body);
+            if (ConsumerBook* b = book_for(t.instrument_id)) {
+                b->apply(t);
+                return Result::Applied;
+            }
+        }
+        return Result::Skipped;
+    }
+
+    // nullptr if nothing has been seen for that instrument (no book frame,
+    // no snapshot) since construction or reset(). A book stays where it is
+    // while others are added, so the pointer outlives later frames.
+    const ConsumerBook* book(uint32_t instrument_id) const {
+        return instrument_id < books_.size() && seen_[instrument_id] ? &books_[instrument_id] : nullptr;
+    }
+
+    // Loads one instrument's snapshot. Call set_next_seqno(snap.md_seqno + 1)
+    // once every instrument of interest is loaded.
+    void load(const BookSnapshot& snap) {
+        if (ConsumerBook* b = book_for(snap.instrument_id)) {
+            b->load(snap);
+        }
+    }
+
+    uint64_t next_seqno() const { return next_seqno_; }
+    void set_next_seqno(uint64_t seqno) { next_seqno_ = seqno; }
+    uint64_t gaps() const { return gaps_; }
+
+    // Empties every book (capacity kept) and expects seqno 1 again.
+    void reset() {
+        for (ConsumerBook& b : books_) {
+            b.clear();
+        }
+        std::fill(seen_.begin(), seen_.end(), uint8_t(0));
+        next_seqno_ = 1;
+        gaps_ = 0;
+    }
+
+private:
+    ConsumerBook* book_for(uint32_t instrument_id) {
+        if (instrument_id >= kMaxInstruments) {
+            return nullptr;
+        }
+        if (instrument_id >= books_.size()) {
+            books_.resize(size_t(instrument_id) + 1);
+            seen_.resize(books_.size());
+        }
+        seen_[instrument_id] = 1;
+        return &books_[instrument_id];
+    }
+
+    std::deque<ConsumerBook> books_;  // indexed by instrument id; growing never moves a book
+    std::vector<uint8_t> seen_;       // by instrument id: a book frame or snapshot arrived
+    uint64_t next_seqno_ = 1;
+    uint64_t gaps_ = 0;
+};
+
+// Usage: feed every market-data frame (in seqno order) through on_frame() from
+// the moment you subscribe, request a snapshot, then apply_snapshot() it.
+// md seqnos are global (trades and other instruments share the sequence), so
+// gaps are tracked over all frames, not only this instrument's.
+class SnapshotSync {
+public:
+    enum class State : uint8_t {
+        Buffering, // waiting for a snapshot
+        Synced,    // book is live
+        Stale,     // gap while synced: fill it from the retransmit server or reset()
+    };
+
+    using Level = ConsumerLevel;
+
+    explicit SnapshotSync(uint32_t instrument_id) : instrument_id_(instrument_id) {}
+
+    State state() const { return state_; }
+    uint64_t last_seqno() const { return last_seqno_; }
+
+    // Returns false on a sequence gap. While buffering, a gap just restarts the
+    // buffer; once synced it moves to Stale and the frame is not applied.
+    bool on_frame(const Header& h, std::span<const uint8_t> body) {
+        const bool is_level = h.type == static_cast<uint8_t>(MsgType::BOOK_UPDATE);
+        LevelUpdateBody u{};
+        if (is_level) {
+            u = codec::decode_body<LevelUpdateBody>(body);
+        }
+        const bool mine = is_level && u.instrument_id == instrument_id_;
+
+        if (state_ == State::Buffering) {
+            bool contiguous = true;
+            if (buffered_last_ != 0 && h.seqno != buffered_last_ + 1) {
+                contiguous = false;
+                pending_.clear();
+                buffered_first_ = 0;
+            }
+            if (buffered_first_ == 0) {
+                buffered_first_ = h.seqno;
+            }
+            buffered_last_ = h.seqno;
+            if (mine) {
+                pending_.emplace_back(h.seqno, u);
+            }
+            return contiguous;
+        }
+
+        if (state_ == State::Stale) {
+            return false;
+        }
+        if (h.seqno <= last_seqno_) {
+            return true; // duplicate (e.g. retransmitted twice)
+        }
+        if (h.seqno != last_seqno_ + 1) {
+            state_ = State::Stale;
+            return false;
+        }
+        last_seqno_ = h.seqno;
+        if (mine) {
+            book_.apply(u);
+        }
+        return true;
+    }
+
+    // Returns false if the buffered frames don't reach back to the snapshot
+    // (snapshot older than the first buffered frame); request a newer one.
+    bool apply_snapshot(const BookSnapshot& snap) {
+        if (!snap.found || snap.instrument_id != instrument_id_) {
+            return false;
+        }
+        if (buffered_first_ != 0 && buffered_first_ > snap.md_seqno + 1) {
+            return false;
+        }
+        book_.load(snap);
+        for (const auto& [seq, u] : pending_) {
+            if (seq > snap.md_seqno) {
+                book_.apply(u);
+            }
+        }
+        last_seqno_ = std::max(snap.md_seqno, buffered_last_);
+        pending_.clear();
+        state_ = State::Synced;
+        return true;
+    }
+
+    // Drop the book and start buffering again (after an unrecoverable gap).
+    void reset() {
+        book_.clear();
+        pending_.clear();
+        buffered_first_ = buffered_last_ = last_seqno_ = 0;
+        state_ = State::Buffering;
+    }
+
+    bool best_bid(int64_t& px, Level& level) const { return best(0, px, level); }
+    bool best_ask(int64_t& px, Level& level) const { return best(1, px, level); }
+    bool level(uint8_t side, int64_t px, Level& out) const { return book_.level(side, px, out); }
+    size_t num_levels(uint8_t side) const { return book_.num_levels(side); }
+    // The instrument's levels; only meaningful once Synced.
+    const ConsumerBook& book() const { return book_; }
+
+private:
+    bool best(uint8_t side, int64_t& px, Level& level) const {
+        if (!book_.best(side, level)) {
+            return false;
+        }
+        px = level.price_ticks;
+        return true;
+    }
+
+    uint32_t instrument_id_;
+    State state_ = State::Buffering;
+    uint64_t last_seqno_ = 0;
+    uint64_t buffered_first_ = 0;
+    uint64_t buffered_last_ = 0;
+    std::vector<std::pair<uint64_t, LevelUpdateBody>> pending_;
+    ConsumerBook book_;
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "arena.hpp"
+
+// -----------------------------------------------------------------------------
+// CountingAllocator: std-compatible allocator that forwards to operator new
+// and keeps a running total in a MemoryCounter it points at.
+//  - Stateful: a container and every rebound copy (list nodes, map nodes,
+//    hash buckets) charge the same counter, so one counter per data structure
+//    answers "how many bytes does this structure hold right now"
+//  - Counts requested bytes; the heap's own per-block overhead is not
+//    included (compare with RSS, see bench/bench_memory.cpp)
+//  - The counter must outlive the container (declare it first)
+//  - Given an Arena (arena.hpp), blocks come from it instead of the heap;
+//    the arena must outlive the container too
+// -----------------------------------------------------------------------------
+
+struct MemoryCounter {
+    int64_t bytes = 0;       // live bytes
+    int64_t blocks = 0;      // live allocations
+    int64_t peak_bytes = 0;  // high-water mark of bytes
+
+    MemoryCounter& operator+=(const MemoryCounter& o) {
+        bytes += o.bytes;
+        blocks += o.blocks;
+        peak_bytes += o.peak_bytes; // sum of peaks: an upper bound for the combined peak
+        return *this;
+    }
+};
+
+template <typename T>
+class CountingAllocator {
+public:
+    using value_type = T;
+
+    explicit CountingAllocator(MemoryCounter* counter, Arena* arena = nullptr) noexcept
+        : counter_(counter), arena_(arena) {}
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept : counter_(other.counter()), arena_(other.arena()) {}
+
+    T* allocate(size_t n) {
+        static_assert(alignof(T) <= Arena::kAlign, "Arena blocks are only 16-byte aligned");
+        T* p = static_cast<T*>(arena_ ? arena_->allocate(n * sizeof(T)) : ::operator new(n * sizeof(T)));
+        counter_->bytes += static_cast<int64_t>(n * sizeof(T));
+        counter_->blocks += 1;
+        if (counter_->bytes > counter_->peak_bytes) {
+            counter_->peak_bytes = counter_->bytes;
+        }
+        return p;
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        counter_->bytes -= static_cast<int64_t>(n * sizeof(T));
+        counter_->blocks -= 1;
+        if (arena_) {
+            arena_->deallocate(p, n * sizeof(T));
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    MemoryCounter* counter() const noexcept { return counter_; }
+    Arena* arena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>& other) const noexcept {
+        return counter_ == other.counter() && arena_ == other.arena();
+    }
+
+private:
+    MemoryCounter* counter_;
+    Arena* arena_;
+};
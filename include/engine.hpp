@@ -1,34 +1,173 @@
 #pragma once
+#include <memory>
+#include <span>
 #include <vector>
 #include <unordered_map>
 #include <string>
 
+#include "arena.hpp"
+#include "book_snapshot.hpp"
+#include "clock.hpp"
+#include "instrument_universe.hpp"
 #include "order_book.hpp"
+#include "timer_wheel.hpp"
+#include "top_of_book.hpp"
 #include "wire.hpp"
 
 struct EngineResult {
     AckBody ack;
     std::vector<TradeBody> trades;
+    std::vector<LevelUpdateBody> levels; // book changes caused by this request, in order
 };
 
 class Engine {
 public:
-    Engine();
-    EngineResult on_new(const OrderNewBody& new_order, bool rest_leftover);
-    EngineResult on_cancel(const OrderCancelBody& cancel);
+    // With an arena (arena.hpp), every book's levels, order nodes and id
+    // index live in it; build the engine on the thread that will run it, so
+    // the arena prefers that thread's NUMA node.
+    explicit Engine(std::unique_ptr<Arena> arena = nullptr);
+    // Instruments 1..N from a universe (see instrument_universe.hpp), every
+    // book and per-instrument table presized from its hints.
+    explicit Engine(std::span<const InstrumentSpec> universe, std::unique_ptr<Arena> arena = nullptr);
+    // session_id owns whatever rests (0 if none), for mass cancels. What
+    // rests of a TIF_GTT order expires expire_after_s seconds after receipt,
+    // of a TIF_DAY order at the day end; NACK for both flags, a GTT order
+    // without a lifetime, or a DAY order when no day end is ahead. A
+    // session's resting orders are indexed by client_order_id (when
+    // nonzero), and a NEW reusing a live one is a NACK before it can trade.
+    EngineResult on_new(const OrderNewBody& new_order, bool rest_leftover, uint32_t session_id = 0);
+    // on_new()'s checks of the order alone (fields, instrument, TIF), as
+    // they stand at recv_ns; on_new() also refuses an IOC in auction and a
+    // duplicate client order id. Only an order that passes gets an exch id.
+    bool valid_new(const OrderNewBody& new_order, uint64_t recv_ns) const;
+    // The exch id the next accepted NEW gets (ids count up from 1 by
+    // default). Replay sets it to number orders as a single engine would
+    // when the flow is split over several; ids must not repeat in a book.
+    void set_next_exch_id(uint64_t exch_order_id) { next_exch_id_ = exch_order_id; }
+    // Cancels by exch_order_id, or with exch_order_id 0 by the session's
+    // client_order_id (instrument_id may then be 0; if set it must match).
+    // The ACK carries the exchange id cancelled.
+    EngineResult on_cancel(const OrderCancelBody& cancel, uint32_t session_id = 0);
+    // Cancels session_id's resting orders (every session's with kAnyOwner)
+    // matching the instrument and side filters. One ACK carries the count in
+    // cancelled_count; levels lists every level changed, instrument by
+    // instrument in id order. A session's orders are found through its order
+    // list; kAnyOwner drops whole levels. NACK for an unknown instrument or a
+    // bad side.
+    EngineResult on_mass_cancel(const MassCancelBody& mass_cancel, uint32_t session_id);
+    // Cancel-on-disconnect: cancels exactly the session's resting orders by
+    // walking its order list, O(its orders) whatever else rests. The ACK's
+    // cancelled_count has the count; levels has one update per level changed.
+    // The session's list and client order id index are then freed; an order
+    // it enters later starts them afresh.
+    EngineResult cancel_session(uint32_t session_id);
+    // Auction phase per instrument: from start_auction() every order rests
+    // without matching (an IOC is rejected) and the book may cross, until
+    // uncross() fills all executable volume at one equilibrium price (see
+    // OrderBook::auction_price()) and continuous matching resumes. The
+    // trades and level updates come back in bulk; NACK for an unknown
+    // instrument or one not in auction. indicative_auction() is the price
+    // and volume an uncross would give now.
+    bool start_auction(uint32_t instrument_id);
+    bool indicative_auction(uint32_t instrument_id, AuctionPrice& out) const;
+    EngineResult uncross(uint32_t instrument_id);
+    // End of the trading day for TIF_DAY orders (engine clock, clock.hpp);
+    // 0, the default, refuses them. Orders already resting keep their expiry.
+    void set_day_end(uint64_t day_end_ns) { day_end_ns_ = day_end_ns; }
+    uint64_t day_end() const { return day_end_ns_; }
+    // Cancels every GTT and DAY order whose expiry is at or before now_ns,
+    // in bulk off the timer wheel: O(orders expired), however deep the
+    // books. The ACK's cancelled_count has the count; levels has one update
+    // per level changed, in instrument / side / price order. Call it as time
+    // passes (the server does on every loop pass); it is cheap when nothing
+    // is due.
+    EngineResult expire(uint64_t now_ns);
+    // Resting orders entered by the session. O(its orders).
+    size_t num_session_orders(uint32_t session_id) const;
+    // Sessions holding an order list: those that rested an order (or had
+    // client ids reserved) since their last cancel_session().
+    size_t num_sessions() const { return session_orders_.size(); }
+    // Presizes the session's client order id index for n live ids, so it
+    // never rehashes on the order path (a gateway knows its session limits).
+    void reserve_client_ids(uint32_t session_id, size_t n);
     bool best_bid(const uint32_t instrument_id, int64_t& price_out, int32_t& qty_out) const;
     bool best_ask(const uint32_t instrument_id, int64_t& price_out, int32_t& qty_out) const;
+    // Top of book with level aggregates; returns false for an unknown instrument.
+    bool bbo(uint32_t instrument_id, BboBody& out) const;
+    // End of a processing batch: appends one BBO per instrument whose top of
+    // book changed since the previous call, however many fills happened,
+    // and publishes each to the attached TopOfBookCache.
+    void flush_bbo(std::vector<BboBody>& out);
+    // Other threads read quotes from `cache` (nullptr detaches); every
+    // instrument's current BBO goes in now, later changes on flush_bbo().
+    // The cache must outlive the engine or be detached first.
+    void set_top_of_book(TopOfBookCache* cache);
+    // Returns the new instrument id, or 0 if the symbol is already listed.
     uint32_t add_new_instrument(const std::string& instrument_name);
+    uint32_t add_new_instrument(const InstrumentSpec& spec);
+    // Symbol -> id for gateways; 0 if unknown.
+    uint32_t instrument_id(const std::string& symbol) const;
+    // nullptr for an unknown id.
+    const InstrumentSpec* instrument(uint32_t instrument_id) const;
+    size_t num_instruments() const { return instruments_.size(); }
+    // Level-aggregated copy of one book, tagged with the md seqno of the last
+    // frame published for it. Cost is O(levels); no order is touched.
+    bool snapshot(uint32_t instrument_id, uint64_t md_seqno, BookSnapshot& out) const;
+    // Heap bytes held by every book, summed per structure. O(instruments).
+    BookMemory memory_usage() const;
+    size_t num_resting_orders() const;
+    // nullptr when the books use the heap.
+    const Arena* arena() const { return arena_.get(); }
 private:
+    std::unique_ptr<Arena> arena_; // declared first: outlives the books allocating from it
     std::unordered_map<uint32_t, OrderBook> order_books;
-    std::unordered_map<uint32_t, std::string> id_to_ticker; 
+    std::vector<InstrumentSpec> instruments_;                  // by instrument id - 1
+    std::unordered_map<std::string, uint32_t> ids_by_symbol_;
+    std::vector<uint32_t> bbo_dirty_;                 // instruments touched this batch
+    std::unordered_map<uint32_t, BboBody> last_bbo_;  // last BBO emitted per instrument
+    TopOfBookCache* top_of_book_ = nullptr;
+    std::unordered_map<uint32_t, OwnerList> session_orders_; // live sessions only; map nodes never move
+    TimerWheel timers_{now_ns()};                     // expiries of resting GTT / DAY orders
+    uint64_t day_end_ns_ = 0;
     uint64_t next_exch_id_ = 1;
     uint32_t next_instrument_id_ = 1;
 
+    // A level changed by a bulk cancel; sorted and deduplicated into updates.
+    struct TouchedLevel {
+        uint32_t instrument_id;
+        OrderSide side;
+        int64_t price_ticks;
+        auto operator<=>(const TouchedLevel&) const = default;
+    };
+    // Cancels the session's orders matching the filters by walking its list.
+    size_t cancel_owned(uint32_t session_id, uint32_t instrument_id, uint8_t side, std::vector<LevelUpdateBody>& levels);
+    // Cancels one order found through a list or timer link, noting its level.
+    void cancel_linked(const OrderBook::OwnedOrder& o, OrderBook*& book, std::vector<TouchedLevel>& touched);
+    // One update per level, in instrument / side / price order.
+    void push_touched(std::vector<TouchedLevel>& touched, std::vector<LevelUpdateBody>& levels) const;
+    // The session's list, created on first use; nullptr for session 0.
+    OwnerList* session_list(uint32_t session_id) {
+        return session_id == 0 ? nullptr : &session_orders_[session_id];
+    }
+    // The session's list if it has one.
+    OwnerList* find_session_list(uint32_t session_id) {
+        const auto it = session_orders_.find(session_id);
+        return it == session_orders_.end() ? nullptr : &it->second;
+    }
+    const OwnerList* find_session_list(uint32_t session_id) const {
+        return const_cast<Engine*>(this)->find_session_list(session_id);
+    }
     uint64_t allocate_exch_id() { return next_exch_id_++; }
     static uint8_t liq_flag(OrderSide side) { return side == OrderSide::Bid ? 0 : 1; } 
 
-    static uint64_t now_ns() noexcept;
+    static uint64_t now_ns() noexcept { return clk::now_ns(); }
+    static void push_level(std::vector<LevelUpdateBody>& out, const OrderBook& book, uint32_t instrument_id,
+                           OrderSide side, int64_t price_ticks, bool after_add);
     static AckBody make_ack(uint64_t client_id, uint64_t exch_id, uint8_t status, uint64_t recv_ns, uint64_t ack_ns);
     bool instrument_exists(uint32_t instrument_id) const;
+    void note_top_change(OrderBook& book, bool was_dirty, uint32_t instrument_id) {
+        if (!was_dirty && book.top_dirty()) {
+            bbo_dirty_.push_back(instrument_id);
+        }
+    }
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// FlatIdMap: open-addressing map from a nonzero 64-bit id to a small value,
+// for id lookups on the hot path (client order id -> order).
+//  - One flat array of {key, value} slots, linear probing: a lookup is one
+//    multiplicative hash and usually a single cache line, with no node
+//    allocation per entry
+//  - Key 0 marks an empty slot, so 0 cannot be stored
+//  - Erase shifts the following run back instead of leaving tombstones, so
+//    probe lengths stay short however many ids come and go
+//  - Capacity is a power of two kept at most 3/4 full; growing rehashes the
+//    whole table at once, so reserve() for the expected live count up front
+//    (16 bytes a slot for a pointer value: ~32 MB for 1M live ids)
+//  - Nothing is allocated until the first insert() or a reserve() of at
+//    least one id, so an idle map costs only the object itself
+// -----------------------------------------------------------------------------
+
+template <typename V>
+class FlatIdMap {
+    static_assert(std::is_trivially_copyable_v<V>, "FlatIdMap values are moved by copy");
+
+public:
+    explicit FlatIdMap(size_t expected = 0) { reserve(expected); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return slots_.size(); }
+    size_t memory_bytes() const { return slots_.capacity() * sizeof(Slot); }
+
+    // Room for n ids without growing.
+    void reserve(size_t n) {
+        if (n == 0) {
+            return;
+        }
+        size_t cap = kMinCapacity;
+        while (cap * 3 / 4 < n) {
+            cap <<= 1;
+        }
+        if (cap > slots_.size()) {
+            rehash(cap);
+        }
+    }
+
+    // False (and nothing changes) if key is already present. key != 0.
+    bool insert(uint64_t key, V value) {
+        if ((size_ + 1) * 4 > slots_.size() * 3) {
+            rehash(slots_.empty() ? kMinCapacity : slots_.size() * 2);
+        }
+        for (size_t i = home(key);; i = (i + 1) & mask_) {
+            Slot& s = slots_[i];
+            if (s.key == key) {
+                return false;
+            }
+            if (s.key == 0) {
+                s.key = key;
+                s.value = value;
+                ++size_;
+                return true;
+            }
+        }
+    }
+
+    V* find(uint64_t key) {
+        if (size_ == 0 || key == 0) {
+            return nullptr;
+        }
+        for (size_t i = home(key);; i = (i + 1) & mask_) {
+            Slot& s = slots_[i];
+            if (s.key == key) {
+                return &s.value;
+            }
+            if (s.key == 0) {
+                return nullptr;
+            }
+        }
+    }
+    const V* find(uint64_t key) const { return const_cast<FlatIdMap*>(this)->find(key); }
+
+    bool erase(uint64_t key) {
+        if (size_ == 0 || key == 0) {
+            return false;
+        }
+        size_t i = home(key);
+        while (slots_[i].key != key) {
+            if (slots_[i].key == 0) {
+                return false;
+            }
+            i = (i + 1) & mask_;
+        }
+        // backward shift: pull later entries of the run into the hole unless
+        // that would move one before its home slot
+        for (size_t j = (i + 1) & mask_; slots_[j].key != 0; j = (j + 1) & mask_) {
+            const size_t h = home(slots_[j].key);
+            if (((j - h) & mask_) >= ((j - i) & mask_)) {
+                slots_[i] = slots_[j];
+                i = j;
+            }
+        }
+        slots_[i].key = 0;
+        --size_;
+        return true;
+    }
+
+    void clear() {
+        for (Slot& s : slots_) {
+            s.key = 0;
+        }
+        size_ = 0;
+    }
+
+private:
+    static constexpr size_t kMinCapacity = 16;
+
+    struct Slot {
+        uint64_t key = 0;
+        V value{};
+    };
+
+    size_t home(uint64_t key) const { return size_t((key * 0x9e3779b97f4a7c15ull) >> shift_); }
+
+    void rehash(size_t cap) {
+        std::vector<Slot> old;
+        old.swap(slots_);
+        slots_.assign(cap, Slot{});
+        mask_ = cap - 1;
+        shift_ = 64 - unsigned(std::countr_zero(cap));
+        size_ = 0;
+        for (const Slot& s : old) {
+            if (s.key != 0) {
+                insert(s.key, s.value);
+            }
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    unsigned shift_ = 64;
+    size_t size_ = 0;
+};
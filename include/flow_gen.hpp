@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "engine.hpp"
+#include "wire.hpp"
+
+// -----------------------------------------------------------------------------
+// FlowGenerator: seeded synthetic order flow, for benchmarks and replay.
+//  - Poisson arrivals at cfg.rate (simulated time, no sleeping)
+//  - Per-instrument mid price follows a mean-reverting (Ornstein-Uhlenbeck)
+//    process; passive orders rest an exponentially distributed number of
+//    ticks away from it
+//  - Cancels target live resting orders; the further an order sits from the
+//    mid, the more likely a picked order is cancelled
+//  - Occasional sweeping aggressors: IOC orders priced through the opposite
+//    best, sized to take out more than the top level
+// The generator runs its own Engine as a shadow of the one that will replay
+// the flow, so every CANCEL names an order that is resting at that point and
+// carries the exch_order_id a fresh Engine will have assigned it.
+// Same seed + same config => byte-identical output. std:: distributions are
+// avoided on purpose: their output differs between standard libraries.
+// -----------------------------------------------------------------------------
+
+struct FlowGenConfig {
+    uint64_t seed = 1;
+    double   rate = 100'000;          // mean arrivals per second
+    uint32_t num_instruments = 1;     // instruments 1..N (must exist in the replaying engine)
+    int64_t  mid_px = 10'000;         // long-run mean of the mid, ticks
+    double   mid_reversion = 2.0;     // pull back to mid_px, 1/s
+    double   mid_vol = 20.0;          // ticks per sqrt(second)
+    double   depth_mean = 4.0;        // mean distance of passive orders from the mid, ticks
+    double   qty_mean = 100.0;
+    double   cancel_share = 0.45;     // share of events that pick a resting order to cancel
+    double   cancel_depth_ticks = 10.0; // picked orders this far from the mid are always cancelled
+    double   sweep_prob = 0.02;       // share of events that are sweeping aggressors
+    int64_t  sweep_ticks = 5;         // how far through the opposite best a sweep is priced
+};
+
+struct FlowEvent {
+    MsgType type;              // NEW or CANCEL
+    uint64_t ts_ns;            // arrival time since the start of the flow
+    OrderNewBody new_order;    // valid when type == NEW
+    OrderCancelBody cancel;    // valid when type == CANCEL
+};
+
+class FlowGenerator {
+public:
+    explicit FlowGenerator(FlowGenConfig cfg);
+
+    FlowEvent next();
+
+    uint64_t news() const { return news_; }
+    uint64_t cancels() const { return cancels_; }
+    uint64_t sweeps() const { return sweeps_; }
+    size_t resting() const { return live_.size(); }
+
+private:
+    struct Live {
+        uint32_t instrument_id;
+        int64_t  price_ticks;
+        int32_t  qty;
+    };
+
+    double uniform();                 // [0, 1)
+    double exponential(double mean);
+    double normal();
+    double advance_mid(uint32_t instrument_id);
+    bool pick_cancel(uint32_t instrument_id, double mid, OrderCancelBody& out);
+    void apply_new(const OrderNewBody& o);
+
+    FlowGenConfig cfg_;
+    std::mt19937_64 rng_;
+    Engine shadow_;
+    std::unordered_map<uint64_t, Live> live_;        // resting orders by exch id
+    std::vector<std::vector<uint64_t>> candidates_;  // per instrument; may hold filled ids
+    std::vector<double> mid_;
+    std::vector<uint64_t> mid_ts_;
+    uint64_t now_ns_ = 0;
+    uint64_t next_cid_ = 1;
+    double spare_normal_ = 0.0;
+    bool has_spare_ = false;
+    uint64_t news_ = 0;
+    uint64_t cancels_ = 0;
+    uint64_t sweeps_ = 0;
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// Instrument universe: the symbols an engine trades, loaded once at startup.
+//  - Text file, one instrument per line, whitespace separated:
+//      symbol  expected_orders  band_lo_ticks  band_hi_ticks  tick_size
+//    '#' starts a comment; blank lines are ignored
+//  - Line order gives the instrument ids: the first symbol is id 1
+//  - expected_orders and the price band are hints, not limits: the engine
+//    presizes each book's order index for expected_orders and grows past it
+//    if it must; orders outside the band are accepted
+//  - tick_size is the price of one tick, for gateways converting prices
+// -----------------------------------------------------------------------------
+
+// Largest expected_orders a universe file may give one instrument: the
+// engine presizes for it at startup, so a typo must not ask for terabytes.
+inline constexpr uint32_t kMaxExpectedOrders = 100'000'000;
+
+struct InstrumentSpec {
+    std::string symbol;
+    uint32_t expected_orders = 0; // resting orders to presize the book for
+    int64_t  band_lo_ticks = 0;   // expected trading range, inclusive
+    int64_t  band_hi_ticks = 0;
+    double   tick_size = 0.01;
+};
+
+// Appends the instruments in `in` to out. On a malformed line (including
+// expected_orders below 0 or above kMaxExpectedOrders) or a duplicate
+// symbol, logs "<source>:<line>: ..." to stderr and returns false.
+bool parse_universe(std::istream& in, const std::string& source, std::vector<InstrumentSpec>& out);
+bool load_universe(const std::string& path, std::vector<InstrumentSpec>& out);
@@ -0,0 +1,238 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) && defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+#include "wire.hpp"
+
+// -----------------------------------------------------------------------------
+// LevelRing: one price level as parallel arrays, an alternative to the
+// book's std::list LevelQueue for levels that get swept whole.
+//  - qty[] and exch_order_id[] side by side in a ring (capacity a power of
+//    two), oldest order at the head. An order is addressed by its sequence
+//    number, the handle push_back() returns; it stays valid until the order
+//    leaves (then it may come to name a later order) or a compaction moves
+//    it (reported through on_move)
+//  - cancel() leaves a hole (qty 0) in place, O(1). Holes at either end are
+//    dropped at once; the rest stay until they outnumber the live orders,
+//    then one compaction pass closes them all (amortised O(1) per cancel)
+//  - sweep() fills a taker against the front: a running sum over qty[]
+//    (SSE2, eight quantities per step, holes adding 0) finds in one pass how
+//    many makers are consumed whole, then their trades are written as a
+//    block and the head jumps past them; no node is touched per maker
+// Single-threaded, like the book.
+// -----------------------------------------------------------------------------
+
+namespace level_ring {
+
+// How many leading entries of q[0, n) fit in `budget` (their running sum
+// stays <= budget); adds their sum to `sum`. Quantities are >= 0.
+inline size_t consumed_prefix_scalar(const int32_t* q, size_t n, int64_t budget, int64_t& sum) {
+    size_t i = 0;
+    while (i < n && sum + q[i] <= budget) {
+        sum += q[i++];
+    }
+    return i;
+}
+
+inline size_t consumed_prefix(const int32_t* q, size_t n, int64_t budget, int64_t& sum) {
+    size_t i = 0;
+#if defined(__SSE2__) && defined(__x86_64__)
+    // whole blocks of 8 while they fit, summed in 64-bit lanes (zero-extended,
+    // so no overflow); the block that does not fit is scanned one by one
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i + 4));
+        __m128i s = _mm_add_epi64(_mm_add_epi64(_mm_unpacklo_epi32(a, zero), _mm_unpackhi_epi32(a, zero)),
+                                  _mm_add_epi64(_mm_unpacklo_epi32(b, zero), _mm_unpackhi_epi32(b, zero)));
+        s = _mm_add_epi64(s, _mm_unpackhi_epi64(s, s));
+        const int64_t block = _mm_cvtsi128_si64(s);
+        if (sum + block > budget) {
+            break;
+        }
+        sum += block;
+    }
+#endif
+    return i + consumed_prefix_scalar(q + i, n - i, budget, sum);
+}
+
+} // namespace level_ring
+
+class LevelRing {
+public:
+    struct Sweep {
+        int32_t  filled = 0;  // quantity traded
+        uint32_t removed = 0; // makers filled completely, now gone: the first `removed` trades appended
+    };
+
+    bool empty() const { return live_ == 0; }
+    uint32_t size() const { return live_; }          // resting orders, holes excluded
+    int64_t total_qty() const { return total_qty_; }
+    size_t capacity() const { return qty_.size(); }
+    size_t memory_bytes() const { return qty_.capacity() * sizeof(int32_t) + ids_.capacity() * sizeof(uint64_t); }
+
+    // Oldest order; the level must not be empty.
+    uint64_t front_id() const { return ids_[head_ & mask_]; }
+    int32_t front_qty() const { return qty_[head_ & mask_]; }
+    // Remaining quantity of a resting order, 0 if the handle is not one.
+    int32_t qty(uint64_t handle) const { return handle - head_ < tail_ - head_ ? qty_[handle & mask_] : 0; }
+
+    // Appends an order (qty > 0); returns its handle.
+    uint64_t push_back(uint64_t exch_order_id, int32_t qty) {
+        if (tail_ - head_ == qty_.size()) {
+            grow();
+        }
+        const uint64_t h = tail_++;
+        qty_[h & mask_] = qty;
+        ids_[h & mask_] = exch_order_id;
+        ++live_;
+        total_qty_ += qty;
+        return h;
+    }
+
+    // Removes a resting order; returns its remaining quantity, 0 if the
+    // handle is not a resting order. A compaction may follow, calling
+    // on_move(exch_order_id, new_handle) for every order it moves.
+    template <typename OnMove>
+    int32_t cancel(uint64_t handle, OnMove&& on_move) {
+        const int32_t q = qty(handle);
+        if (q == 0) {
+            return 0;
+        }
+        qty_[handle & mask_] = 0;
+        --live_;
+        ++holes_;
+        total_qty_ -= q;
+        trim();
+        if (holes_ > kMinHolesToCompact && holes_ > live_) {
+            compact(on_move);
+        }
+        return q;
+    }
+    int32_t cancel(uint64_t handle) {
+        return cancel(handle, [](uint64_t, uint64_t) {});
+    }
+
+    // Fills up to qty against the front, oldest first: appends one trade per
+    // maker (a copy of `proto` with qty and resting_exch_order_id set).
+    Sweep sweep(int32_t qty, const TradeBody& proto, std::vector<TradeBody>& out) {
+        Sweep r;
+        if (qty <= 0 || live_ == 0) {
+            return r;
+        }
+        // makers consumed whole: the first `n` slots, in at most two runs
+        int64_t sum = 0;
+        const size_t used = size_t(tail_ - head_);
+        const size_t first = size_t(head_ & mask_);
+        const size_t run1 = std::min(used, qty_.size() - first);
+        size_t n = level_ring::consumed_prefix(qty_.data() + first, run1, qty, sum);
+        if (n == run1 && run1 < used) {
+            n += level_ring::consumed_prefix(qty_.data(), used - run1, qty, sum);
+        }
+        out.reserve(out.size() + n + 1);
+        TradeBody t = proto;
+        for (size_t k = 0; k < n; ++k) {
+            const size_t slot = size_t((head_ + k) & mask_);
+            if (qty_[slot] != 0) {
+                t.qty = qty_[slot];
+                t.resting_exch_order_id = ids_[slot];
+                out.push_back(t);
+                ++r.removed;
+            }
+        }
+        holes_ -= uint32_t(n) - r.removed;
+        live_ -= r.removed;
+        head_ += n;
+        r.filled = int32_t(sum);
+        // the next maker, if any, is live and takes what is left
+        const int32_t left = qty - r.filled;
+        if (left > 0 && head_ != tail_) {
+            t.qty = left;
+            t.resting_exch_order_id = ids_[head_ & mask_];
+            out.push_back(t);
+            qty_[head_ & mask_] -= left;
+            r.filled = qty;
+        }
+        total_qty_ -= r.filled;
+        if (live_ == 0) {
+            head_ = tail_; // nothing left but holes
+            holes_ = 0;
+        }
+        return r;
+    }
+
+    // Resting orders oldest first: f(exch_order_id, qty, handle).
+    template <typename F>
+    void for_each(F&& f) const {
+        for (uint64_t h = head_; h != tail_; ++h) {
+            if (qty_[h & mask_] != 0) {
+                f(ids_[h & mask_], qty_[h & mask_], h);
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t kMinHolesToCompact = 8;
+    static constexpr size_t kMinCapacity = 8;
+
+    // Drops holes at both ends, keeping the head on a live order.
+    void trim() {
+        while (head_ != tail_ && qty_[head_ & mask_] == 0) {
+            ++head_;
+            --holes_;
+        }
+        while (head_ != tail_ && qty_[(tail_ - 1) & mask_] == 0) {
+            --tail_;
+            --holes_;
+        }
+    }
+
+    void grow() {
+        const size_t cap = qty_.empty() ? kMinCapacity : qty_.size() * 2;
+        std::vector<int32_t> qty(cap);
+        std::vector<uint64_t> ids(cap);
+        const uint64_t mask = cap - 1;
+        for (uint64_t h = head_; h != tail_; ++h) {
+            qty[h & mask] = qty_[h & mask_];
+            ids[h & mask] = ids_[h & mask_];
+        }
+        qty_.swap(qty);
+        ids_.swap(ids);
+        mask_ = mask;
+    }
+
+    // Closes every hole, keeping the order; the head keeps its handle.
+    template <typename OnMove>
+    void compact(OnMove& on_move) {
+        uint64_t to = head_;
+        for (uint64_t from = head_; from != tail_; ++from) {
+            const int32_t q = qty_[from & mask_];
+            if (q == 0) {
+                continue;
+            }
+            if (from != to) {
+                qty_[to & mask_] = q;
+                ids_[to & mask_] = ids_[from & mask_];
+                on_move(ids_[to & mask_], to);
+            }
+            ++to;
+        }
+        tail_ = to;
+        holes_ = 0;
+    }
+
+    std::vector<int32_t> qty_;  // 0 marks a hole
+    std::vector<uint64_t> ids_;
+    uint64_t mask_ = 0;
+    uint64_t head_ = 0;         // handle of the oldest slot in use
+    uint64_t tail_ = 0;         // handle the next push_back gets
+    uint32_t live_ = 0;
+    uint32_t holes_ = 0;        // qty 0 slots between head_ and tail_
+    int64_t total_qty_ = 0;
+};
@@ -0,0 +1,168 @@
+#pragma once
+#include <netinet/in.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "book_snapshot.hpp"
+#include "codec.hpp"
+#include "spsc_ring.hpp"
+#include "wire.hpp"
+
+// -----------------------------------------------------------------------------
+// MdPublisher: market-data fan-out running on its own thread.
+//  - The engine thread calls publish(): the frame gets the next md seqno and is
+//    copied into a lock-free SPSC ring. Nothing on that path depends on how
+//    many subscribers exist.
+//  - The publisher thread drains the ring, packs consecutive frames into UDP
+//    datagrams and sends each datagram to every destination (unicast ports
+//    and/or a loopback multicast group).
+//  - Every frame is also kept in a ring of recent frames; a retransmit server
+//    (UNIX and/or TCP stream socket) serves gap fills from it.
+//  - The same server takes SNAPSHOT_REQUESTs. They are handed to the engine
+//    thread, which only copies level aggregates; encoding and socket writes of
+//    the (possibly large) snapshot happen back on the publisher thread.
+// -----------------------------------------------------------------------------
+
+inline constexpr size_t kMdMaxFrame = 112;       // largest market-data frame (header + body)
+inline constexpr size_t kMdMaxDatagram = 1400;   // keep datagrams under a typical MTU
+inline constexpr uint32_t kMdMaxRetransBatch = 1024; // frames served per RETRANS_REQUEST
+
+// One encoded frame travelling engine thread -> publisher thread.
+struct alignas(kCacheLine) MdSlot {
+    uint64_t seqno;
+    uint32_t len;
+    uint8_t  bytes[kMdMaxFrame];
+};
+static_assert(sizeof(MdSlot) == 128, "MdSlot should be exactly two cache lines");
+
+// Snapshot request travelling publisher thread -> engine thread.
+struct SnapshotRequest {
+    uint32_t instrument_id;
+    uint32_t client_id; // retransmit connection that asked
+};
+
+struct MdPublisherConfig {
+    std::vector<sockaddr_in> udp_destinations; // unicast ports and/or multicast groups
+    std::string retrans_unix_path;             // empty = no UNIX retransmit server
+    int retrans_tcp_port = -1;                 // -1 = disabled, 0 = ephemeral (127.0.0.1 only)
+    size_t queue_capacity = 1 << 16;           // engine -> publisher ring
+    size_t retrans_capacity = 1 << 16;         // recent frames kept for gap fill
+};
+
+// Parse "a.b.c.d:port" into a sockaddr_in. Returns false on malformed input.
+bool parse_udp_endpoint(const std::string& text, sockaddr_in& out);
+
+class MdPublisher {
+public:
+    explicit MdPublisher(MdPublisherConfig cfg);
+    ~MdPublisher();
+
+    MdPublisher(const MdPublisher&) = delete;
+    MdPublisher& operator=(const MdPublisher&) = delete;
+
+    // Opens sockets and spawns the publisher thread. Returns false (and logs)
+    // if a socket could not be set up.
+    bool start();
+    // Publishes everything already queued, then joins the thread.
+    void stop();
+
+    // Engine thread only. Stamps the frame with the next md seqno and queues it.
+    // Spins if the ring is full (the publisher thread never blocks on sockets,
+    // so this only happens if it is starved of CPU).
+    template <typename BodyT>
+    uint64_t publish(MsgType type, const BodyT& body, uint64_t ts_ns) {
+        static_assert(sizeof(Header) + sizeof(BodyT) <= kMdMaxFrame, "body too large for a market-data frame");
+        MdSlot slot;
+        slot.seqno = ++next_seqno_;
+        Header h = codec::make_header(type, sizeof(BodyT), slot.seqno, ts_ns);
+        std::memcpy(slot.bytes, &h, sizeof(Header));
+        std::memcpy(slot.bytes + sizeof(Header), &body, sizeof(BodyT));
+        slot.len = h.size;
+        while (!queue_.try_push(slot)) {
+            producer_stalls_.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::yield();
+        }
+        return slot.seqno;
+    }
+
+    // Engine thread only: seqno of the last frame handed to publish().
+    uint64_t last_seqno() const { return next_seqno_; }
+
+    // Engine thread only: pending snapshot requests. Build the snapshot with
+    // Engine::snapshot(req.instrument_id, last_seqno(), ...) and hand it back.
+    bool next_snapshot_request(SnapshotRequest& out) { return snap_requests_.try_pop(out); }
+    void deliver_snapshot(const SnapshotRequest& req, std::unique_ptr<BookSnapshot> snap);
+
+    uint16_t retrans_tcp_port() const { return bound_tcp_port_; }
+
+    // Counters (safe to read from any thread)
+    uint64_t frames_published() const { return frames_published_.load(std::memory_order_relaxed); }
+    uint64_t datagrams_sent() const { return datagrams_sent_.load(std::memory_order_relaxed); }
+    uint64_t send_errors() const { return send_errors_.load(std::memory_order_relaxed); }
+    uint64_t retrans_frames_served() const { return retrans_served_.load(std::memory_order_relaxed); }
+    uint64_t producer_stalls() const { return producer_stalls_.load(std::memory_order_relaxed); }
+    uint64_t snapshots_served() const { return snapshots_served_.load(std::memory_order_relaxed); }
+
+private:
+    struct RetransClient {
+        int fd;
+        uint32_t id;
+        bool awaiting_snapshot = false; // later requests wait so responses stay in order
+        std::vector<uint8_t> in;  // partial request bytes
+        std::vector<uint8_t> out; // pending response bytes
+    };
+
+    struct SnapshotReply {
+        uint32_t client_id;
+        BookSnapshot* snap; // owned; freed by the publisher thread
+    };
+
+    void run();
+    void append_frame(const MdSlot& slot);
+    void flush_datagram();
+    void service_retrans(int timeout_ms);
+    void accept_clients(int listen_fd);
+    bool read_client(RetransClient& c);
+    bool process_requests(RetransClient& c);
+    bool flush_client(RetransClient& c);
+    void serve_range(RetransClient& c, const RetransRequestBody& req);
+    void drain_snapshots();
+    static void encode_snapshot(RetransClient& c, const BookSnapshot& snap);
+    void close_sockets();
+
+    MdPublisherConfig cfg_;
+    SpscRing<MdSlot> queue_;
+    uint64_t next_seqno_ = 0; // engine thread
+
+    // publisher thread state
+    std::vector<MdSlot> history_;
+    uint64_t history_mask_ = 0;
+    uint64_t history_last_ = 0; // highest seqno stored
+    uint8_t  dgram_[kMdMaxDatagram];
+    size_t   dgram_len_ = 0;
+    int udp_fd_ = -1;
+    int unix_listen_fd_ = -1;
+    int tcp_listen_fd_ = -1;
+    uint16_t bound_tcp_port_ = 0;
+    std::vector<RetransClient> clients_;
+    uint32_t next_client_id_ = 1;
+
+    SpscRing<SnapshotRequest> snap_requests_{64}; // publisher -> engine
+    SpscRing<SnapshotReply> snap_replies_{64};    // engine -> publisher
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+
+    std::atomic<uint64_t> frames_published_{0};
+    std::atomic<uint64_t> datagrams_sent_{0};
+    std::atomic<uint64_t> send_errors_{0};
+    std::atomic<uint64_t> retrans_served_{0};
+    std::atomic<uint64_t> producer_stalls_{0};
+    std::atomic<uint64_t> snapshots_served_{0};
+};
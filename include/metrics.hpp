@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "spsc_ring.hpp" // kCacheLine
+#include "wire.hpp"
+
+// -----------------------------------------------------------------------------
+// Metrics: process-wide counters cheap enough to leave on in production.
+//  - Every thread that counts gets its own cache-line-aligned shard on first
+//    use; an increment is a relaxed load + store on a line no other thread
+//    writes (no lock prefix, no sharing), after one thread_local pointer test
+//  - Readers sum all shards (relaxed loads) only when asked. A thread's shard
+//    outlives it and, values kept, goes to the next thread that starts
+//    counting: totals never go backwards and thread churn does not grow the
+//    registry past the most threads counting at once
+//  - The Metric order is part of the wire protocol (StatsBody::values):
+//    append only
+//  - Configure with -DMARKETFEED_METRICS=OFF to compile every count() out
+// -----------------------------------------------------------------------------
+
+enum class Metric : uint8_t {
+    // gateway (server loop): requests received, by type
+    MsgsNew = 0,
+    MsgsCancel,
+    MsgsMassCancel,
+    MsgsStatsRequest,
+    MsgsOther,          // any other or undecodable type
+    BytesIn,            // order-entry bytes read
+    BytesOut,           // order-entry bytes written
+    SessionsOpened,
+    SessionsClosed,
+    // engine
+    OrdersAccepted,     // NEW acked
+    Rejects,            // any NACK
+    Fills,              // trades, continuous and auction
+    FilledQty,
+    OrdersCancelled,    // single, mass and disconnect cancels
+    // order book
+    LevelsCreated,
+    LevelsDeleted,
+    // engine
+    OrdersExpired,      // GTT and DAY orders removed by Engine::expire()
+    kCount
+};
+
+inline constexpr size_t kNumMetrics = static_cast<size_t>(Metric::kCount);
+static_assert(kNumMetrics <= kMaxStatsValues, "StatsBody has no room for every metric");
+
+using MetricValues = std::array<uint64_t, kNumMetrics>;
+
+// Stable snake_case name, e.g. "msgs_new"; used in dumps.
+const char* metric_name(Metric m);
+
+// One thread's counters. Single writer, so plain relaxed load + store.
+struct alignas(kCacheLine) MetricsShard {
+    std::array<std::atomic<uint64_t>, kNumMetrics> values{};
+
+    void add(Metric m, uint64_t n) {
+        std::atomic<uint64_t>& v = values[static_cast<size_t>(m)];
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+namespace metrics {
+
+// Gives the calling thread a shard (once; takes a lock).
+MetricsShard* register_thread();
+
+inline thread_local MetricsShard* t_shard = nullptr;
+
+inline void count(Metric m, uint64_t n = 1) {
+#ifndef MARKETFEED_NO_METRICS
+    MetricsShard* s = t_shard;
+    if (s == nullptr) [[unlikely]] {
+        s = register_thread();
+    }
+    s->add(m, n);
+#else
+    (void)m;
+    (void)n;
+#endif
+}
+
+// Totals over every thread that ever counted. O(shards); takes the lock.
+MetricValues read();
+size_t num_shards();
+
+// Every counter as "name=value" pairs on one line.
+std::string format(const MetricValues& v);
+
+// STATS reply body for request_id.
+StatsBody stats_body(uint64_t request_id, uint64_t ts_ns);
+
+} // namespace metrics
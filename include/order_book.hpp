@@ -1,9 +1,15 @@
 #pragma once
 #include <cstdint>
+#include <functional>
+#include <iterator>
 #include <list>
 #include <map>
 #include <unordered_map>
 #include <vector>
+#include "arena.hpp"
+#include "counting_allocator.hpp"
+#include "flat_id_map.hpp"
+#include "timer_wheel.hpp"
 #include "wire.hpp"
 
 // -----------------------------------------------------------------------------
@@ -13,32 +19,146 @@
 //  - FIFO within each price level
 //  - O(1) cancel by id via index map (use std::list for stable iterators)
 //  - Emits TradeBody records when matching
+//  - Orders entered by an owner (session) are also threaded on that owner's
+//    OwnerList, across books, so its orders can be pulled without a search,
+//    and indexed there by client order id for cancels that have no exchange id
+//  - Auction phase: the engine rests orders without matching, the book may
+//    cross, and uncross() fills everything executable at one price
+//  - An order with an expiry carries its timer (timer_wheel.hpp) in its index
+//    entry; fills and cancels unschedule it in O(1)
 // -----------------------------------------------------------------------------
 
 enum class OrderSide : uint8_t { Bid = 0, Ask = 1 };
 
+// Owner filter of mass_cancel() that matches every order.
+inline constexpr uint32_t kAnyOwner = 0;
+
 struct BookOrder {
     uint64_t exch_order_id; // unique within engine
     int32_t  qty;           // remaining quantity
+    uint32_t owner;         // session that entered it, 0 if none
+};
+
+// Intrusive links of an OwnerList. The list is circular through the
+// OwnerList's own sentinel, so unlinking an order needs no pointer to the
+// list; an order without an owner has null links.
+struct OwnerLink {
+    OwnerLink* prev = nullptr;
+    OwnerLink* next = nullptr;
+
+    bool linked() const { return next != nullptr; }
+    void unlink() {
+        prev->next = next;
+        next->prev = prev;
+        prev = next = nullptr;
+    }
+};
+
+// One owner's resting orders in every book it trades, oldest first. Books
+// link an order on add and unlink it on fill or cancel, O(1) either way; the
+// list must stay where it is (and outlive its orders or be emptied first).
+// by_client_id maps the client order id of each of them (when it had one)
+// to its link, see OrderBook::owned_order(); books keep it in step with the
+// list, so a live id can be found, or refused on entry, in O(1).
+struct OwnerList : OwnerLink {
+    OwnerList() { prev = next = this; }
+    OwnerList(const OwnerList&) = delete;
+    OwnerList& operator=(const OwnerList&) = delete;
+
+    FlatIdMap<OwnerLink*> by_client_id;
+
+    bool empty() const { return next == this; }
+    void push_back(OwnerLink* l) {
+        l->prev = prev;
+        l->next = this;
+        prev->next = l;
+        prev = l;
+    }
 };
 
 // FIFO queue at a given price level. std::list gives stable iterators, so we
 // can erase by iterator during cancel without invalidating other iterators.
-using LevelQueue = std::list<BookOrder>;
+using LevelQueue = std::list<BookOrder, CountingAllocator<BookOrder>>;
+
+// One price level: FIFO of orders plus the aggregate published as market data.
+// order count is orders.size() (O(1) for std::list).
+struct PriceLevel {
+    explicit PriceLevel(const LevelQueue::allocator_type& alloc) : orders(alloc) {}
+
+    LevelQueue orders;
+    int64_t    total_qty = 0; // sum of remaining qty over orders
+};
+
+// Heap bytes held by a book, per structure (see counting_allocator.hpp).
+struct BookMemory {
+    MemoryCounter levels; // price map nodes (one per non-empty level)
+    MemoryCounter orders; // level queue nodes (one per resting order)
+    MemoryCounter index;  // id index nodes and bucket array
+
+    int64_t bytes() const { return levels.bytes + orders.bytes + index.bytes; }
+    BookMemory& operator+=(const BookMemory& o) {
+        levels += o.levels;
+        orders += o.orders;
+        index += o.index;
+        return *this;
+    }
+};
+
+// Equilibrium of a crossed book (see OrderBook::auction_price()).
+struct AuctionPrice {
+    int64_t price_ticks = 0;
+    int64_t volume = 0;  // executable at price_ticks; 0 if the book does not cross
+    int64_t surplus = 0; // bid minus ask quantity at price_ticks, left unfilled on one side
+};
 
 class OrderBook {
 public:
-    OrderBook() = default;
+    // instrument_id tags the entries of owned orders, see owned_order().
+    // Levels, order nodes and the id index come from `arena` if given (it must
+    // outlive the book), from the heap otherwise.
+    explicit OrderBook(uint32_t instrument_id = 0, Arena* arena = nullptr);
+    // The containers' allocators point at mem_, so a book stays where it was built.
+    OrderBook(const OrderBook&) = delete;
+    OrderBook& operator=(const OrderBook&) = delete;
 
-    // Add a new resting order to the book.
+    // Add a new resting order to the book, appended to owner_list if given
+    // (and indexed there under a nonzero client_order_id the owner has no
+    // other live order with) and scheduled on `timers` to expire at
+    // expire_ns if given.
     // Returns false if exch_order_id already exists or qty <= 0.
     bool add_resting(uint64_t exch_order_id,
                    OrderSide side,
                    int64_t price_ticks,
-                   int32_t qty);
+                   int32_t qty,
+                   uint32_t owner = 0,
+                   OwnerList* owner_list = nullptr,
+                   TimerWheel* timers = nullptr,
+                   uint64_t expire_ns = 0,
+                   uint64_t client_order_id = 0);
 
     // Cancel an existing order by exchange id. Returns false if not found.
     bool cancel_order(uint64_t exch_order_id);
+    // Same, but also reports where the order was resting so the caller can
+    // publish the level change without a second lookup.
+    bool cancel_order(uint64_t exch_order_id, OrderSide& side_out, int64_t& price_out);
+
+    // An order on an OwnerList, as seen from the list: the book holding it
+    // (see instrument_id()), its side and its exchange id.
+    struct OwnedOrder {
+        uint32_t  instrument_id;
+        OrderSide side;
+        uint64_t  exch_order_id;
+    };
+    static OwnedOrder owned_order(const OwnerLink* link);
+    // The same for a timer fired by the wheel the order was scheduled on.
+    static OwnedOrder timed_order(const TimerLink* link);
+
+    // Cancel every resting order on `side` (kBothSides for both) entered by
+    // `owner` (kAnyOwner for all). Appends one LevelUpdateBody per level that
+    // changed: DELETE, or UPDATE where other owners' orders remain; bids
+    // best-first, then asks. Without an owner filter whole levels are dropped
+    // and the index is swept once, not order by order. Returns the count.
+    size_t mass_cancel(uint8_t side, uint32_t owner, std::vector<LevelUpdateBody>& out, uint32_t instrument_id);
 
     // Match an incoming (taker) order against the opposite side.
     // Generates one or more TradeBody fills in out_trades; returns total filled qty.
@@ -50,18 +170,62 @@ public:
                   uint32_t instrument_id,
                   uint8_t liquidity_flag /* 0=aggr buy, 1=aggr sell */);
 
+    // Auction phase flag; the book itself matches only when asked to.
+    bool in_auction() const { return in_auction_; }
+    void set_auction(bool on) { in_auction_ = on; }
+
+    // The price maximising executable volume, from one pass over cumulative
+    // bid / ask depth at every level price where the book crosses. Ties go
+    // to the smallest surplus, then to the highest price if every remaining
+    // candidate has a buy surplus or the lowest if all have a sell surplus,
+    // then to the one closest to reference_px (default: the middle of them),
+    // the lower on a tie. O(crossed levels).
+    AuctionPrice auction_price(int64_t reference_px = -1) const;
+
+    // Executes p (from auction_price()): bids best-first against asks
+    // best-first, every fill at p.price_ticks with liquidity flag
+    // kLiquidityAuction. Appends the trades and one update per level touched
+    // (bids best-first, then asks). Returns the volume executed.
+    int64_t uncross(const AuctionPrice& p, std::vector<TradeBody>& trades, std::vector<LevelUpdateBody>& levels,
+                    uint32_t instrument_id);
+
     // Best quotes; return false if that side is empty.
     bool best_bid(int64_t& price_out, int32_t& qty_out) const;
     bool best_ask(int64_t& price_out, int32_t& qty_out) const;
 
+    // Best level on one side with its aggregates; returns false if that side is empty.
+    bool best_level(OrderSide side, int64_t& price_out, int64_t& total_qty_out, uint32_t& count_out) const;
+
+    // Aggregate state of one price level; returns false if the level is empty.
+    bool level_info(OrderSide side, int64_t price_ticks, int64_t& total_qty_out, uint32_t& count_out) const;
+
+    // Append every level as a LevelUpdateBody (action=ADD): bids best-first,
+    // then asks best-first. O(levels), independent of the number of orders.
+    void append_levels(std::vector<LevelUpdateBody>& out, uint32_t instrument_id) const;
+
+    // Top-of-book change tracking: set by any mutation that touches the best
+    // level of either side, cleared by whoever publishes quotes.
+    bool top_dirty() const { return top_dirty_; }
+    void clear_top_dirty() { top_dirty_ = false; }
+
+    // Presizes the id index for this many resting orders, so the opening
+    // burst does not rehash it. Level and queue nodes are still allocated
+    // one at a time.
+    void reserve(size_t orders) { id_index_.reserve(orders); }
+
     // Introspection
+    uint32_t instrument_id() const { return instrument_id_; }
     size_t num_orders() const { return id_index_.size(); }
     bool empty_bid() const { return bids_.empty(); }
     bool empty_ask() const { return asks_.empty(); }
+    const BookMemory& memory() const { return mem_; }
 
 private:
-    using PriceMap = std::map<int64_t, LevelQueue>; // ascending prices
+    using PriceMap = std::map<int64_t, PriceLevel, std::less<int64_t>,
+                              CountingAllocator<std::pair<const int64_t, PriceLevel>>>; // ascending prices
 
+    static LevelUpdateBody level_update(OrderSide side, int64_t px, const PriceLevel& level, uint32_t instrument_id,
+                                        LevelAction action);
     static OrderSide opposite(OrderSide s) { return s == OrderSide::Bid ? OrderSide::Ask : OrderSide::Bid; }
 
     bool best_on_side(OrderSide side, int64_t& px, int32_t& qty) const;
@@ -74,15 +238,52 @@ private:
         return (taker_side == OrderSide::Ask) ? (taker_price_ticks <= resting_price_ticks) : (taker_price_ticks >= resting_price_ticks);
     }
 
+    BookMemory mem_; // declared first: outlives the containers charging it
+    Arena* arena_;
+
     // Containers: bids use max price (best is rbegin), asks use min price (best is begin)
     PriceMap bids_;
     PriceMap asks_;
 
-    // Fast lookup: exch_order_id -> {side, price, iterator into LevelQueue}
-    struct IndexEntry {
+    // Fast lookup: exch_order_id -> {side, price, iterator into LevelQueue}.
+    // Entries are the owner list and timer nodes: unordered_map nodes never move.
+    struct IndexEntry : OwnerLink, TimerLink {
+        IndexEntry(OrderSide s, uint32_t instr, int64_t px, LevelQueue::iterator i)
+            : side(s), instrument_id(instr), price_ticks(px), it(i) {}
+
         OrderSide side;
+        uint32_t  instrument_id;
         int64_t   price_ticks;
         LevelQueue::iterator it; // stable except when element erased
+        OwnerList* owner_list = nullptr; // set while indexed by client_order_id
+        uint64_t  client_order_id = 0;
     };
-    std::unordered_map<uint64_t, IndexEntry> id_index_;
+    using IdIndex = std::unordered_map<uint64_t, IndexEntry, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                                       CountingAllocator<std::pair<const uint64_t, IndexEntry>>>;
+    IdIndex id_index_;
+
+    // Takes an entry off its owner list (and client id index) and its timer.
+    static void unlink_entry(IndexEntry& e) {
+        if (e.linked()) {
+            e.unlink();
+        }
+        if (e.owner_list != nullptr) {
+            e.owner_list->by_client_id.erase(e.client_order_id);
+        }
+        TimerWheel::unschedule(&e);
+    }
+    // Removes an index entry, unlinking it first.
+    IdIndex::iterator erase_entry(IdIndex::iterator it) {
+        unlink_entry(it->second);
+        return id_index_.erase(it);
+    }
+
+    uint32_t instrument_id_ = 0;
+    bool top_dirty_ = false;
+    bool in_auction_ = false;
+
+    // True if it is the best level of its side (bids: highest, asks: lowest)
+    bool is_best(OrderSide side, PriceMap::const_iterator it) const {
+        return side == OrderSide::Bid ? std::next(it) == bids_.end() : it == asks_.begin();
+    }
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+#include "capture.hpp"
+#include "wire.hpp"
+
+// -----------------------------------------------------------------------------
+// Capture replay: the NEW / CANCEL frames of a capture file (capture.hpp)
+// run through fresh engines in process, every request's ACK, trades and
+// level updates handed to a ReplaySink in capture order.
+//  - threads == 0: one Engine, one request at a time; the reference
+//  - threads >= 1: books are independent per instrument, so the flow is
+//    split into partitions by instrument_id, each with its own Engine, and
+//    replayed on a pool of worker threads. A worker runs a whole partition
+//    at a time (it owns those books meanwhile); partitions are dealt
+//    largest first to per-worker queues (the calling thread is worker 0)
+//    and an idle worker steals from the back of another's. The results are
+//    merged back into capture order.
+//  - Same results either way, byte for byte (ACK timestamps aside): an
+//    exch id is a count of the NEWs accepted before it in the whole flow,
+//    so the split pass numbers them up front (Engine::valid_new()) and each
+//    partition's engine is told the id of every NEW it runs
+//  - Frames are taken in windows of window_frames: split, replay in
+//    parallel, merge, next window. Memory is bounded by the window, not the
+//    capture; partitions keep their engines from one window to the next
+//  - Requests carry no session (as in replay), so no client order id index
+//    or auction state is involved; TIF_DAY orders are refused (no day end)
+// -----------------------------------------------------------------------------
+
+struct ReplayOptions {
+    unsigned threads = 0;             // 0: serial through one engine
+    uint32_t num_instruments = 0;     // listed as SYM4.. on top of the default three, as flowgen does
+    uint64_t window_frames = 1 << 14; // small enough that a window's frames and results stay in cache
+};
+
+struct ReplayStats {
+    uint64_t news = 0;
+    uint64_t cancels = 0;
+    uint64_t rejects = 0;
+    uint64_t trades = 0;
+    uint64_t levels = 0;
+    uint64_t partitions = 0;        // 1 when serial
+    uint64_t steals = 0;            // partitions run by a worker that did not get them dealt
+    uint64_t elapsed_ns = 0;        // first frame read to last result handed over
+    bool     consistent = true;     // false if a partition's engine accepted or refused a NEW the split pass did not predict
+};
+
+// Gets every replayed request's results, in capture order, on the thread
+// that called replay().
+class ReplaySink {
+public:
+    virtual ~ReplaySink() = default;
+    virtual void on_result(const Header& request, const AckBody& ack, std::span<const TradeBody> trades,
+                           std::span<const LevelUpdateBody> levels) = 0;
+};
+
+// Replays from the capture's current position to its end.
+ReplayStats replay(CaptureFile& capture, const ReplayOptions& opt, ReplaySink& sink);
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// SessionOutQueue: bounded, non-blocking output buffer for one client session.
+//  - Reliable frames (ACKs) are always queued, whatever the backlog
+//  - Conflatable frames (top-of-book, keyed by instrument) go straight into the
+//    stream while the backlog is under the watermark; above it only the latest
+//    frame per key is kept aside and released once the backlog drains
+//  - A session that stays above the byte cap for longer than max_over_cap_ns
+//    should be disconnected (should_disconnect)
+// The engine loop never blocks on a slow reader: flush() writes what the
+// socket accepts and leaves the rest queued.
+// -----------------------------------------------------------------------------
+
+struct OutQueueConfig {
+    size_t   watermark = 64 * 1024;         // start conflating above this backlog
+    size_t   cap = 4 * 1024 * 1024;         // hard backlog limit
+    uint64_t max_over_cap_ns = 1'000'000'000; // grace period above the cap
+};
+
+class SessionOutQueue {
+public:
+    explicit SessionOutQueue(OutQueueConfig cfg = {}) : cfg_(cfg) {}
+
+    void push_reliable(const uint8_t* frame, size_t len);
+    void push_conflatable(uint32_t key, const uint8_t* frame, size_t len);
+
+    // Write as much as the (non-blocking) socket accepts. Returns false on a
+    // socket error other than EAGAIN.
+    bool flush(int fd);
+
+    // Tracks how long the backlog has been above the cap.
+    bool should_disconnect(uint64_t now_ns);
+
+    // Drop everything (session is going away); pending conflated frames count as dropped.
+    void discard();
+
+    size_t bytes_queued() const { return buf_.size() - head_; }
+    bool has_output() const { return bytes_queued() > 0 || !pending_.empty(); }
+
+    uint64_t conflated() const { return conflated_; }
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    struct Pending {
+        uint32_t key;
+        std::vector<uint8_t> frame;
+    };
+
+    void append(const uint8_t* frame, size_t len);
+    void release_pending();
+
+    OutQueueConfig cfg_;
+    std::vector<uint8_t> buf_;
+    size_t head_ = 0;                          // bytes of buf_ already written
+    std::vector<Pending> pending_;             // conflated frames, oldest key first
+    std::unordered_map<uint32_t, size_t> pending_index_; // key -> index in pending_
+    uint64_t over_cap_since_ns_ = 0;
+    uint64_t conflated_ = 0;
+    uint64_t dropped_ = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// SpscRing: bounded single-producer / single-consumer lock-free queue.
+//  - Capacity is rounded up to a power of two so indices wrap with a mask
+//  - head_/tail_ live on separate cache lines so the two threads don't
+//    false-share; each side also caches the other side's index to avoid
+//    touching the shared line on every push/pop
+//  - T must be trivially copyable (slots are reused without destruction)
+// -----------------------------------------------------------------------------
+
+inline constexpr size_t kCacheLine = 64;
+
+template <typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing slots must be trivially copyable");
+public:
+    explicit SpscRing(size_t min_capacity) {
+        size_t cap = 2;
+        while (cap < min_capacity) {
+            cap <<= 1;
+        }
+        slots_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Producer side. Returns false if the ring is full.
+    bool try_push(const T& item) {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty.
+    bool try_pop(T& out) {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+        out = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate; only exact when called from one of the two owning threads
+    // while the other is idle.
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_ = 0;
+
+    alignas(kCacheLine) std::atomic<uint64_t> tail_{0}; // written by producer
+    uint64_t head_cache_ = 0;                           // producer's view of head_
+    alignas(kCacheLine) std::atomic<uint64_t> head_{0}; // written by consumer
+    uint64_t tail_cache_ = 0;                           // consumer's view of tail_
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "clock.hpp"
+#include "latency_histogram.hpp"
+#include "spsc_ring.hpp" // kCacheLine
+#include "wire.hpp"
+
+// -----------------------------------------------------------------------------
+// Stage latency: where a request's time goes, recorded in the server and the
+// engine as it happens.
+//  - One LatencyHistogram-shaped series per stage, in a per-thread shard
+//    allocated on first use, as for metrics.hpp: a record is index_of() plus
+//    a few relaxed loads and stores on lines no other thread writes
+//  - read() merges every shard into a LatencyHistogram, so any thread may
+//    dump while others record; shards of exited threads are reused
+//  - The LatencyStage order is part of the wire protocol (LatencyBody::stage):
+//    append only
+//  - -DMARKETFEED_METRICS=OFF compiles the recording and its extra clock
+//    reads out, with the counters
+// -----------------------------------------------------------------------------
+
+enum class LatencyStage : uint8_t {
+    // server: whole request, frame start -> reply queued, by type
+    NewTotal = 0,
+    CancelTotal,
+    MassCancelTotal,
+    StatsTotal,
+    // server: header + body decode
+    Decode,
+    // engine: receive -> checks passed (NEW, CANCEL, MASS_CANCEL)
+    Validate,
+    // engine, NEW: checks passed -> ACK stamped (matching and resting), by fills
+    Match0,
+    Match1,
+    Match2To4,
+    Match5To16,
+    Match17Plus,
+    // engine, CANCEL / MASS_CANCEL: checks passed -> ACK stamped
+    Cancel,
+    // server: ACK stamped -> frame on the session's queue
+    Encode,
+    // server: one non-blocking flush of a session's queue
+    Write,
+    kCount
+};
+
+inline constexpr size_t kNumLatencyStages = static_cast<size_t>(LatencyStage::kCount);
+
+// Stable snake_case name, e.g. "match_2_4"; used in dumps.
+const char* latency_stage_name(LatencyStage s);
+
+inline LatencyStage match_stage(size_t fills) {
+    if (fills <= 1) {
+        return fills == 0 ? LatencyStage::Match0 : LatencyStage::Match1;
+    }
+    return fills <= 4 ? LatencyStage::Match2To4 : fills <= 16 ? LatencyStage::Match5To16 : LatencyStage::Match17Plus;
+}
+
+// One thread's histograms, LatencyHistogram's bucket layout in atomics.
+// Single writer, so plain relaxed load + store.
+struct alignas(kCacheLine) LatencyShard {
+    struct Series {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> min{UINT64_MAX};
+        std::atomic<uint64_t> max{0};
+        std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets> counts{};
+    };
+    std::array<Series, kNumLatencyStages> series;
+
+    void add(LatencyStage s, uint64_t ns) {
+        Series& h = series[static_cast<size_t>(s)];
+        std::atomic<uint64_t>& b = h.counts[LatencyHistogram::index_of(ns)];
+        b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        h.count.store(h.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        h.sum.store(h.sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        if (ns < h.min.load(std::memory_order_relaxed)) {
+            h.min.store(ns, std::memory_order_relaxed);
+        }
+        if (ns > h.max.load(std::memory_order_relaxed)) {
+            h.max.store(ns, std::memory_order_relaxed);
+        }
+    }
+};
+
+namespace latency {
+
+// Gives the calling thread a shard (once; takes a lock).
+LatencyShard* register_thread();
+
+inline thread_local LatencyShard* t_shard = nullptr;
+
+// A clock read only taken for a stage boundary; 0 when recording is compiled out.
+inline uint64_t stamp() noexcept {
+#ifndef MARKETFEED_NO_METRICS
+    return clk::now_ns();
+#else
+    return 0;
+#endif
+}
+
+inline void record(LatencyStage s, uint64_t ns) {
+#ifndef MARKETFEED_NO_METRICS
+    LatencyShard* sh = t_shard;
+    if (sh == nullptr) [[unlikely]] {
+        sh = register_thread();
+    }
+    sh->add(s, ns);
+#else
+    (void)s;
+    (void)ns;
+#endif
+}
+
+// from -> to; a clock that stepped back records 0.
+inline void record(LatencyStage s, uint64_t from_ns, uint64_t to_ns) {
+    record(s, to_ns > from_ns ? to_ns - from_ns : 0);
+}
+
+// One stage over every thread that ever recorded. O(shards * buckets); takes the lock.
+LatencyHistogram read(LatencyStage s);
+
+// One line per stage with samples: name, count, min, p50/p90/p99/p99.9, max, mean.
+std::string format();
+
+// LATENCY frames for a STATS reply: one per stage with samples, in stage order.
+std::vector<LatencyBody> latency_bodies(uint64_t request_id);
+
+} // namespace latency
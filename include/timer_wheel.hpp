@@ -0,0 +1,187 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// -----------------------------------------------------------------------------
+// TimerWheel: hierarchical timing wheel for order expiry (GTT / DAY).
+//  - Time is counted in ticks of 2^kTickShift ns (~1.05 ms); an expiry is
+//    rounded up to a tick, so a timer never fires before its time
+//  - kLevels wheels of 256 slots: a timer sits on the level of the highest
+//    byte where its tick differs from the current one, in the slot of that
+//    byte. Crossing a byte boundary moves the slot due next one level down
+//    (each timer cascades at most kLevels - 1 times over its life), and
+//    level-0 slots hold timers due on exactly one tick
+//  - Timers are intrusive (TimerLink, embedded in the object that expires):
+//    schedule and unschedule are O(1), with no allocation and no pointer to
+//    the wheel
+//  - advance() jumps from one occupied slot to the next through per-level
+//    occupancy bitmaps, so an idle stretch of hours costs a few bit scans,
+//    and hands every due timer to the caller in bulk
+//  - Single-threaded, like the books whose orders it times
+// -----------------------------------------------------------------------------
+
+// Intrusive links of a scheduled timer: circular through the slot's sentinel,
+// so unscheduling needs no pointer to the wheel; null links when idle.
+struct TimerLink {
+    TimerLink* prev = nullptr;
+    TimerLink* next = nullptr;
+    uint64_t expire_tick = 0;
+
+    bool scheduled() const { return next != nullptr; }
+    void unschedule() {
+        prev->next = next;
+        next->prev = prev;
+        prev = next = nullptr;
+    }
+};
+
+class TimerWheel {
+public:
+    static constexpr unsigned kTickShift = 20;
+    static constexpr unsigned kSlotBits = 8;
+    static constexpr size_t kSlots = size_t(1) << kSlotBits;
+    static constexpr unsigned kLevels = 6; // 2^48 ticks: any uint64_t ns
+
+    // Ticks up to now_ns count as already processed.
+    explicit TimerWheel(uint64_t now_ns = 0) : cur_(now_ns >> kTickShift) {
+        for (auto& level : slots_) {
+            for (TimerLink& s : level) {
+                s.prev = s.next = &s;
+            }
+        }
+    }
+    // Slots link back to their own sentinels: the wheel stays where it was built.
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    static uint64_t tick_of(uint64_t ns) { return (ns >> kTickShift) + ((ns & ((uint64_t(1) << kTickShift) - 1)) != 0); }
+
+    // Arms t (which must not be scheduled) to fire at the first advance() to
+    // a time >= expire_ns; an expiry already passed fires on the next tick.
+    void schedule(TimerLink* t, uint64_t expire_ns) {
+        const uint64_t tick = tick_of(expire_ns);
+        t->expire_tick = tick > cur_ ? tick : cur_ + 1;
+        insert(t);
+    }
+    static void unschedule(TimerLink* t) {
+        if (t->scheduled()) {
+            t->unschedule();
+        }
+    }
+
+    // Processes every tick up to now_ns: fire(TimerLink*) is called once per
+    // due timer, in tick order, with the timer already unscheduled; it may
+    // unschedule (or schedule) others. Returns the number fired.
+    template <class Fire>
+    size_t advance(uint64_t now_ns, Fire&& fire) {
+        const uint64_t target = now_ns >> kTickShift;
+        size_t fired = 0;
+        while (cur_ < target) {
+            uint64_t tick;
+            if (!next_event(tick) || tick > target) {
+                cur_ = target;
+                break;
+            }
+            cur_ = tick;
+            // a boundary of level L (lower bytes all zero): its due slot moves down
+            for (unsigned level = kLevels - 1; level > 0; --level) {
+                if ((cur_ & ((uint64_t(1) << (kSlotBits * level)) - 1)) == 0) {
+                    TimerLink due;
+                    take(level, slot_of(cur_, level), due);
+                    while (due.next != &due) {
+                        TimerLink* t = due.next;
+                        t->unschedule();
+                        insert(t);
+                    }
+                }
+            }
+            TimerLink due;
+            take(0, slot_of(cur_, 0), due);
+            while (due.next != &due) {
+                TimerLink* t = due.next;
+                t->unschedule();
+                ++fired;
+                fire(t);
+            }
+        }
+        return fired;
+    }
+
+    // Last tick processed.
+    uint64_t now_tick() const { return cur_; }
+
+private:
+    using Bitmap = std::array<uint64_t, kSlots / 64>;
+
+    static size_t slot_of(uint64_t tick, unsigned level) {
+        return size_t(tick >> (kSlotBits * level)) & (kSlots - 1);
+    }
+
+    void insert(TimerLink* t) {
+        const uint64_t diff = t->expire_tick ^ cur_;
+        const unsigned level = diff < kSlots ? 0 : unsigned(std::bit_width(diff) - 1) / kSlotBits;
+        const size_t slot = slot_of(t->expire_tick, level);
+        TimerLink& head = slots_[level][slot];
+        t->prev = head.prev;
+        t->next = &head;
+        head.prev->next = t;
+        head.prev = t;
+        occupied_[level][slot / 64] |= uint64_t(1) << (slot % 64);
+    }
+
+    // Moves a whole slot onto the empty sentinel `out` and clears its bit.
+    void take(unsigned level, size_t slot, TimerLink& out) {
+        TimerLink& head = slots_[level][slot];
+        occupied_[level][slot / 64] &= ~(uint64_t(1) << (slot % 64));
+        if (head.next == &head) {
+            out.prev = out.next = &out;
+            return;
+        }
+        out.next = head.next;
+        out.prev = head.prev;
+        out.next->prev = &out;
+        out.prev->next = &out;
+        head.prev = head.next = &head;
+    }
+
+    // First occupied slot of a level after `after`; bits of slots emptied by
+    // unschedule() are cleared here, lazily.
+    bool first_after(unsigned level, size_t after, size_t& slot) {
+        for (size_t w = (after + 1) / 64; w < kSlots / 64; ++w) {
+            uint64_t bits = occupied_[level][w];
+            if (w == (after + 1) / 64) {
+                bits &= ~uint64_t(0) << ((after + 1) % 64);
+            }
+            while (bits != 0) {
+                const size_t s = w * 64 + size_t(std::countr_zero(bits));
+                if (slots_[level][s].next != &slots_[level][s]) {
+                    slot = s;
+                    return true;
+                }
+                occupied_[level][w] &= ~(uint64_t(1) << (s % 64));
+                bits &= bits - 1;
+            }
+        }
+        return false;
+    }
+
+    // The first tick after cur_ with timers to fire or cascade; a lower level
+    // always has the earlier one. False if the wheel is empty.
+    bool next_event(uint64_t& tick) {
+        for (unsigned level = 0; level < kLevels; ++level) {
+            size_t slot;
+            if (slot_of(cur_, level) + 1 < kSlots && first_after(level, slot_of(cur_, level), slot)) {
+                const unsigned shift = kSlotBits * level;
+                tick = ((cur_ >> (shift + kSlotBits)) << (shift + kSlotBits)) | (uint64_t(slot) << shift);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t cur_;
+    std::array<std::array<TimerLink, kSlots>, kLevels> slots_;
+    std::array<Bitmap, kLevels> occupied_{};
+};
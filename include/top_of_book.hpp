@@ -0,0 +1,114 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "spsc_ring.hpp" // kCacheLine
+#include "wire.hpp"
+
+// -----------------------------------------------------------------------------
+// TopOfBookCache: every instrument's current BBO, written by the engine
+// thread and read by any number of other threads (risk, pricing) with no
+// lock and no call into the engine.
+//  - One cache line per instrument: a sequence word and the BboBody, so a
+//    publish dirties one line and readers of other instruments never see it
+//  - Seqlock: the writer makes the sequence odd, stores the fields, makes it
+//    even again. It never waits for a reader; a reader that saw an odd or
+//    changed sequence simply reads again. Fields are relaxed atomics, so a
+//    torn read is discarded, never undefined behaviour
+//  - Single writer (Engine::flush_bbo()); capacity is fixed at construction
+//    so the array never moves under a reader
+// -----------------------------------------------------------------------------
+
+// One consistent read of an instrument's slot.
+struct TopOfBook {
+    BboBody bbo;
+    uint64_t version; // publishes of this instrument so far, counting from 1
+};
+
+class TopOfBookCache {
+public:
+    // Slots for instrument ids 1..max_instruments.
+    explicit TopOfBookCache(size_t max_instruments) : slots_(max_instruments + 1) {}
+    TopOfBookCache(const TopOfBookCache&) = delete;
+    TopOfBookCache& operator=(const TopOfBookCache&) = delete;
+
+    size_t max_instruments() const { return slots_.size() - 1; }
+
+    // Writer only. False (nothing stored) for an id beyond capacity.
+    bool publish(const BboBody& bbo) noexcept {
+        if (bbo.instrument_id == 0 || bbo.instrument_id >= slots_.size()) {
+            return false;
+        }
+        Slot& s = slots_[bbo.instrument_id];
+        uint64_t words[kWords];
+        std::memcpy(words, &bbo, sizeof(BboBody));
+        const uint64_t seq = s.seq.load(std::memory_order_relaxed);
+        s.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release); // odd before any field
+        for (size_t i = 0; i < kWords; ++i) {
+            s.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        s.seq.store(seq + 2, std::memory_order_release);
+        return true;
+    }
+
+    // Any thread. Retries while a publish is in flight, which takes a few
+    // stores; false for an unknown id or one never published.
+    bool read(uint32_t instrument_id, TopOfBook& out) const noexcept {
+        if (instrument_id == 0 || instrument_id >= slots_.size()) {
+            return false;
+        }
+        const Slot& s = slots_[instrument_id];
+        uint64_t words[kWords];
+        for (;;) {
+            const uint64_t before = s.seq.load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                for (size_t i = 0; i < kWords; ++i) {
+                    words[i] = s.words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire); // fields before the re-check
+                if (s.seq.load(std::memory_order_relaxed) == before) {
+                    if (before == 0) {
+                        return false;
+                    }
+                    std::memcpy(&out.bbo, words, sizeof(BboBody));
+                    out.version = before / 2;
+                    return true;
+                }
+            }
+            cpu_relax();
+        }
+    }
+
+    // Publishes so far (0 if none), to poll for a change without a full read.
+    uint64_t version(uint32_t instrument_id) const noexcept {
+        if (instrument_id == 0 || instrument_id >= slots_.size()) {
+            return 0;
+        }
+        return slots_[instrument_id].seq.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr size_t kWords = sizeof(BboBody) / sizeof(uint64_t);
+    static_assert(sizeof(BboBody) % sizeof(uint64_t) == 0, "BboBody is copied as whole words");
+
+    struct alignas(kCacheLine) Slot {
+        std::atomic<uint64_t> seq{0}; // odd while a publish is in flight
+        std::array<std::atomic<uint64_t>, kWords> words{};
+    };
+    static_assert(sizeof(Slot) == kCacheLine, "one cache line per instrument");
+
+    static void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    std::vector<Slot> slots_;
+};
@@ -9,12 +9,25 @@ enum class MsgType: uint8_t {
     CANCEL = 2,
     ACK = 3, // this one can also be rejected (NACK)
     TRADE = 4,
+    BOOK_UPDATE = 5,      // market data: aggregated price level changed
+    RETRANS_REQUEST = 6,  // market data gap fill request (retransmit server)
+    RETRANS_RESPONSE = 7, // precedes the retransmitted frames
+    SNAPSHOT_REQUEST = 8, // late joiner asks for one instrument's book
+    SNAPSHOT = 9,         // followed by num_levels BOOK_UPDATE frames
+    BBO = 10,             // top of book: best level on each side
+    BAR = 11,             // completed OHLCV time bar for one instrument
+    MASS_CANCEL = 12,     // cancel the sender's resting orders in bulk; one ACK with the count
+    STATS_REQUEST = 13,   // ask the server for its counters
+    STATS = 14,           // reply on the same session: every counter, summed over threads
+    LATENCY = 15,         // follows STATS: one stage's latency percentiles (stage_latency.hpp)
 };
 
 inline constexpr uint8_t kProtocolVersion = 1;
 constexpr size_t kMaxFrame = 64 * 1024;
 constexpr uint8_t TIF_IOC = 0x1; // bit0: Immediate-Or-Cancel
 constexpr uint8_t TIF_FOK = 0x2; // bit1: Fill-Or-Kill
+constexpr uint8_t TIF_DAY = 0x4; // bit2: rests until the engine's end of day
+constexpr uint8_t TIF_GTT = 0x8; // bit3: Good-Till-Time, rests for expire_after_s
 
 // Naturally aligned header, expected to be 24 bytes on ARM64/x86_64
 struct Header {
@@ -35,7 +48,7 @@ struct OrderNewBody {
     uint32_t instrument_id;
     uint8_t side;
     uint8_t flags;
-    uint16_t pad;
+    uint16_t expire_after_s; // TIF_GTT: lifetime from engine receipt, 1..65535 s; else 0
 };
 
 static_assert(sizeof(OrderNewBody) == 32, "OrderNewBody must be 32 bytes (natural alignment)");
@@ -54,11 +67,25 @@ static_assert(sizeof(OrderCancelBody) == 24, "OrderCancelBody must be 24 bytes (
 static_assert(std::is_trivially_copyable_v<OrderCancelBody>, "OrderCancelBody must be trivially copyable");
 static_assert(sizeof(Header) + sizeof(OrderCancelBody) == 48, "OrderCancel message must be 48 bytes (natural alignment)");
 
+// Filters of a MASS_CANCEL; only the sender's own orders are ever cancelled.
+inline constexpr uint32_t kAllInstruments = 0;
+inline constexpr uint8_t kBothSides = 2;
+
+struct MassCancelBody {
+    uint64_t client_order_id;   // echoed in the ACK
+    uint32_t instrument_id;     // kAllInstruments for every instrument
+    uint8_t  side;              // 0=bid, 1=ask, kBothSides
+    uint8_t  _pad3[3]{};
+};
+static_assert(sizeof(MassCancelBody) == 16, "MassCancelBody must be 16 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<MassCancelBody>, "MassCancelBody must be trivially copyable");
+
 struct AckBody {
     uint64_t client_order_id;
     uint64_t exch_order_id;     // 0 if NACK and no ID assigned
     uint8_t  status;            // 0=ACK, 1=NACK
-    uint8_t  _pad7[7]{};        // align next u64 (explicit for clarity)
+    uint8_t  _pad3[3]{};        // align next u32 (explicit for clarity)
+    uint32_t cancelled_count;   // MASS_CANCEL: orders cancelled, 0 otherwise
     uint64_t ts_engine_recv_ns; // when engine ingested NEW
     uint64_t ts_engine_ack_ns;  // when engine emitted ACK/NACK
 };
@@ -69,13 +96,145 @@ static_assert(sizeof(Header) + sizeof(AckBody) == 64, "Ack message must be 64 by
 struct TradeBody {
     int64_t  price_ticks;
     int32_t  qty;
-    uint8_t  liquidity_flag;    // 0=aggressor buy, 1=aggressor sell
+    uint8_t  liquidity_flag;    // 0=aggressor buy, 1=aggressor sell, 2=auction uncross (no aggressor)
     uint8_t  _pad3[3]{};        // align next u64
-    uint64_t resting_exch_order_id; // maker
-    uint64_t taking_exch_order_id;  // taker
+    uint64_t resting_exch_order_id; // maker (auction: the sell order)
+    uint64_t taking_exch_order_id;  // taker (auction: the buy order)
     uint32_t instrument_id;
-    // implicit padding to 40
+    uint8_t  _pad4[4]{};        // explicit, so every trade encodes to the same bytes
 };
 static_assert(sizeof(TradeBody) == 40, "TradeBody must be 40 bytes (natural alignment)");
 static_assert(std::is_trivially_copyable_v<TradeBody>, "TradeBody must be trivially copyable");
-static_assert(sizeof(Header) + sizeof(TradeBody) == 64, "Trade message must be 64 bytes (natural alignment)");
\ No newline at end of file
+static_assert(sizeof(Header) + sizeof(TradeBody) == 64, "Trade message must be 64 bytes (natural alignment)");
+
+inline constexpr uint8_t kLiquidityAuction = 2;
+
+// Market data: one aggregated price level after a change.
+enum class LevelAction : uint8_t {
+    ADD = 0,    // level created
+    UPDATE = 1, // total_qty / order_count changed
+    DELETE = 2, // level removed (total_qty and order_count are 0)
+};
+
+struct LevelUpdateBody {
+    int64_t  price_ticks;
+    int64_t  total_qty;         // sum of remaining qty at this level
+    uint32_t order_count;       // resting orders at this level
+    uint32_t instrument_id;
+    uint8_t  side;              // 0=bid, 1=ask
+    uint8_t  action;            // LevelAction
+    uint8_t  _pad6[6]{};
+};
+static_assert(sizeof(LevelUpdateBody) == 32, "LevelUpdateBody must be 32 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<LevelUpdateBody>, "LevelUpdateBody must be trivially copyable");
+
+// Gap fill: ask the retransmit server for [begin_seqno, begin_seqno + count).
+struct RetransRequestBody {
+    uint64_t begin_seqno;
+    uint32_t count;
+    uint32_t _pad4{};
+};
+static_assert(sizeof(RetransRequestBody) == 16, "RetransRequestBody must be 16 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<RetransRequestBody>, "RetransRequestBody must be trivially copyable");
+
+// Sent before the retransmitted frames. count may be smaller than requested
+// if part of the range already fell out of the server's ring (status=1).
+struct RetransResponseBody {
+    uint64_t begin_seqno;       // first seqno actually sent
+    uint32_t count;             // number of frames that follow
+    uint8_t  status;            // 0=complete, 1=partial/unavailable
+    uint8_t  _pad3[3]{};
+};
+static_assert(sizeof(RetransResponseBody) == 16, "RetransResponseBody must be 16 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<RetransResponseBody>, "RetransResponseBody must be trivially copyable");
+
+struct SnapshotRequestBody {
+    uint32_t instrument_id;
+    uint32_t _pad4{};
+};
+static_assert(sizeof(SnapshotRequestBody) == 8, "SnapshotRequestBody must be 8 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<SnapshotRequestBody>, "SnapshotRequestBody must be trivially copyable");
+
+// Book state as of md_seqno: apply incrementals with seqno > md_seqno on top.
+// The levels follow as BOOK_UPDATE frames (action=ADD, header seqno 0),
+// bids best-first then asks best-first.
+struct SnapshotBody {
+    uint64_t md_seqno;
+    uint32_t instrument_id;
+    uint32_t num_levels;
+    uint8_t  status;            // 0=ok, 1=unknown instrument, 2=busy (retry)
+    uint8_t  _pad7[7]{};
+};
+static_assert(sizeof(SnapshotBody) == 24, "SnapshotBody must be 24 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<SnapshotBody>, "SnapshotBody must be trivially copyable");
+
+// Top of book for one instrument. An empty side has total_qty 0 and order_count 0.
+struct BboBody {
+    int64_t  bid_price_ticks;
+    int64_t  bid_total_qty;
+    int64_t  ask_price_ticks;
+    int64_t  ask_total_qty;
+    uint32_t bid_order_count;
+    uint32_t ask_order_count;
+    uint32_t instrument_id;
+    uint32_t _pad4{};
+};
+static_assert(sizeof(BboBody) == 48, "BboBody must be 48 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<BboBody>, "BboBody must be trivially copyable");
+static_assert(sizeof(Header) + sizeof(BboBody) == 72, "BBO message must be 72 bytes (natural alignment)");
+
+// Completed time bar [start_ns, start_ns + interval_ns) for one instrument.
+// start_ns is wall-clock time (ns since the Unix epoch, UTC), a multiple of
+// interval_ns, so a 1 min bar covers one calendar minute.
+// VWAP = notional / volume (kept as integers so bars merge exactly).
+struct BarBody {
+    int64_t  open_ticks;
+    int64_t  high_ticks;
+    int64_t  low_ticks;
+    int64_t  close_ticks;
+    int64_t  volume;        // sum of trade qty
+    int64_t  notional;      // sum of price_ticks * qty
+    uint64_t start_ns;
+    uint64_t interval_ns;
+    uint32_t instrument_id;
+    uint32_t trade_count;
+};
+static_assert(sizeof(BarBody) == 72, "BarBody must be 72 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<BarBody>, "BarBody must be trivially copyable");
+
+// Counter totals, in Metric order (metrics.hpp); values past num_values are 0.
+inline constexpr uint32_t kMaxStatsValues = 32;
+
+struct StatsRequestBody {
+    uint64_t request_id;        // echoed in the reply
+};
+static_assert(sizeof(StatsRequestBody) == 8, "StatsRequestBody must be 8 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<StatsRequestBody>, "StatsRequestBody must be trivially copyable");
+
+struct StatsBody {
+    uint64_t request_id;
+    uint64_t ts_ns;             // when the counters were read
+    uint32_t num_values;
+    uint32_t num_latency;       // LATENCY frames that follow, one per stage with samples
+    uint64_t values[kMaxStatsValues];
+};
+static_assert(sizeof(StatsBody) == 280, "StatsBody must be 280 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<StatsBody>, "StatsBody must be trivially copyable");
+
+// One stage's latency distribution, in LatencyStage order (stage_latency.hpp).
+// Percentiles are within 1/128 of the true value (latency_histogram.hpp).
+struct LatencyBody {
+    uint64_t request_id;        // the STATS_REQUEST's
+    uint64_t count;
+    uint64_t min_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+    uint64_t mean_ns;
+    uint8_t  stage;             // LatencyStage
+    uint8_t  _pad7[7]{};
+};
+static_assert(sizeof(LatencyBody) == 80, "LatencyBody must be 80 bytes (natural alignment)");
+static_assert(std::is_trivially_copyable_v<LatencyBody>, "LatencyBody must be trivially copyable");
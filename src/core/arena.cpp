@@ -0,0 +1,221 @@
+#include "arena.hpp"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#endif
+
+namespace {
+
+size_t round_up(size_t n, size_t to) {
+    return (n + to - 1) / to * to;
+}
+
+void* map_anon(size_t len, int extra_flags) {
+    void* p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+// A 2MB-aligned mapping of len (a 2MB multiple): over-map by 2MB, trim both ends.
+void* map_aligned(size_t len) {
+    char* raw = static_cast<char*>(map_anon(len + Arena::kHugePage, 0));
+    if (raw == nullptr) {
+        return nullptr;
+    }
+    char* p = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(raw), Arena::kHugePage));
+    if (p > raw) {
+        ::munmap(raw, size_t(p - raw));
+    }
+    const size_t tail = size_t(raw + len + Arena::kHugePage - (p + len));
+    if (tail > 0) {
+        ::munmap(p + len, tail);
+    }
+    return p;
+}
+
+// Prefer `node` for pages not yet touched; false if the kernel refused.
+bool prefer_node(void* p, size_t len, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    if (node < 0 || node >= 64) {
+        return false;
+    }
+    const unsigned long mask = 1ul << node;
+    return ::syscall(SYS_mbind, p, len, MPOL_PREFERRED, &mask, 64ul, 0u) == 0;
+#else
+    (void)p;
+    (void)len;
+    (void)node;
+    return false;
+#endif
+}
+
+int current_node() {
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return int(node);
+    }
+#endif
+    return -1;
+}
+
+} // namespace
+
+const char* arena_pages_name(ArenaPages p) {
+    switch (p) {
+        case ArenaPages::Auto: return "auto";
+        case ArenaPages::Explicit: return "explicit";
+        case ArenaPages::Transparent: return "transparent";
+        case ArenaPages::Normal: return "normal";
+    }
+    return "unknown";
+}
+
+bool parse_arena_pages(const char* s, ArenaPages& out) {
+    for (ArenaPages p : {ArenaPages::Auto, ArenaPages::Explicit, ArenaPages::Transparent, ArenaPages::Normal}) {
+        if (std::strcmp(s, arena_pages_name(p)) == 0) {
+            out = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+Arena::Arena(const ArenaConfig& cfg) : cfg_(cfg) {
+    cfg_.region_bytes = round_up(std::max(cfg_.region_bytes, kHugePage), kHugePage);
+    next_try_ = cfg_.pages == ArenaPages::Auto ? ArenaPages::Explicit : cfg_.pages;
+    if (cfg_.bind_local_node) {
+        node_ = current_node();
+    }
+    // the first region now, so backing() tells what the books will get
+    size_t len = cfg_.region_bytes;
+    if (void* p = map(len)) {
+        regions_.push_back({p, len});
+        cur_ = static_cast<char*>(p);
+        end_ = cur_ + len;
+    }
+}
+
+Arena::~Arena() {
+    for (const auto& [addr, m] : large_) {
+        ::munmap(m.addr, m.len);
+    }
+    for (const Mapping& m : regions_) {
+        ::munmap(m.addr, m.len);
+    }
+}
+
+size_t Arena::class_of(size_t bytes) {
+    if (bytes <= kMaxSmall) {
+        return bytes == 0 ? 0 : (bytes - 1) / kAlign;
+    }
+    // 513..1024 -> kNumSmall, ..., up to kMaxPooled
+    return kNumSmall + size_t(std::bit_width(bytes - 1)) - 10;
+}
+
+size_t Arena::class_size(size_t cls) {
+    return cls < kNumSmall ? (cls + 1) * kAlign : size_t(1) << (cls - kNumSmall + 10);
+}
+
+void* Arena::map(size_t& len) {
+    len = round_up(len, kHugePage);
+    for (;;) {
+        void* p = nullptr;
+        switch (next_try_) {
+            case ArenaPages::Auto:
+            case ArenaPages::Explicit:
+#ifdef MAP_HUGETLB
+                p = map_anon(len, MAP_HUGETLB);
+#endif
+                break;
+            case ArenaPages::Transparent:
+#ifdef MADV_HUGEPAGE
+                p = map_aligned(len);
+                if (p != nullptr && ::madvise(p, len, MADV_HUGEPAGE) != 0) {
+                    // THP disabled: keep the mapping, it is just normal pages
+                    next_try_ = ArenaPages::Normal;
+                }
+#endif
+                break;
+            case ArenaPages::Normal:
+                p = map_anon(len, 0);
+                if (p == nullptr) {
+                    return nullptr;
+                }
+                break;
+        }
+        if (p != nullptr) {
+            backing_ = next_try_;
+            if (node_ >= 0 && !prefer_node(p, len, node_)) {
+                node_ = -1;
+            }
+            mapped_bytes_ += len;
+            return p;
+        }
+        // this kind is unavailable (e.g. no hugetlbfs pool): stop trying it
+        next_try_ = next_try_ == ArenaPages::Transparent ? ArenaPages::Normal : ArenaPages::Transparent;
+    }
+}
+
+void* Arena::carve(size_t bytes) {
+    if (size_t(end_ - cur_) < bytes) {
+        size_t len = std::max(cfg_.region_bytes, bytes);
+        void* p = map(len);
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        regions_.push_back({p, len});
+        cur_ = static_cast<char*>(p);
+        end_ = cur_ + len;
+    }
+    void* p = cur_;
+    cur_ += bytes;
+    return p;
+}
+
+void* Arena::allocate(size_t bytes) {
+    if (bytes > kMaxPooled) {
+        size_t len = bytes;
+        void* p = map(len);
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        large_.emplace(p, Mapping{p, len});
+        used_bytes_ += len;
+        return p;
+    }
+    const size_t cls = class_of(bytes);
+    used_bytes_ += class_size(cls);
+    if (FreeBlock* b = free_[cls]) {
+        free_[cls] = b->next;
+        return b;
+    }
+    return carve(class_size(cls));
+}
+
+void Arena::deallocate(void* p, size_t bytes) noexcept {
+    if (p == nullptr) {
+        return;
+    }
+    if (bytes > kMaxPooled) {
+        const auto it = large_.find(p);
+        if (it != large_.end()) {
+            ::munmap(it->second.addr, it->second.len);
+            used_bytes_ -= it->second.len;
+            mapped_bytes_ -= it->second.len;
+            large_.erase(it);
+        }
+        return;
+    }
+    const size_t cls = class_of(bytes);
+    used_bytes_ -= class_size(cls);
+    FreeBlock* b = static_cast<FreeBlock*>(p);
+    b->next = free_[cls];
+    free_[cls] = b;
+}
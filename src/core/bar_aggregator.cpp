@@ -0,0 +1,105 @@
+#include "bar_aggregator.hpp"
+#include <algorithm>
+#include <utility>
+
+BarAggregator::BarAggregator(uint32_t max_instruments, std::vector<uint64_t> intervals_ns, size_t out_capacity)
+    : max_instruments_(max_instruments), intervals_(std::move(intervals_ns)), out_(out_capacity) {
+    std::erase(intervals_, uint64_t(0));
+    const size_t slots = size_t(max_instruments_) * intervals_.size();
+    open_.assign(slots, 0);
+    high_.assign(slots, 0);
+    low_.assign(slots, 0);
+    close_.assign(slots, 0);
+    volume_.assign(slots, 0);
+    notional_.assign(slots, 0);
+    start_.assign(slots, 0);
+    count_.assign(slots, 0);
+}
+
+void BarAggregator::on_trade(const TradeBody& t, uint64_t ts_ns) {
+    if (t.instrument_id >= max_instruments_) [[unlikely]] {
+        ++trades_ignored_;
+        return;
+    }
+    const int64_t px = t.price_ticks;
+    const int64_t qty = t.qty;
+    for (size_t k = 0; k < intervals_.size(); ++k) {
+        const size_t s = slot(t.instrument_id, k);
+        uint64_t start = ts_ns - ts_ns % intervals_[k];
+        if (count_[s] != 0 && start < start_[s]) {
+            start = start_[s]; // the clock stepped back: stays in the open bar
+        }
+        if (count_[s] != 0 && start_[s] != start) {
+            close(s);
+        }
+        if (count_[s] == 0) {
+            open_[s] = high_[s] = low_[s] = px;
+            volume_[s] = notional_[s] = 0;
+            start_[s] = start;
+            next_expiry_ = std::min(next_expiry_, start + intervals_[k]);
+        }
+        high_[s] = std::max(high_[s], px);
+        low_[s] = std::min(low_[s], px);
+        close_[s] = px;
+        volume_[s] += qty;
+        notional_[s] += px * qty;
+        ++count_[s];
+    }
+}
+
+void BarAggregator::close_expired(uint64_t now_ns) {
+    if (now_ns < next_expiry_) {
+        return;
+    }
+    next_expiry_ = UINT64_MAX;
+    for (uint32_t id = 0; id < max_instruments_; ++id) {
+        for (size_t k = 0; k < intervals_.size(); ++k) {
+            const size_t s = slot(id, k);
+            if (count_[s] == 0) {
+                continue;
+            }
+            const uint64_t end = start_[s] + intervals_[k];
+            if (end <= now_ns) {
+                close(s);
+            } else {
+                next_expiry_ = std::min(next_expiry_, end);
+            }
+        }
+    }
+}
+
+bool BarAggregator::current(uint32_t instrument_id, size_t interval_index, BarBody& out) const {
+    if (instrument_id >= max_instruments_ || interval_index >= intervals_.size()) {
+        return false;
+    }
+    const size_t s = slot(instrument_id, interval_index);
+    if (count_[s] == 0) {
+        return false;
+    }
+    out = make_bar(s);
+    return true;
+}
+
+BarBody BarAggregator::make_bar(size_t s) const {
+    BarBody b{};
+    b.open_ticks = open_[s];
+    b.high_ticks = high_[s];
+    b.low_ticks = low_[s];
+    b.close_ticks = close_[s];
+    b.volume = volume_[s];
+    b.notional = notional_[s];
+    b.start_ns = start_[s];
+    b.interval_ns = intervals_[s % intervals_.size()];
+    b.instrument_id = static_cast<uint32_t>(s / intervals_.size());
+    b.trade_count = count_[s];
+    return b;
+}
+
+void BarAggregator::close(size_t s) {
+    if (out_.try_push(make_bar(s))) {
+        ++bars_closed_;
+    } else {
+        ++bars_dropped_;
+    }
+    count_[s] = 0;
+}
@@ -0,0 +1,105 @@
+#include "capture.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+
+CaptureWriter::~CaptureWriter() {
+    close();
+}
+
+bool CaptureWriter::open(const std::string& path, uint64_t seed) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        std::perror(("capture: cannot create " + path).c_str());
+        return false;
+    }
+    frames_ = 0;
+    failed_ = false;
+    CaptureFileHeader h{};
+    std::memcpy(h.magic, kCaptureMagic, sizeof(h.magic));
+    h.version = kCaptureVersion;
+    h.header_bytes = sizeof(CaptureFileHeader);
+    h.seed = seed;
+    if (std::fwrite(&h, sizeof(h), 1, file_) != 1) {
+        failed_ = true;
+    }
+    return !failed_;
+}
+
+bool CaptureWriter::close() {
+    if (!file_) {
+        return !failed_;
+    }
+    // the frame count is only known now
+    const uint64_t n = frames_;
+    if (std::fseek(file_, offsetof(CaptureFileHeader, num_frames), SEEK_SET) != 0 ||
+        std::fwrite(&n, sizeof(n), 1, file_) != 1) {
+        failed_ = true;
+    }
+    if (std::fclose(file_) != 0) {
+        failed_ = true;
+    }
+    file_ = nullptr;
+    return !failed_;
+}
+
+CaptureFile::~CaptureFile() {
+    if (data_) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+bool CaptureFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::perror(("capture: cannot open " + path).c_str());
+        return false;
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) < 0 || size_t(st.st_size) < sizeof(CaptureFileHeader)) {
+        std::cerr << "capture: " << path << " is too short to be a capture\n";
+        ::close(fd);
+        return false;
+    }
+    void* p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        std::perror(("capture: mmap " + path).c_str());
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(p);
+    size_ = size_t(st.st_size);
+    pos_ = size_; // nothing to read unless validation passes
+
+    std::memcpy(&hdr_, data_, sizeof(hdr_));
+    if (std::memcmp(hdr_.magic, kCaptureMagic, sizeof(kCaptureMagic)) != 0 || hdr_.version != kCaptureVersion ||
+        hdr_.header_bytes < sizeof(CaptureFileHeader) || hdr_.header_bytes > size_) {
+        std::cerr << "capture: " << path << " has a bad file header\n";
+        return false;
+    }
+
+    // one pass over the frame boundaries so next() needn't check them
+    uint64_t n = 0;
+    size_t off = hdr_.header_bytes;
+    while (off < size_) {
+        Header h{};
+        if (size_ - off < sizeof(Header)) {
+            break;
+        }
+        std::memcpy(&h, data_ + off, sizeof(Header));
+        if (h.size < sizeof(Header) || h.size > size_ - off) {
+            break;
+        }
+        off += h.size;
+        ++n;
+    }
+    if (off != size_ || n != hdr_.num_frames) {
+        std::cerr << "capture: " << path << " is truncated or corrupt (" << n << " of "
+                  << hdr_.num_frames << " frames readable)\n";
+        return false;
+    }
+    pos_ = hdr_.header_bytes;
+    return true;
+}
@@ -0,0 +1,207 @@
+#include "clock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#ifdef MARKETFEED_HAVE_TSC
+#include <cpuid.h>
+#endif
+
+namespace {
+
+uint64_t steady_ns() noexcept {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t system_ns() noexcept {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+constexpr uint64_t kFirstResyncNs = 10'000'000;
+
+struct State {
+    std::mutex mu;
+    std::atomic<bool> initialized{false};
+    clk::Source source = clk::Source::Steady;
+    uint64_t base_tsc = 0;   // first anchor: the rate is fitted from here
+    uint64_t base_ns = 0;
+    uint64_t interval_ns = kFirstResyncNs;
+    double hz = 0.0;
+    std::atomic<int64_t> wall_offset{0}; // system_clock - steady_clock
+};
+
+State& state() {
+    static State* s = new State; // never destroyed: stamps may be taken during exit
+    return *s;
+}
+
+#ifdef MARKETFEED_HAVE_TSC
+bool invariant_tsc() {
+    unsigned a = 0, b = 0, c = 0, d = 0;
+    if (__get_cpuid(0x80000000u, &a, &b, &c, &d) == 0 || a < 0x80000007u) {
+        return false;
+    }
+    __get_cpuid(0x80000007u, &a, &b, &c, &d);
+    return (d & (1u << 8)) != 0;
+}
+
+// A (tsc, steady ns) pair read as close together as we can: the tightest
+// bracket of a few tries, tsc taken at its midpoint.
+void read_pair(uint64_t& tsc, uint64_t& ns) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 5; ++i) {
+        const uint64_t t0 = __rdtsc();
+        const uint64_t n = steady_ns();
+        const uint64_t t1 = __rdtsc();
+        if (t1 - t0 < best) {
+            best = t1 - t0;
+            tsc = t0 + (t1 - t0) / 2;
+            ns = n;
+        }
+    }
+}
+
+// Writes the idle conversion and makes it current. Caller holds the lock.
+void publish(State& s, uint64_t tsc, uint64_t ns) {
+    using clk::detail::conversions;
+    using clk::detail::version;
+    const uint64_t v = version.load(std::memory_order_relaxed);
+    const clk::detail::Conversion& cur = conversions[v & 1];
+    if (cur.resync_at.load(std::memory_order_relaxed) != 0) {
+        // never step back: the old conversion may already be ahead of steady_clock by its error
+        ns = std::max(ns, clk::detail::scale(cur, tsc));
+    }
+    const double ns_per_tick = double(ns - s.base_ns) / double(tsc - s.base_tsc);
+    s.hz = 1e9 / ns_per_tick;
+    clk::detail::Conversion& next = conversions[(v + 1) & 1];
+    next.tsc0.store(tsc, std::memory_order_relaxed);
+    next.ns0.store(ns, std::memory_order_relaxed);
+    next.mult.store(static_cast<uint64_t>(ns_per_tick * 4294967296.0), std::memory_order_relaxed);
+    next.resync_at.store(tsc + static_cast<uint64_t>(double(s.interval_ns) * s.hz / 1e9), std::memory_order_relaxed);
+    version.store(v + 1, std::memory_order_release);
+    s.interval_ns = std::min(s.interval_ns * 2, clk::kMaxResyncNs);
+    s.wall_offset.store(int64_t(system_ns()) - int64_t(steady_ns()), std::memory_order_relaxed);
+}
+
+// Initial rate over a short spin; resyncs refine it.
+void calibrate(State& s) {
+    read_pair(s.base_tsc, s.base_ns);
+    uint64_t tsc = 0, ns = 0;
+    do {
+        read_pair(tsc, ns);
+    } while (ns - s.base_ns < 2'000'000);
+    s.interval_ns = kFirstResyncNs;
+    publish(s, tsc, ns);
+}
+
+// Current conversion, read the way now_ns() does; false if a resync raced us.
+bool scale_now(uint64_t& out) {
+    using namespace clk::detail;
+    const uint64_t v = version.load(std::memory_order_acquire);
+    const Conversion& c = conversions[v & 1];
+    const uint64_t tsc = __rdtsc();
+    out = scale(c, tsc);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version.load(std::memory_order_relaxed) == v;
+}
+#endif
+
+clk::Source init_locked(State& s, clk::Source preferred) {
+    s.source = clk::Source::Steady;
+#ifdef MARKETFEED_HAVE_TSC
+    {
+        // an empty current conversion sends every now_ns() to the slow path
+        using namespace clk::detail;
+        const uint64_t v = version.load(std::memory_order_relaxed);
+        Conversion& next = conversions[(v + 1) & 1];
+        next.resync_at.store(0, std::memory_order_relaxed);
+        version.store(v + 1, std::memory_order_release);
+    }
+#endif
+    s.wall_offset.store(int64_t(system_ns()) - int64_t(steady_ns()), std::memory_order_relaxed);
+#ifdef MARKETFEED_HAVE_TSC
+    if (preferred == clk::Source::Tsc && invariant_tsc()) {
+        calibrate(s);
+        s.source = clk::Source::Tsc;
+    }
+#else
+    (void)preferred;
+#endif
+    s.initialized.store(true, std::memory_order_release);
+    return s.source;
+}
+
+clk::Source default_source() {
+    const char* env = std::getenv("MARKETFEED_CLOCK");
+    return env != nullptr && std::strcmp(env, "steady") == 0 ? clk::Source::Steady : clk::Source::Tsc;
+}
+
+} // namespace
+
+namespace clk {
+
+namespace detail {
+
+uint64_t slow_now_ns() noexcept {
+    State& s = state();
+    if (!s.initialized.load(std::memory_order_acquire)) [[unlikely]] {
+        std::lock_guard<std::mutex> lock(s.mu);
+        if (!s.initialized.load(std::memory_order_relaxed)) {
+            init_locked(s, default_source());
+        }
+    }
+#ifdef MARKETFEED_HAVE_TSC
+    if (conversions[version.load(std::memory_order_acquire) & 1].resync_at.load(std::memory_order_relaxed) != 0) {
+        {
+            // due for a resync (or raced one): whoever gets the lock does it, the others read on
+            std::unique_lock<std::mutex> lock(s.mu, std::try_to_lock);
+            if (lock.owns_lock() && s.source == Source::Tsc) {
+                const Conversion& c = conversions[version.load(std::memory_order_relaxed) & 1];
+                if (__rdtsc() >= c.resync_at.load(std::memory_order_relaxed)) {
+                    uint64_t tsc = 0, ns = 0;
+                    read_pair(tsc, ns);
+                    publish(s, tsc, ns);
+                }
+            }
+        }
+        uint64_t ns = 0;
+        while (!scale_now(ns)) {
+        }
+        return ns;
+    }
+#endif
+    return steady_ns();
+}
+
+} // namespace detail
+
+Source select(Source preferred) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mu);
+    return init_locked(s, preferred);
+}
+
+Source source() {
+    State& s = state();
+    if (!s.initialized.load(std::memory_order_acquire)) {
+        now_ns();
+    }
+    std::lock_guard<std::mutex> lock(s.mu);
+    return s.source;
+}
+
+uint64_t to_wall_ns(uint64_t steady_ns) noexcept {
+    return uint64_t(int64_t(steady_ns) + state().wall_offset.load(std::memory_order_relaxed));
+}
+
+double tsc_hz() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mu);
+    return s.source == Source::Tsc ? s.hz : 0.0;
+}
+
+} // namespace clk
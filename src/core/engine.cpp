@@ -1,10 +1,13 @@
 #include "engine.hpp"
+#include "metrics.hpp"
+#include "stage_latency.hpp"
+#include <algorithm>
 #include <vector>
 #include <cassert>
-#include <chrono>
+#include <cstring>
 #include <string>
 
-Engine::Engine() : next_exch_id_(1), next_instrument_id_(1) {
+Engine::Engine(std::unique_ptr<Arena> arena) : arena_(std::move(arena)), next_exch_id_(1), next_instrument_id_(1) {
     // dummy data for now
     add_new_instrument("AAPL");
     add_new_instrument("MSFT");
@@ -15,13 +18,50 @@ bool Engine::instrument_exists(uint32_t instrument_id) const {
     return order_books.contains(instrument_id);
 }
 
+Engine::Engine(std::span<const InstrumentSpec> universe, std::unique_ptr<Arena> arena)
+    : arena_(std::move(arena)), next_exch_id_(1), next_instrument_id_(1) {
+    order_books.reserve(universe.size());
+    instruments_.reserve(universe.size());
+    ids_by_symbol_.reserve(universe.size());
+    last_bbo_.reserve(universe.size());
+    bbo_dirty_.reserve(universe.size());
+    for (const InstrumentSpec& spec : universe) {
+        add_new_instrument(spec);
+    }
+}
+
 uint32_t Engine::add_new_instrument(const std::string& instrument_name) {
-    uint32_t new_id = next_instrument_id_++;
-    order_books[new_id] = OrderBook();
-    id_to_ticker[new_id] = instrument_name;
+    InstrumentSpec spec;
+    spec.symbol = instrument_name;
+    return add_new_instrument(spec);
+}
+
+uint32_t Engine::add_new_instrument(const InstrumentSpec& spec) {
+    const uint32_t new_id = next_instrument_id_;
+    if (!ids_by_symbol_.try_emplace(spec.symbol, new_id).second) {
+        return 0;
+    }
+    ++next_instrument_id_;
+    OrderBook& book = order_books.try_emplace(new_id, new_id, arena_.get()).first->second;
+    if (spec.expected_orders != 0) {
+        book.reserve(spec.expected_orders);
+    }
+    instruments_.push_back(spec);
     return new_id;
 }
 
+uint32_t Engine::instrument_id(const std::string& symbol) const {
+    const auto it = ids_by_symbol_.find(symbol);
+    return it == ids_by_symbol_.end() ? 0 : it->second;
+}
+
+const InstrumentSpec* Engine::instrument(uint32_t instrument_id) const {
+    if (instrument_id == 0 || instrument_id > instruments_.size()) {
+        return nullptr;
+    }
+    return &instruments_[instrument_id - 1];
+}
+
 bool Engine::best_bid(const uint32_t instrument_id, int64_t& price_out, int32_t& qty_out) const {
     if (!instrument_exists(instrument_id)) {
         return false;
@@ -36,9 +76,74 @@ bool Engine::best_ask(const uint32_t instrument_id, int64_t& price_out, int32_t&
     return order_books.at(instrument_id).best_ask(price_out, qty_out);
 }
 
-uint64_t Engine::now_ns() noexcept {
-    using namespace std::chrono;
-    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+bool Engine::bbo(uint32_t instrument_id, BboBody& out) const {
+    auto it = order_books.find(instrument_id);
+    if (it == order_books.end()) {
+        return false;
+    }
+    out = BboBody{};
+    out.instrument_id = instrument_id;
+    it->second.best_level(OrderSide::Bid, out.bid_price_ticks, out.bid_total_qty, out.bid_order_count);
+    it->second.best_level(OrderSide::Ask, out.ask_price_ticks, out.ask_total_qty, out.ask_order_count);
+    return true;
+}
+
+void Engine::flush_bbo(std::vector<BboBody>& out) {
+    for (uint32_t instrument_id : bbo_dirty_) {
+        order_books.at(instrument_id).clear_top_dirty();
+        BboBody cur;
+        bbo(instrument_id, cur);
+        // the top may have moved and come back within the batch
+        BboBody& last = last_bbo_[instrument_id];
+        if (std::memcmp(&last, &cur, sizeof(BboBody)) != 0) {
+            last = cur;
+            out.push_back(cur);
+            if (top_of_book_) {
+                top_of_book_->publish(cur);
+            }
+        }
+    }
+    bbo_dirty_.clear();
+}
+
+void Engine::set_top_of_book(TopOfBookCache* cache) {
+    top_of_book_ = cache;
+    if (cache == nullptr) {
+        return;
+    }
+    for (uint32_t id = 1; id < next_instrument_id_; ++id) {
+        BboBody cur;
+        bbo(id, cur);
+        cache->publish(cur);
+    }
+}
+
+bool Engine::snapshot(uint32_t instrument_id, uint64_t md_seqno, BookSnapshot& out) const {
+    out.md_seqno = md_seqno;
+    out.instrument_id = instrument_id;
+    out.levels.clear();
+    auto it = order_books.find(instrument_id);
+    out.found = it != order_books.end();
+    if (out.found) {
+        it->second.append_levels(out.levels, instrument_id);
+    }
+    return out.found;
+}
+
+BookMemory Engine::memory_usage() const {
+    BookMemory total;
+    for (const auto& [id, book] : order_books) {
+        total += book.memory();
+    }
+    return total;
+}
+
+size_t Engine::num_resting_orders() const {
+    size_t n = 0;
+    for (const auto& [id, book] : order_books) {
+        n += book.num_orders();
+    }
+    return n;
 }
 
 AckBody Engine::make_ack(uint64_t client_id, uint64_t exch_id, uint8_t status, uint64_t recv_ns, uint64_t ack_ns) {
@@ -48,56 +153,303 @@ AckBody Engine::make_ack(uint64_t client_id, uint64_t exch_id, uint8_t status, u
     a.status = status;
     a.ts_engine_recv_ns = recv_ns;
     a.ts_engine_ack_ns = ack_ns;
+    if (status != 0) {
+        metrics::count(Metric::Rejects);
+    }
     return a;
 }
 
-EngineResult Engine::on_new(const OrderNewBody& new_order, bool rest_leftover) {
-    const uint64_t recv_ns = now_ns();
+void Engine::push_level(std::vector<LevelUpdateBody>& out, const OrderBook& book, uint32_t instrument_id,
+                        OrderSide side, int64_t price_ticks, bool after_add) {
+    LevelUpdateBody u{};
+    u.price_ticks = price_ticks;
+    u.instrument_id = instrument_id;
+    u.side = static_cast<uint8_t>(side);
+    if (book.level_info(side, price_ticks, u.total_qty, u.order_count)) {
+        // a level holding only the order just added was created by it
+        const bool created = after_add && u.order_count == 1;
+        u.action = static_cast<uint8_t>(created ? LevelAction::ADD : LevelAction::UPDATE);
+    } else {
+        u.action = static_cast<uint8_t>(LevelAction::DELETE);
+    }
+    out.push_back(u);
+}
+
+bool Engine::valid_new(const OrderNewBody& new_order, uint64_t recv_ns) const {
     if (new_order.qty <= 0 || new_order.price_ticks < 0 || new_order.side > 1 || !instrument_exists(new_order.instrument_id)) {
+        return false;
+    }
+    const uint8_t tif = new_order.flags & (TIF_DAY | TIF_GTT);
+    return tif != (TIF_DAY | TIF_GTT) && !(tif == TIF_GTT && new_order.expire_after_s == 0) &&
+           !(tif == TIF_DAY && day_end_ns_ <= recv_ns);
+}
+
+EngineResult Engine::on_new(const OrderNewBody& new_order, bool rest_leftover, uint32_t session_id) {
+    const uint64_t recv_ns = now_ns();
+    if (!valid_new(new_order, recv_ns)) {
         AckBody ack = make_ack(new_order.client_order_id, 0, 1, recv_ns, now_ns());
         EngineResult ret{};
         ret.ack = ack;
         return ret;
     }
     OrderBook& order_book = order_books[new_order.instrument_id];
+    if (!rest_leftover && order_book.in_auction()) {
+        // nothing executes before the uncross, so an IOC could never fill
+        EngineResult ret{};
+        ret.ack = make_ack(new_order.client_order_id, 0, 1, recv_ns, now_ns());
+        return ret;
+    }
+    // what rests of a GTT / DAY order is timed; an IOC never rests
+    const uint8_t tif = new_order.flags & (TIF_DAY | TIF_GTT);
+    const uint64_t expire_ns = tif == TIF_GTT ? recv_ns + uint64_t(new_order.expire_after_s) * 1'000'000'000
+                               : tif == TIF_DAY ? day_end_ns_
+                                                : 0;
+    const OwnerList* const known = find_session_list(session_id);
+    if (known != nullptr && known->by_client_id.find(new_order.client_order_id) != nullptr) {
+        // the id of an order still resting: a cancel by it would be ambiguous
+        EngineResult ret{};
+        ret.ack = make_ack(new_order.client_order_id, 0, 1, recv_ns, now_ns());
+        return ret;
+    }
+    const uint64_t validated_ns = latency::stamp();
+    latency::record(LatencyStage::Validate, recv_ns, validated_ns);
+    const bool was_dirty = order_book.top_dirty();
     uint64_t new_exch_id = allocate_exch_id();
     OrderSide side = static_cast<OrderSide>(new_order.side);
 
     int32_t remaining = new_order.qty;
     std::vector<TradeBody> trades;
-    int32_t filled = order_book.match_taker(new_exch_id, side, new_order.price_ticks, remaining, trades, new_order.instrument_id, liq_flag(side));
+    int32_t filled = order_book.in_auction() ? 0 : order_book.match_taker(new_exch_id, side, new_order.price_ticks, remaining, trades, new_order.instrument_id, liq_flag(side));
+
+    EngineResult out{};
+    // trades come out in price priority, so each touched maker level is one run
+    const OrderSide resting_side = side == OrderSide::Bid ? OrderSide::Ask : OrderSide::Bid;
+    for (size_t i = 0; i < trades.size(); ++i) {
+        if (i + 1 == trades.size() || trades[i + 1].price_ticks != trades[i].price_ticks) {
+            push_level(out.levels, order_book, new_order.instrument_id, resting_side, trades[i].price_ticks, false);
+        }
+    }
 
     remaining -= filled;
     if (rest_leftover && remaining > 0) {
-        order_book.add_resting(new_exch_id, side, new_order.price_ticks, remaining);
+        OwnerList* const owner_list = session_list(session_id); // made when the session first rests an order
+        if (order_book.add_resting(new_exch_id, side, new_order.price_ticks, remaining, session_id, owner_list,
+                                   tif != 0 ? &timers_ : nullptr, expire_ns, new_order.client_order_id)) {
+            push_level(out.levels, order_book, new_order.instrument_id, side, new_order.price_ticks, true);
+        }
     }
 
-    EngineResult out{};
+    note_top_change(order_book, was_dirty, new_order.instrument_id);
+    metrics::count(Metric::OrdersAccepted);
+    if (filled > 0) {
+        metrics::count(Metric::Fills, trades.size());
+        metrics::count(Metric::FilledQty, uint64_t(filled));
+    }
     out.ack = make_ack(new_order.client_order_id, new_exch_id, 0, recv_ns, now_ns());
+    latency::record(match_stage(trades.size()), validated_ns, out.ack.ts_engine_ack_ns);
     out.trades = std::move(trades);
 
     return out;
 }
 
-EngineResult Engine::on_cancel(const OrderCancelBody& cancel_order) {
+EngineResult Engine::on_cancel(const OrderCancelBody& cancel_order, uint32_t session_id) {
     const uint64_t recv_ns = now_ns();
-    if (!instrument_exists(cancel_order.instrument_id)) {
+    uint64_t exch_order_id = cancel_order.exch_order_id;
+    uint32_t instrument_id = cancel_order.instrument_id;
+    const OwnerList* const list = exch_order_id == 0 ? find_session_list(session_id) : nullptr;
+    if (list != nullptr) {
+        // by client order id: the session's index names the order and its book
+        if (OwnerLink* const* link = list->by_client_id.find(cancel_order.client_order_id)) {
+            const OrderBook::OwnedOrder o = OrderBook::owned_order(*link);
+            if (instrument_id == 0 || instrument_id == o.instrument_id) {
+                exch_order_id = o.exch_order_id;
+                instrument_id = o.instrument_id;
+            }
+        }
+    }
+    if (!instrument_exists(instrument_id)) {
         AckBody ack = make_ack(cancel_order.client_order_id, 0, 1, recv_ns, now_ns());
         EngineResult ret{};
         ret.ack = ack;
         return ret;
     }
 
-    OrderBook& order_book = order_books[cancel_order.instrument_id];
-    bool ok = order_book.cancel_order(cancel_order.exch_order_id);
+    const uint64_t validated_ns = latency::stamp();
+    latency::record(LatencyStage::Validate, recv_ns, validated_ns);
+    OrderBook& order_book = order_books[instrument_id];
+    const bool was_dirty = order_book.top_dirty();
+    OrderSide side;
+    int64_t price_ticks;
+    bool ok = order_book.cancel_order(exch_order_id, side, price_ticks);
+    note_top_change(order_book, was_dirty, instrument_id);
 
     AckBody ack = make_ack(
         cancel_order.client_order_id,
-        cancel_order.exch_order_id,
+        exch_order_id,
         ok ? 0 : 1,
         recv_ns,
         now_ns()
     );
+    latency::record(LatencyStage::Cancel, validated_ns, ack.ts_engine_ack_ns);
+
+    EngineResult out{ack, {}, {}};
+    if (ok) {
+        metrics::count(Metric::OrdersCancelled);
+        push_level(out.levels, order_book, instrument_id, side, price_ticks, false);
+    }
+    return out;
+}
+
+EngineResult Engine::on_mass_cancel(const MassCancelBody& mass_cancel, uint32_t session_id) {
+    const uint64_t recv_ns = now_ns();
+    EngineResult out{};
+    const bool all = mass_cancel.instrument_id == kAllInstruments;
+    if (mass_cancel.side > kBothSides || (!all && !instrument_exists(mass_cancel.instrument_id))) {
+        out.ack = make_ack(mass_cancel.client_order_id, 0, 1, recv_ns, now_ns());
+        return out;
+    }
+    const uint64_t validated_ns = latency::stamp();
+    latency::record(LatencyStage::Validate, recv_ns, validated_ns);
+    size_t cancelled = 0;
+    if (session_id != kAnyOwner) {
+        // the session's own list: O(its orders), however deep the books are
+        cancelled = cancel_owned(session_id, mass_cancel.instrument_id, mass_cancel.side, out.levels);
+    } else {
+        // instrument by instrument in id order, so the feed is the same on every run
+        const uint32_t first = all ? 1 : mass_cancel.instrument_id;
+        const uint32_t last = all ? next_instrument_id_ - 1 : mass_cancel.instrument_id;
+        for (uint32_t id = first; id <= last; ++id) {
+            OrderBook& order_book = order_books.find(id)->second;
+            const bool was_dirty = order_book.top_dirty();
+            cancelled += order_book.mass_cancel(mass_cancel.side, kAnyOwner, out.levels, id);
+            note_top_change(order_book, was_dirty, id);
+        }
+    }
+    metrics::count(Metric::OrdersCancelled, cancelled);
+    out.ack = make_ack(mass_cancel.client_order_id, 0, 0, recv_ns, now_ns());
+    latency::record(LatencyStage::Cancel, validated_ns, out.ack.ts_engine_ack_ns);
+    out.ack.cancelled_count = static_cast<uint32_t>(std::min<size_t>(cancelled, UINT32_MAX));
+    return out;
+}
+
+EngineResult Engine::cancel_session(uint32_t session_id) {
+    const uint64_t recv_ns = now_ns();
+    EngineResult out{};
+    const size_t cancelled = cancel_owned(session_id, kAllInstruments, kBothSides, out.levels);
+    session_orders_.erase(session_id); // its list is empty now; free it with its index
+    metrics::count(Metric::OrdersCancelled, cancelled);
+    out.ack = make_ack(0, 0, 0, recv_ns, now_ns());
+    out.ack.cancelled_count = static_cast<uint32_t>(std::min<size_t>(cancelled, UINT32_MAX));
+    return out;
+}
 
-    return EngineResult{ack, {}};
-}
\ No newline at end of file
+size_t Engine::cancel_owned(uint32_t session_id, uint32_t instrument_id, uint8_t side,
+                            std::vector<LevelUpdateBody>& levels) {
+    OwnerList* const list = find_session_list(session_id);
+    if (list == nullptr) {
+        return 0;
+    }
+    std::vector<TouchedLevel> touched;
+    OrderBook* book = nullptr;
+    for (OwnerLink* l = list->next; l != list;) {
+        const OrderBook::OwnedOrder o = OrderBook::owned_order(l);
+        l = l->next; // cancelling unlinks the current one
+        if ((instrument_id != kAllInstruments && o.instrument_id != instrument_id) ||
+            (side != kBothSides && static_cast<uint8_t>(o.side) != side)) {
+            continue;
+        }
+        cancel_linked(o, book, touched);
+    }
+    push_touched(touched, levels);
+    return touched.size();
+}
+
+void Engine::cancel_linked(const OrderBook::OwnedOrder& o, OrderBook*& book, std::vector<TouchedLevel>& touched) {
+    if (book == nullptr || book->instrument_id() != o.instrument_id) {
+        book = &order_books.find(o.instrument_id)->second;
+    }
+    const bool was_dirty = book->top_dirty();
+    TouchedLevel t{o.instrument_id, o.side, 0};
+    book->cancel_order(o.exch_order_id, t.side, t.price_ticks);
+    note_top_change(*book, was_dirty, o.instrument_id);
+    touched.push_back(t);
+}
+
+void Engine::push_touched(std::vector<TouchedLevel>& touched, std::vector<LevelUpdateBody>& levels) const {
+    std::sort(touched.begin(), touched.end());
+    for (size_t i = 0; i < touched.size(); ++i) {
+        const TouchedLevel& t = touched[i];
+        if (i == 0 || t != touched[i - 1]) {
+            push_level(levels, order_books.find(t.instrument_id)->second, t.instrument_id, t.side, t.price_ticks, false);
+        }
+    }
+}
+
+EngineResult Engine::expire(uint64_t now_ns) {
+    const uint64_t recv_ns = Engine::now_ns();
+    EngineResult out{};
+    std::vector<TouchedLevel> touched;
+    OrderBook* book = nullptr;
+    timers_.advance(now_ns, [&](TimerLink* t) { cancel_linked(OrderBook::timed_order(t), book, touched); });
+    push_touched(touched, out.levels);
+    metrics::count(Metric::OrdersExpired, touched.size());
+    out.ack = make_ack(0, 0, 0, recv_ns, Engine::now_ns());
+    out.ack.cancelled_count = static_cast<uint32_t>(std::min<size_t>(touched.size(), UINT32_MAX));
+    return out;
+}
+
+size_t Engine::num_session_orders(uint32_t session_id) const {
+    const OwnerList* const list = find_session_list(session_id);
+    if (list == nullptr) {
+        return 0;
+    }
+    size_t n = 0;
+    for (const OwnerLink* l = list->next; l != list; l = l->next) {
+        ++n;
+    }
+    return n;
+}
+
+void Engine::reserve_client_ids(uint32_t session_id, size_t n) {
+    if (OwnerList* list = session_list(session_id)) {
+        list->by_client_id.reserve(n);
+    }
+}
+
+bool Engine::start_auction(uint32_t instrument_id) {
+    auto it = order_books.find(instrument_id);
+    if (it == order_books.end()) {
+        return false;
+    }
+    it->second.set_auction(true);
+    return true;
+}
+
+bool Engine::indicative_auction(uint32_t instrument_id, AuctionPrice& out) const {
+    auto it = order_books.find(instrument_id);
+    if (it == order_books.end() || !it->second.in_auction()) {
+        return false;
+    }
+    out = it->second.auction_price();
+    return true;
+}
+
+EngineResult Engine::uncross(uint32_t instrument_id) {
+    const uint64_t recv_ns = now_ns();
+    EngineResult out{};
+    auto it = order_books.find(instrument_id);
+    if (it == order_books.end() || !it->second.in_auction()) {
+        out.ack = make_ack(0, 0, 1, recv_ns, now_ns());
+        return out;
+    }
+    OrderBook& order_book = it->second;
+    const bool was_dirty = order_book.top_dirty();
+    const AuctionPrice p = order_book.auction_price();
+    const int64_t volume = order_book.uncross(p, out.trades, out.levels, instrument_id);
+    metrics::count(Metric::Fills, out.trades.size());
+    metrics::count(Metric::FilledQty, uint64_t(volume));
+    order_book.set_auction(false);
+    note_top_change(order_book, was_dirty, instrument_id);
+    out.ack = make_ack(0, 0, 0, recv_ns, now_ns());
+    return out;
+}
@@ -0,0 +1,149 @@
+#include "flow_gen.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <string>
+
+FlowGenerator::FlowGenerator(FlowGenConfig cfg)
+    : cfg_(cfg),
+      rng_(cfg.seed),
+      candidates_(cfg.num_instruments + 1),
+      mid_(cfg.num_instruments + 1, double(cfg.mid_px)),
+      mid_ts_(cfg.num_instruments + 1, 0) {
+    // the shadow lists instruments 1..N like the engine replaying the flow
+    while (shadow_.num_instruments() < cfg_.num_instruments) {
+        shadow_.add_new_instrument("SYM" + std::to_string(shadow_.num_instruments() + 1));
+    }
+}
+
+double FlowGenerator::uniform() {
+    return double(rng_() >> 11) * 0x1.0p-53;
+}
+
+double FlowGenerator::exponential(double mean) {
+    return -mean * std::log1p(-uniform());
+}
+
+// Box-Muller, keeping the second variate for the next call
+double FlowGenerator::normal() {
+    if (has_spare_) {
+        has_spare_ = false;
+        return spare_normal_;
+    }
+    double u1 = uniform();
+    while (u1 == 0.0) {
+        u1 = uniform();
+    }
+    const double r = std::sqrt(-2.0 * std::log(u1));
+    const double theta = 2.0 * std::numbers::pi * uniform();
+    spare_normal_ = r * std::sin(theta);
+    has_spare_ = true;
+    return r * std::cos(theta);
+}
+
+// Exact OU step over the time since this instrument's mid last moved.
+double FlowGenerator::advance_mid(uint32_t instrument_id) {
+    double& mid = mid_[instrument_id];
+    const double dt = double(now_ns_ - mid_ts_[instrument_id]) * 1e-9;
+    mid_ts_[instrument_id] = now_ns_;
+    if (dt > 0.0) {
+        const double k = cfg_.mid_reversion;
+        const double decay = std::exp(-k * dt);
+        const double stdev = k > 0.0 ? cfg_.mid_vol * std::sqrt((1.0 - decay * decay) / (2.0 * k))
+                                     : cfg_.mid_vol * std::sqrt(dt);
+        mid = double(cfg_.mid_px) + (mid - double(cfg_.mid_px)) * decay + stdev * normal();
+    }
+    // keep a few ticks of room below passive bids
+    mid = std::max(mid, double(cfg_.sweep_ticks + 4.0 * cfg_.depth_mean + 2.0));
+    return mid;
+}
+
+bool FlowGenerator::pick_cancel(uint32_t instrument_id, double mid, OrderCancelBody& out) {
+    std::vector<uint64_t>& ids = candidates_[instrument_id];
+    // candidates are dropped lazily once they turn out to be filled
+    for (int tries = 0; tries < 4 && !ids.empty(); ++tries) {
+        const size_t i = size_t(uniform() * double(ids.size()));
+        auto it = live_.find(ids[i]);
+        if (it == live_.end()) {
+            ids[i] = ids.back();
+            ids.pop_back();
+            continue;
+        }
+        const double dist = std::fabs(double(it->second.price_ticks) - mid);
+        if (uniform() >= std::min(1.0, (1.0 + dist) / cfg_.cancel_depth_ticks)) {
+            return false; // near the top: more likely to stay
+        }
+        std::memset(&out, 0, sizeof(out));
+        out.exch_order_id = it->first;
+        out.client_order_id = next_cid_++;
+        out.instrument_id = instrument_id;
+        live_.erase(it);
+        ids[i] = ids.back();
+        ids.pop_back();
+        return true;
+    }
+    return false;
+}
+
+// Runs the order through the shadow engine and tracks what rests.
+void FlowGenerator::apply_new(const OrderNewBody& o) {
+    const bool ioc = (o.flags & TIF_IOC) != 0;
+    EngineResult res = shadow_.on_new(o, !ioc);
+    int32_t filled = 0;
+    for (const TradeBody& t : res.trades) {
+        filled += t.qty;
+        auto it = live_.find(t.resting_exch_order_id);
+        if (it != live_.end() && (it->second.qty -= t.qty) <= 0) {
+            live_.erase(it);
+        }
+    }
+    if (res.ack.status == 0 && !ioc && filled < o.qty) {
+        live_.emplace(res.ack.exch_order_id, Live{o.instrument_id, o.price_ticks, o.qty - filled});
+        candidates_[o.instrument_id].push_back(res.ack.exch_order_id);
+    }
+}
+
+FlowEvent FlowGenerator::next() {
+    FlowEvent ev{};
+    now_ns_ += uint64_t(exponential(1e9 / cfg_.rate));
+    ev.ts_ns = now_ns_;
+
+    const uint32_t instrument_id = 1 + uint32_t(uniform() * double(cfg_.num_instruments));
+    const double mid = advance_mid(instrument_id);
+
+    if (uniform() < cfg_.cancel_share && pick_cancel(instrument_id, mid, ev.cancel)) {
+        ev.type = MsgType::CANCEL;
+        shadow_.on_cancel(ev.cancel);
+        ++cancels_;
+        return ev;
+    }
+
+    OrderNewBody& o = ev.new_order;
+    std::memset(&o, 0, sizeof(o));
+    o.client_order_id = next_cid_++;
+    o.instrument_id = instrument_id;
+    const bool bid = uniform() < 0.5;
+    o.side = static_cast<uint8_t>(bid ? OrderSide::Bid : OrderSide::Ask);
+    const int64_t sign = bid ? -1 : 1;
+
+    if (uniform() < cfg_.sweep_prob) {
+        BboBody top{};
+        shadow_.bbo(instrument_id, top);
+        const int64_t opp_px = bid ? top.ask_price_ticks : top.bid_price_ticks;
+        const int64_t opp_qty = bid ? top.ask_total_qty : top.bid_total_qty;
+        const int64_t base = opp_qty > 0 ? opp_px : int64_t(std::llround(mid));
+        o.price_ticks = base - sign * cfg_.sweep_ticks;
+        o.qty = int32_t(std::clamp<int64_t>(3 * opp_qty, int64_t(cfg_.qty_mean), INT32_MAX / 2));
+        o.flags = TIF_IOC;
+        ++sweeps_;
+    } else {
+        const int64_t offset = 1 + int64_t(exponential(cfg_.depth_mean - 1.0));
+        o.price_ticks = int64_t(std::llround(mid)) + sign * offset;
+        o.qty = 1 + int32_t(std::min(exponential(cfg_.qty_mean - 1.0), double(INT32_MAX / 2)));
+    }
+    ev.type = MsgType::NEW;
+    apply_new(o);
+    ++news_;
+    return ev;
+}
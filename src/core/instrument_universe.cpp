@@ -0,0 +1,56 @@
+#include "instrument_universe.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+bool parse_universe(std::istream& in, const std::string& source, std::vector<InstrumentSpec>& out) {
+    std::unordered_set<std::string> seen;
+    for (const InstrumentSpec& s : out) {
+        seen.insert(s.symbol);
+    }
+    std::string line;
+    for (size_t line_no = 1; std::getline(in, line); ++line_no) {
+        if (const size_t hash = line.find('#'); hash != std::string::npos) {
+            line.resize(hash);
+        }
+        std::istringstream fields(line);
+        InstrumentSpec spec;
+        if (!(fields >> spec.symbol)) {
+            continue; // blank or comment
+        }
+        std::string rest;
+        int64_t expected_orders = 0; // signed, so "-1" is refused rather than wrapped
+        if (!(fields >> expected_orders >> spec.band_lo_ticks >> spec.band_hi_ticks >> spec.tick_size) ||
+            (fields >> rest)) {
+            std::cerr << source << ":" << line_no
+                      << ": expected 'symbol expected_orders band_lo_ticks band_hi_ticks tick_size'\n";
+            return false;
+        }
+        if (expected_orders < 0 || expected_orders > int64_t(kMaxExpectedOrders)) {
+            std::cerr << source << ":" << line_no << ": bad expected_orders for " << spec.symbol << " (0.."
+                      << kMaxExpectedOrders << ")\n";
+            return false;
+        }
+        spec.expected_orders = uint32_t(expected_orders);
+        if (spec.band_lo_ticks < 0 || spec.band_hi_ticks < spec.band_lo_ticks || !(spec.tick_size > 0.0)) {
+            std::cerr << source << ":" << line_no << ": bad price band or tick size for " << spec.symbol << "\n";
+            return false;
+        }
+        if (!seen.insert(spec.symbol).second) {
+            std::cerr << source << ":" << line_no << ": duplicate symbol " << spec.symbol << "\n";
+            return false;
+        }
+        out.push_back(std::move(spec));
+    }
+    return true;
+}
+
+bool load_universe(const std::string& path, std::vector<InstrumentSpec>& out) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "universe: cannot open " << path << "\n";
+        return false;
+    }
+    return parse_universe(in, path, out);
+}
@@ -0,0 +1,450 @@
+#include "md_publisher.hpp"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+
+constexpr int kDrainBatch = 256;        // frames drained per loop iteration
+constexpr int kIdleSpins = 64;          // empty polls before the thread naps
+constexpr auto kIdleNap = std::chrono::microseconds(50);
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL; // a vanished client must not SIGPIPE the process
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+bool set_nonblocking(int fd) {
+    int fl = ::fcntl(fd, F_GETFL, 0);
+    return fl >= 0 && ::fcntl(fd, F_SETFL, fl | O_NONBLOCK) == 0;
+}
+
+} // namespace
+
+bool parse_udp_endpoint(const std::string& text, sockaddr_in& out) {
+    auto colon = text.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == text.size()) {
+        return false;
+    }
+    std::string host = text.substr(0, colon);
+    char* end = nullptr;
+    unsigned long port = std::strtoul(text.c_str() + colon + 1, &end, 10);
+    if (*end != '\0' || port == 0 || port > 65535) {
+        return false;
+    }
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(static_cast<uint16_t>(port));
+    if (::inet_pton(AF_INET, host.c_str(), &a.sin_addr) != 1) {
+        return false;
+    }
+    out = a;
+    return true;
+}
+
+MdPublisher::MdPublisher(MdPublisherConfig cfg)
+    : cfg_(std::move(cfg)), queue_(cfg_.queue_capacity) {
+    size_t cap = 2;
+    while (cap < cfg_.retrans_capacity) {
+        cap <<= 1;
+    }
+    history_.resize(cap);
+    history_mask_ = cap - 1;
+}
+
+MdPublisher::~MdPublisher() {
+    stop();
+}
+
+bool MdPublisher::start() {
+    if (running_.load()) {
+        return true;
+    }
+
+    udp_fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (udp_fd_ < 0) {
+        std::perror("md: udp socket");
+        return false;
+    }
+    for (const sockaddr_in& dst : cfg_.udp_destinations) {
+        if (!IN_MULTICAST(ntohl(dst.sin_addr.s_addr))) {
+            continue;
+        }
+        // loopback multicast: deliver to local subscribers, never leave the host
+        unsigned char loop = 1;
+        unsigned char ttl = 0;
+        in_addr iface{};
+        iface.s_addr = htonl(INADDR_LOOPBACK);
+        if (::setsockopt(udp_fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0 ||
+            ::setsockopt(udp_fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0 ||
+            ::setsockopt(udp_fd_, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) < 0) {
+            std::perror("md: multicast setsockopt");
+            close_sockets();
+            return false;
+        }
+        break;
+    }
+
+    if (!cfg_.retrans_unix_path.empty()) {
+        unix_listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, cfg_.retrans_unix_path.c_str(), sizeof(addr.sun_path) - 1);
+        ::unlink(cfg_.retrans_unix_path.c_str());
+        if (unix_listen_fd_ < 0 ||
+            ::bind(unix_listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            ::listen(unix_listen_fd_, 8) < 0 || !set_nonblocking(unix_listen_fd_)) {
+            std::perror("md: retransmit unix socket");
+            close_sockets();
+            return false;
+        }
+    }
+
+    if (cfg_.retrans_tcp_port >= 0) {
+        tcp_listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(cfg_.retrans_tcp_port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (tcp_listen_fd_ < 0 ||
+            ::setsockopt(tcp_listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 ||
+            ::bind(tcp_listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            ::listen(tcp_listen_fd_, 8) < 0 || !set_nonblocking(tcp_listen_fd_) ||
+            ::getsockname(tcp_listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+            std::perror("md: retransmit tcp socket");
+            close_sockets();
+            return false;
+        }
+        bound_tcp_port_ = ntohs(addr.sin_port);
+    }
+
+    stop_requested_.store(false);
+    running_.store(true);
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void MdPublisher::stop() {
+    if (!running_.load()) {
+        return;
+    }
+    stop_requested_.store(true, std::memory_order_release);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_.store(false);
+    SnapshotReply reply;
+    while (snap_replies_.try_pop(reply)) {
+        delete reply.snap;
+    }
+    close_sockets();
+}
+
+void MdPublisher::close_sockets() {
+    for (RetransClient& c : clients_) {
+        ::close(c.fd);
+    }
+    clients_.clear();
+    if (udp_fd_ >= 0) {
+        ::close(udp_fd_);
+        udp_fd_ = -1;
+    }
+    if (unix_listen_fd_ >= 0) {
+        ::close(unix_listen_fd_);
+        ::unlink(cfg_.retrans_unix_path.c_str());
+        unix_listen_fd_ = -1;
+    }
+    if (tcp_listen_fd_ >= 0) {
+        ::close(tcp_listen_fd_);
+        tcp_listen_fd_ = -1;
+    }
+}
+
+void MdPublisher::run() {
+    MdSlot slot;
+    int idle = 0;
+    for (;;) {
+        int drained = 0;
+        while (drained < kDrainBatch && queue_.try_pop(slot)) {
+            append_frame(slot);
+            ++drained;
+        }
+        flush_datagram();
+        drain_snapshots();
+
+        if (drained > 0) {
+            idle = 0;
+            service_retrans(0);
+            continue;
+        }
+        if (stop_requested_.load(std::memory_order_acquire) && queue_.empty()) {
+            break;
+        }
+        service_retrans(0);
+        if (++idle > kIdleSpins) {
+            std::this_thread::sleep_for(kIdleNap);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void MdPublisher::append_frame(const MdSlot& slot) {
+    history_[slot.seqno & history_mask_] = slot;
+    history_last_ = slot.seqno;
+    frames_published_.fetch_add(1, std::memory_order_relaxed);
+
+    if (dgram_len_ + slot.len > kMdMaxDatagram) {
+        flush_datagram();
+    }
+    std::memcpy(dgram_ + dgram_len_, slot.bytes, slot.len);
+    dgram_len_ += slot.len;
+}
+
+void MdPublisher::flush_datagram() {
+    if (dgram_len_ == 0) {
+        return;
+    }
+    for (const sockaddr_in& dst : cfg_.udp_destinations) {
+        ssize_t n = ::sendto(udp_fd_, dgram_, dgram_len_, MSG_DONTWAIT,
+                             reinterpret_cast<const sockaddr*>(&dst), sizeof(dst));
+        if (n < 0) {
+            // best effort: a lost datagram is recovered through the retransmit server
+            send_errors_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            datagrams_sent_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    dgram_len_ = 0;
+}
+
+void MdPublisher::accept_clients(int listen_fd) {
+    for (;;) {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            return; // EAGAIN or transient error
+        }
+        if (!set_nonblocking(fd)) {
+            ::close(fd);
+            continue;
+        }
+        clients_.push_back(RetransClient{fd, next_client_id_++, false, {}, {}});
+    }
+}
+
+void MdPublisher::service_retrans(int timeout_ms) {
+    if (unix_listen_fd_ < 0 && tcp_listen_fd_ < 0) {
+        return;
+    }
+
+    std::vector<pollfd> pfds;
+    pfds.reserve(2 + clients_.size());
+    for (int lfd : {unix_listen_fd_, tcp_listen_fd_}) {
+        if (lfd >= 0) {
+            pfds.push_back(pollfd{lfd, POLLIN, 0});
+        }
+    }
+    const size_t first_client = pfds.size();
+    for (const RetransClient& c : clients_) {
+        short ev = POLLIN;
+        if (!c.out.empty()) {
+            ev |= POLLOUT;
+        }
+        pfds.push_back(pollfd{c.fd, ev, 0});
+    }
+
+    if (::poll(pfds.data(), pfds.size(), timeout_ms) <= 0) {
+        return;
+    }
+
+    std::vector<RetransClient> keep;
+    keep.reserve(clients_.size());
+    for (size_t i = 0; i < clients_.size(); ++i) {
+        RetransClient& c = clients_[i];
+        const short rev = pfds[first_client + i].revents;
+        bool ok = true;
+        if (rev & (POLLIN | POLLHUP | POLLERR)) {
+            ok = read_client(c);
+        }
+        // flushing may free the client to take its next queued request
+        for (int pass = 0; ok && pass < 2; ++pass) {
+            ok = process_requests(c) && flush_client(c);
+        }
+        if (ok) {
+            keep.push_back(std::move(c));
+        } else {
+            ::close(c.fd);
+        }
+    }
+    clients_ = std::move(keep);
+
+    for (size_t i = 0; i < first_client; ++i) {
+        if (pfds[i].revents & POLLIN) {
+            accept_clients(pfds[i].fd);
+        }
+    }
+}
+
+bool MdPublisher::read_client(RetransClient& c) {
+    uint8_t buf[512];
+    for (;;) {
+        ssize_t n = ::read(c.fd, buf, sizeof(buf));
+        if (n == 0) {
+            return false; // peer closed
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
+        }
+        c.in.insert(c.in.end(), buf, buf + n);
+    }
+    return true;
+}
+
+bool MdPublisher::process_requests(RetransClient& c) {
+    // Only take a new request once the previous response is out, so a client
+    // can never make us buffer more than one batch.
+    while (c.out.empty() && !c.awaiting_snapshot && c.in.size() >= sizeof(Header)) {
+        Header h = codec::decode<Header>(c.in.data(), c.in.size());
+        if (h.size < sizeof(Header) || h.size > kMaxFrame) {
+            return false;
+        }
+        if (c.in.size() < h.size) {
+            break;
+        }
+        try {
+            auto fv = codec::unpack_frame(std::span<const uint8_t>(c.in.data(), h.size));
+            if (fv.hdr.type == static_cast<uint8_t>(MsgType::RETRANS_REQUEST)) {
+                serve_range(c, codec::decode_body<RetransRequestBody>(fv.body));
+            } else if (fv.hdr.type == static_cast<uint8_t>(MsgType::SNAPSHOT_REQUEST)) {
+                auto req = codec::decode_body<SnapshotRequestBody>(fv.body);
+                if (snap_requests_.try_push(SnapshotRequest{req.instrument_id, c.id})) {
+                    c.awaiting_snapshot = true;
+                } else {
+                    SnapshotBody busy{};
+                    busy.instrument_id = req.instrument_id;
+                    busy.status = 2;
+                    Header bh = codec::make_header(MsgType::SNAPSHOT, sizeof(SnapshotBody), 0, 0);
+                    auto bytes = codec::pack(bh, busy);
+                    c.out.insert(c.out.end(), bytes.begin(), bytes.end());
+                }
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+        c.in.erase(c.in.begin(), c.in.begin() + h.size);
+    }
+    return true;
+}
+
+void MdPublisher::serve_range(RetransClient& c, const RetransRequestBody& req) {
+    // Valid window is (history_last_ - capacity, history_last_]
+    const uint64_t cap = history_mask_ + 1;
+    const uint64_t oldest = history_last_ >= cap ? history_last_ - cap + 1 : 1;
+
+    uint64_t begin = std::max<uint64_t>(req.begin_seqno, oldest);
+    uint64_t end = req.begin_seqno + req.count; // exclusive
+    end = std::min<uint64_t>(end, history_last_ + 1);
+    end = std::min<uint64_t>(end, begin + kMdMaxRetransBatch);
+
+    RetransResponseBody resp{};
+    resp.begin_seqno = begin;
+    resp.count = end > begin ? static_cast<uint32_t>(end - begin) : 0;
+    resp.status = (begin == req.begin_seqno && resp.count == req.count) ? 0 : 1;
+
+    Header h = codec::make_header(MsgType::RETRANS_RESPONSE, sizeof(RetransResponseBody), 0, 0);
+    auto bytes = codec::pack(h, resp);
+    c.out.insert(c.out.end(), bytes.begin(), bytes.end());
+
+    for (uint64_t s = begin; s < end; ++s) {
+        const MdSlot& slot = history_[s & history_mask_];
+        c.out.insert(c.out.end(), slot.bytes, slot.bytes + slot.len);
+    }
+    retrans_served_.fetch_add(resp.count, std::memory_order_relaxed);
+}
+
+void MdPublisher::deliver_snapshot(const SnapshotRequest& req, std::unique_ptr<BookSnapshot> snap) {
+    SnapshotReply reply{req.client_id, snap.release()};
+    while (!snap_replies_.try_push(reply)) {
+        std::this_thread::yield();
+    }
+}
+
+void MdPublisher::drain_snapshots() {
+    SnapshotReply reply;
+    while (snap_replies_.try_pop(reply)) {
+        std::unique_ptr<BookSnapshot> snap(reply.snap);
+        for (RetransClient& c : clients_) {
+            if (c.id == reply.client_id) {
+                encode_snapshot(c, *snap);
+                c.awaiting_snapshot = false;
+                snapshots_served_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+        // client gone: nothing to do, the snapshot is simply dropped
+    }
+}
+
+void MdPublisher::encode_snapshot(RetransClient& c, const BookSnapshot& snap) {
+    SnapshotBody body{};
+    body.md_seqno = snap.md_seqno;
+    body.instrument_id = snap.instrument_id;
+    body.num_levels = static_cast<uint32_t>(snap.levels.size());
+    body.status = snap.found ? 0 : 1;
+
+    constexpr size_t kLevelFrame = sizeof(Header) + sizeof(LevelUpdateBody);
+    const size_t start = c.out.size();
+    c.out.resize(start + sizeof(Header) + sizeof(SnapshotBody) + snap.levels.size() * kLevelFrame);
+    uint8_t* p = c.out.data() + start;
+
+    Header h = codec::make_header(MsgType::SNAPSHOT, sizeof(SnapshotBody), 0, 0);
+    std::memcpy(p, &h, sizeof(Header));
+    std::memcpy(p + sizeof(Header), &body, sizeof(SnapshotBody));
+    p += sizeof(Header) + sizeof(SnapshotBody);
+
+    const Header lh = codec::make_header(MsgType::BOOK_UPDATE, sizeof(LevelUpdateBody), 0, 0);
+    for (const LevelUpdateBody& u : snap.levels) {
+        std::memcpy(p, &lh, sizeof(Header));
+        std::memcpy(p + sizeof(Header), &u, sizeof(LevelUpdateBody));
+        p += kLevelFrame;
+    }
+}
+
+bool MdPublisher::flush_client(RetransClient& c) {
+    size_t off = 0;
+    while (off < c.out.size()) {
+        ssize_t n = ::send(c.fd, c.out.data() + off, c.out.size() - off, kSendFlags);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
+        }
+        off += size_t(n);
+    }
+    c.out.erase(c.out.begin(), c.out.begin() + off);
+    return true;
+}
@@ -0,0 +1,122 @@
+#include "metrics.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+constexpr const char* kNames[kNumMetrics] = {
+    "msgs_new",
+    "msgs_cancel",
+    "msgs_mass_cancel",
+    "msgs_stats_request",
+    "msgs_other",
+    "bytes_in",
+    "bytes_out",
+    "sessions_opened",
+    "sessions_closed",
+    "orders_accepted",
+    "rejects",
+    "fills",
+    "filled_qty",
+    "orders_cancelled",
+    "levels_created",
+    "levels_deleted",
+    "orders_expired",
+};
+
+struct Registry {
+    std::mutex mu;
+    std::vector<std::unique_ptr<MetricsShard>> shards;
+    std::vector<MetricsShard*> free; // released by threads that exited
+};
+
+// Never destroyed: threads may still count during static destruction.
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+// Hands the thread's shard back when it exits. Kept apart from t_shard so
+// that one stays a trivial thread_local (no TLS init check on the hot path).
+struct ShardLease {
+    MetricsShard* shard = nullptr;
+    ~ShardLease() {
+        if (shard != nullptr) {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mu);
+            r.free.push_back(shard);
+            metrics::t_shard = nullptr;
+        }
+    }
+};
+
+thread_local ShardLease t_lease;
+
+} // namespace
+
+const char* metric_name(Metric m) {
+    const size_t i = static_cast<size_t>(m);
+    return i < kNumMetrics ? kNames[i] : "unknown";
+}
+
+namespace metrics {
+
+MetricsShard* register_thread() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    if (!r.free.empty()) {
+        t_shard = r.free.back();
+        r.free.pop_back();
+    } else {
+        r.shards.push_back(std::make_unique<MetricsShard>());
+        t_shard = r.shards.back().get();
+    }
+    t_lease.shard = t_shard;
+    return t_shard;
+}
+
+MetricValues read() {
+    MetricValues total{};
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    for (const auto& s : r.shards) {
+        for (size_t i = 0; i < kNumMetrics; ++i) {
+            total[i] += s->values[i].load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+size_t num_shards() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    return r.shards.size();
+}
+
+std::string format(const MetricValues& v) {
+    std::string out;
+    for (size_t i = 0; i < kNumMetrics; ++i) {
+        if (i) {
+            out += ' ';
+        }
+        out += kNames[i];
+        out += '=';
+        out += std::to_string(v[i]);
+    }
+    return out;
+}
+
+StatsBody stats_body(uint64_t request_id, uint64_t ts_ns) {
+    const MetricValues v = read();
+    StatsBody b{};
+    b.request_id = request_id;
+    b.ts_ns = ts_ns;
+    b.num_values = static_cast<uint32_t>(kNumMetrics);
+    for (size_t i = 0; i < kNumMetrics; ++i) {
+        b.values[i] = v[i];
+    }
+    return b;
+}
+
+} // namespace metrics
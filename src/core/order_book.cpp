@@ -1,8 +1,20 @@
 #include "order_book.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <vector>
 #include <cassert>
 
-bool OrderBook::add_resting(uint64_t exch_order_id, OrderSide side, int64_t price_ticks, int32_t qty) {
+OrderBook::OrderBook(uint32_t instrument_id, Arena* arena)
+    : arena_(arena),
+      bids_(PriceMap::allocator_type(&mem_.levels, arena)),
+      asks_(PriceMap::allocator_type(&mem_.levels, arena)),
+      id_index_(IdIndex::allocator_type(&mem_.index, arena)),
+      instrument_id_(instrument_id) {}
+
+bool OrderBook::add_resting(uint64_t exch_order_id, OrderSide side, int64_t price_ticks, int32_t qty, uint32_t owner,
+                            OwnerList* owner_list, TimerWheel* timers, uint64_t expire_ns,
+                            uint64_t client_order_id) {
     if (qty <= 0 || price_ticks < 0) [[unlikely]] {
         return false;
     }
@@ -12,12 +24,13 @@ bool OrderBook::add_resting(uint64_t exch_order_id, OrderSide side, int64_t pric
 
     PriceMap& price_map = side_map(side);
     
-    auto [level_it, inserted] = price_map.try_emplace(price_ticks, LevelQueue{});
-    LevelQueue& q = level_it->second;
+    auto [level_it, inserted] = price_map.try_emplace(price_ticks, LevelQueue::allocator_type(&mem_.orders, arena_));
+    PriceLevel& level = level_it->second;
+    LevelQueue& q = level.orders;
 
-    q.push_back(BookOrder{exch_order_id, qty});
+    q.push_back(BookOrder{exch_order_id, qty, owner});
     auto it_order = std::prev(q.end());
-    auto [_, ok] = id_index_.try_emplace(exch_order_id, IndexEntry{side, price_ticks, it_order});
+    auto [idx_it, ok] = id_index_.try_emplace(exch_order_id, side, instrument_id_, price_ticks, it_order);
     if (!ok) {
         // Roll back: remove the order we just pushed
         q.pop_back();
@@ -27,36 +40,140 @@ bool OrderBook::add_resting(uint64_t exch_order_id, OrderSide side, int64_t pric
         assert(false && "id_index_ emplace failed unexpectedly");
         return false;
     }
+    if (inserted) {
+        metrics::count(Metric::LevelsCreated);
+    }
+    if (owner_list) {
+        IndexEntry& e = idx_it->second;
+        owner_list->push_back(&e);
+        if (client_order_id != 0 && owner_list->by_client_id.insert(client_order_id, &e)) {
+            e.owner_list = owner_list;
+            e.client_order_id = client_order_id;
+        }
+    }
+    if (timers) {
+        timers->schedule(&idx_it->second, expire_ns);
+    }
+    level.total_qty += qty;
+    if (is_best(side, level_it)) {
+        top_dirty_ = true;
+    }
 
     return true;
 }
 
 bool OrderBook::cancel_order(uint64_t exch_order_id) {
+    OrderSide side;
+    int64_t price_ticks;
+    return cancel_order(exch_order_id, side, price_ticks);
+}
+
+bool OrderBook::cancel_order(uint64_t exch_order_id, OrderSide& side_out, int64_t& price_out) {
     auto it_idx = id_index_.find(exch_order_id);
     if (it_idx == id_index_.end()) {
         return false;
     }
 
-    const IndexEntry entry = it_idx->second;
+    const IndexEntry& entry = it_idx->second;
+    const OrderSide side = entry.side;
+    const int64_t price_ticks = entry.price_ticks;
 
-    PriceMap& pm = side_map(entry.side);
-    auto lvl_it = pm.find(entry.price_ticks);
+    PriceMap& pm = side_map(side);
+    auto lvl_it = pm.find(price_ticks);
     if (lvl_it == pm.end()) {
         assert(false && "cancel_order: index points to missing level");
-        id_index_.erase(it_idx);
+        erase_entry(it_idx);
         return false;
     }
 
-    LevelQueue& q = lvl_it->second;
-    q.erase(entry.it);
-    if (q.empty()) {
+    if (is_best(side, lvl_it)) {
+        top_dirty_ = true;
+    }
+    PriceLevel& level = lvl_it->second;
+    level.total_qty -= entry.it->qty;
+    level.orders.erase(entry.it);
+    if (level.orders.empty()) {
         pm.erase(lvl_it);
+        metrics::count(Metric::LevelsDeleted);
     }
 
-    id_index_.erase(it_idx);
+    erase_entry(it_idx);
+    side_out = side;
+    price_out = price_ticks;
     return true;
 }
 
+size_t OrderBook::mass_cancel(uint8_t side, uint32_t owner, std::vector<LevelUpdateBody>& out, uint32_t instrument_id) {
+    const size_t before = id_index_.size();
+    for (const OrderSide s : {OrderSide::Bid, OrderSide::Ask}) {
+        if (side != kBothSides && side != static_cast<uint8_t>(s)) {
+            continue;
+        }
+        PriceMap& pm = side_map(s);
+        const size_t first = out.size();
+        for (auto it = pm.begin(); it != pm.end();) {
+            PriceLevel& level = it->second;
+            if (owner == kAnyOwner) {
+                out.push_back(level_update(s, it->first, level, instrument_id, LevelAction::DELETE));
+                ++it;
+                continue;
+            }
+            const size_t n = level.orders.size();
+            for (auto o = level.orders.begin(); o != level.orders.end();) {
+                if (o->owner != owner) {
+                    ++o;
+                    continue;
+                }
+                level.total_qty -= o->qty;
+                erase_entry(id_index_.find(o->exch_order_id));
+                o = level.orders.erase(o);
+            }
+            if (level.orders.size() == n) {
+                ++it;
+            } else if (level.orders.empty()) {
+                out.push_back(level_update(s, it->first, level, instrument_id, LevelAction::DELETE));
+                it = pm.erase(it);
+                metrics::count(Metric::LevelsDeleted);
+            } else {
+                out.push_back(level_update(s, it->first, level, instrument_id, LevelAction::UPDATE));
+                ++it;
+            }
+        }
+        if (owner == kAnyOwner) {
+            if (side != kBothSides) {
+                for (auto it = id_index_.begin(); it != id_index_.end();) {
+                    it = it->second.side == s ? erase_entry(it) : std::next(it);
+                }
+            }
+            metrics::count(Metric::LevelsDeleted, pm.size());
+            pm.clear();
+        }
+        if (s == OrderSide::Bid) {
+            std::reverse(out.begin() + std::ptrdiff_t(first), out.end()); // walked ascending
+        }
+        if (out.size() != first) {
+            top_dirty_ = true;
+        }
+    }
+    if (owner == kAnyOwner && side == kBothSides) {
+        for (auto& [id, entry] : id_index_) {
+            unlink_entry(entry);
+        }
+        id_index_.clear();
+    }
+    return before - id_index_.size();
+}
+
+OrderBook::OwnedOrder OrderBook::owned_order(const OwnerLink* link) {
+    const IndexEntry& e = *static_cast<const IndexEntry*>(link);
+    return OwnedOrder{e.instrument_id, e.side, e.it->exch_order_id};
+}
+
+OrderBook::OwnedOrder OrderBook::timed_order(const TimerLink* link) {
+    const IndexEntry& e = *static_cast<const IndexEntry*>(link);
+    return OwnedOrder{e.instrument_id, e.side, e.it->exch_order_id};
+}
+
 bool OrderBook::best_ask(int64_t& price_out, int32_t& qty_out) const {
     const PriceMap& pm = side_map(OrderSide::Ask);
     if (pm.empty()) {
@@ -66,7 +183,7 @@ bool OrderBook::best_ask(int64_t& price_out, int32_t& qty_out) const {
     const auto it = pm.begin();
     price_out = it->first;
 
-    const LevelQueue& q = it->second;
+    const LevelQueue& q = it->second.orders;
     qty_out = q.empty() ? 0 : q.front().qty;
 
     return true;
@@ -81,13 +198,60 @@ bool OrderBook::best_bid(int64_t& price_out, int32_t& qty_out) const {
     const auto it = pm.rbegin();
     price_out = it->first;
     
-    const LevelQueue& q = it->second;
+    const LevelQueue& q = it->second.orders;
     qty_out = q.empty() ? 0 : q.front().qty;
 
     return true;
 }
 
 
+bool OrderBook::best_level(OrderSide side, int64_t& price_out, int64_t& total_qty_out, uint32_t& count_out) const {
+    const PriceMap& pm = side_map(side);
+    if (pm.empty()) {
+        return false;
+    }
+    const auto& [px, level] = side == OrderSide::Bid ? *pm.rbegin() : *pm.begin();
+    price_out = px;
+    total_qty_out = level.total_qty;
+    count_out = static_cast<uint32_t>(level.orders.size());
+    return true;
+}
+
+bool OrderBook::level_info(OrderSide side, int64_t price_ticks, int64_t& total_qty_out, uint32_t& count_out) const {
+    const PriceMap& pm = side_map(side);
+    auto it = pm.find(price_ticks);
+    if (it == pm.end()) {
+        return false;
+    }
+    total_qty_out = it->second.total_qty;
+    count_out = static_cast<uint32_t>(it->second.orders.size());
+    return true;
+}
+
+void OrderBook::append_levels(std::vector<LevelUpdateBody>& out, uint32_t instrument_id) const {
+    out.reserve(out.size() + bids_.size() + asks_.size());
+    for (auto it = bids_.rbegin(); it != bids_.rend(); ++it) {
+        out.push_back(level_update(OrderSide::Bid, it->first, it->second, instrument_id, LevelAction::ADD));
+    }
+    for (const auto& [px, level] : asks_) {
+        out.push_back(level_update(OrderSide::Ask, px, level, instrument_id, LevelAction::ADD));
+    }
+}
+
+LevelUpdateBody OrderBook::level_update(OrderSide side, int64_t px, const PriceLevel& level, uint32_t instrument_id,
+                                        LevelAction action) {
+    LevelUpdateBody u{};
+    u.price_ticks = px;
+    if (action != LevelAction::DELETE) {
+        u.total_qty = level.total_qty;
+        u.order_count = static_cast<uint32_t>(level.orders.size());
+    }
+    u.instrument_id = instrument_id;
+    u.side = static_cast<uint8_t>(side);
+    u.action = static_cast<uint8_t>(action);
+    return u;
+}
+
 bool OrderBook::best_on_side(OrderSide side, int64_t& px, int32_t& qty) const {
     return side == OrderSide::Ask ? OrderBook::best_ask(px, qty) : OrderBook::best_bid(px, qty);
 }
@@ -117,13 +281,15 @@ int32_t OrderBook::match_taker(uint64_t taker_exch_order_id,
             break;
         }
 
-        LevelQueue& level_queue = resting_pm.find(resting_price_ticks)->second;
+        PriceLevel& level = resting_pm.find(resting_price_ticks)->second;
+        LevelQueue& level_queue = level.orders;
         while (qty > 0 && !level_queue.empty()) {
             BookOrder& resting_order = level_queue.front();
 
             int32_t traded_qty = std::min(qty, resting_order.qty);
             qty -= traded_qty;
             resting_order.qty -= traded_qty;
+            level.total_qty -= traded_qty;
             filled_qty += traded_qty;
 
             TradeBody t{};
@@ -136,13 +302,173 @@ int32_t OrderBook::match_taker(uint64_t taker_exch_order_id,
             out_trades.push_back(t);
 
             if (resting_order.qty == 0) {
-                id_index_.erase(resting_order.exch_order_id);
+                erase_entry(id_index_.find(resting_order.exch_order_id));
                 level_queue.pop_front();
             }
         }
         if (level_queue.empty()) {
             resting_pm.erase(resting_price_ticks);
+            metrics::count(Metric::LevelsDeleted);
         }
     }
+    if (filled_qty > 0) {
+        top_dirty_ = true;
+    }
     return filled_qty;
-}
\ No newline at end of file
+}
+
+AuctionPrice OrderBook::auction_price(int64_t reference_px) const {
+    AuctionPrice best{};
+    if (bids_.empty() || asks_.empty() || bids_.rbegin()->first < asks_.begin()->first) {
+        return best;
+    }
+    // Only levels inside [best ask, best bid] can execute. Walk both sides
+    // ascending over that range; at each level price p:
+    //   cum_bid = bid qty priced >= p, cum_ask = ask qty priced <= p
+    const int64_t lo = asks_.begin()->first;
+    const int64_t hi = bids_.rbegin()->first;
+    auto b = bids_.lower_bound(lo);
+    auto a = asks_.begin();
+    const auto a_end = asks_.upper_bound(hi);
+    int64_t bid_total = 0;
+    for (auto it = b; it != bids_.end(); ++it) {
+        bid_total += it->second.total_qty;
+    }
+    std::vector<int64_t> px;
+    std::vector<int64_t> cum_bid;
+    std::vector<int64_t> cum_ask;
+    int64_t bids_below = 0;
+    int64_t asks_upto = 0;
+    while (b != bids_.end() || a != a_end) {
+        const int64_t p = (a == a_end || (b != bids_.end() && b->first < a->first)) ? b->first : a->first;
+        int64_t bid_here = 0;
+        if (b != bids_.end() && b->first == p) {
+            bid_here = b->second.total_qty;
+            ++b;
+        }
+        if (a != a_end && a->first == p) {
+            asks_upto += a->second.total_qty;
+            ++a;
+        }
+        px.push_back(p);
+        cum_bid.push_back(bid_total - bids_below);
+        cum_ask.push_back(asks_upto);
+        bids_below += bid_here;
+    }
+
+    // one pass: maximum volume, then minimum surplus; keep every tie
+    std::vector<size_t> tied;
+    int64_t best_abs_surplus = 0;
+    for (size_t i = 0; i < px.size(); ++i) {
+        const int64_t volume = std::min(cum_bid[i], cum_ask[i]);
+        const int64_t abs_surplus = std::abs(cum_bid[i] - cum_ask[i]);
+        if (volume > best.volume || (volume == best.volume && abs_surplus < best_abs_surplus)) {
+            best.volume = volume;
+            best_abs_surplus = abs_surplus;
+            tied.clear();
+        }
+        if (volume == best.volume && abs_surplus == best_abs_surplus) {
+            tied.push_back(i);
+        }
+    }
+    if (best.volume == 0) {
+        return AuctionPrice{};
+    }
+
+    // market pressure, then the reference price
+    const bool all_buy = std::all_of(tied.begin(), tied.end(), [&](size_t i) { return cum_bid[i] > cum_ask[i]; });
+    const bool all_sell = std::all_of(tied.begin(), tied.end(), [&](size_t i) { return cum_bid[i] < cum_ask[i]; });
+    size_t pick = tied.front();
+    if (all_buy) {
+        pick = tied.back();
+    } else if (!all_sell) {
+        const int64_t ref = reference_px >= 0 ? reference_px : (px[tied.front()] + px[tied.back()]) / 2;
+        for (size_t i : tied) {
+            if (std::abs(px[i] - ref) < std::abs(px[pick] - ref)) {
+                pick = i;
+            }
+        }
+    }
+    best.price_ticks = px[pick];
+    best.surplus = cum_bid[pick] - cum_ask[pick];
+    return best;
+}
+
+int64_t OrderBook::uncross(const AuctionPrice& p, std::vector<TradeBody>& trades, std::vector<LevelUpdateBody>& levels,
+                           uint32_t instrument_id) {
+    if (p.volume <= 0 || bids_.empty() || asks_.empty()) {
+        return 0;
+    }
+    std::vector<LevelUpdateBody> ask_levels;
+    std::vector<uint64_t> filled;
+    auto b = std::prev(bids_.end());
+    auto a = asks_.begin();
+    bool b_touched = false;
+    bool a_touched = false;
+    int64_t left = p.volume;
+    while (left > 0 && b->first >= p.price_ticks && a->first <= p.price_ticks) {
+        BookOrder& buy = b->second.orders.front();
+        BookOrder& sell = a->second.orders.front();
+        const int32_t qty = static_cast<int32_t>(std::min<int64_t>(left, std::min(buy.qty, sell.qty)));
+
+        TradeBody t{};
+        t.price_ticks = p.price_ticks;
+        t.qty = qty;
+        t.liquidity_flag = kLiquidityAuction;
+        t.resting_exch_order_id = sell.exch_order_id;
+        t.taking_exch_order_id = buy.exch_order_id;
+        t.instrument_id = instrument_id;
+        trades.push_back(t);
+
+        left -= qty;
+        buy.qty -= qty;
+        sell.qty -= qty;
+        b->second.total_qty -= qty;
+        a->second.total_qty -= qty;
+        b_touched = a_touched = true;
+
+        if (buy.qty == 0) {
+            filled.push_back(buy.exch_order_id);
+            b->second.orders.pop_front();
+            if (b->second.orders.empty()) {
+                levels.push_back(level_update(OrderSide::Bid, b->first, b->second, instrument_id, LevelAction::DELETE));
+                const bool last = b == bids_.begin();
+                const auto next = last ? bids_.end() : std::prev(b);
+                bids_.erase(b);
+                metrics::count(Metric::LevelsDeleted);
+                b_touched = false;
+                b = next;
+            }
+        }
+        if (sell.qty == 0) {
+            filled.push_back(sell.exch_order_id);
+            a->second.orders.pop_front();
+            if (a->second.orders.empty()) {
+                ask_levels.push_back(level_update(OrderSide::Ask, a->first, a->second, instrument_id, LevelAction::DELETE));
+                a = asks_.erase(a);
+                metrics::count(Metric::LevelsDeleted);
+                a_touched = false;
+            }
+        }
+        if (b == bids_.end() || a == asks_.end()) {
+            break; // a side ran out: only if p overstated the volume
+        }
+    }
+    // the last level on each side may be partly filled
+    if (b_touched) {
+        levels.push_back(level_update(OrderSide::Bid, b->first, b->second, instrument_id, LevelAction::UPDATE));
+    }
+    if (a_touched) {
+        ask_levels.push_back(level_update(OrderSide::Ask, a->first, a->second, instrument_id, LevelAction::UPDATE));
+    }
+    levels.insert(levels.end(), ask_levels.begin(), ask_levels.end());
+    // Queues hold orders in time order, which is scattered across the index;
+    // erasing in id order instead walks it (and its nodes) roughly in
+    // allocation order.
+    std::sort(filled.begin(), filled.end());
+    for (uint64_t id : filled) {
+        erase_entry(id_index_.find(id));
+    }
+    top_dirty_ = true;
+    return p.volume - left;
+}
@@ -0,0 +1,295 @@
+#include "replay.hpp"
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clock.hpp"
+#include "codec.hpp"
+#include "engine.hpp"
+#include "spsc_ring.hpp" // kCacheLine
+
+namespace {
+
+// The default three instruments, then SYM4.. up to num_instruments, as
+// FlowGenerator lists them for its shadow engine.
+std::unique_ptr<Engine> make_engine(uint32_t num_instruments) {
+    auto engine = std::make_unique<Engine>();
+    while (engine->num_instruments() < num_instruments) {
+        engine->add_new_instrument("SYM" + std::to_string(engine->num_instruments() + 1));
+    }
+    return engine;
+}
+
+bool is_request(const Header& hdr) {
+    return hdr.type == static_cast<uint8_t>(MsgType::NEW) || hdr.type == static_cast<uint8_t>(MsgType::CANCEL);
+}
+
+EngineResult run_request(Engine& engine, const Header& hdr, std::span<const uint8_t> body) {
+    if (hdr.type == static_cast<uint8_t>(MsgType::NEW)) {
+        const auto m = codec::decode_body<OrderNewBody>(body);
+        return engine.on_new(m, (m.flags & TIF_IOC) == 0);
+    }
+    return engine.on_cancel(codec::decode_body<OrderCancelBody>(body));
+}
+
+void tally(ReplayStats& st, const Header& hdr, const AckBody& ack, size_t trades, size_t levels) {
+    if (hdr.type == static_cast<uint8_t>(MsgType::NEW)) {
+        ++st.news;
+    } else {
+        ++st.cancels;
+    }
+    st.rejects += ack.status != 0;
+    st.trades += trades;
+    st.levels += levels;
+}
+
+ReplayStats replay_serial(CaptureFile& capture, const ReplayOptions& opt, ReplaySink& sink) {
+    ReplayStats st;
+    st.partitions = 1;
+    auto engine = make_engine(opt.num_instruments);
+    CaptureFile::Frame f;
+    const uint64_t t0 = clk::now_ns();
+    while (capture.next(f)) {
+        if (!is_request(f.hdr)) {
+            continue;
+        }
+        const EngineResult res = run_request(*engine, f.hdr, f.body);
+        tally(st, f.hdr, res.ack, res.trades.size(), res.levels.size());
+        sink.on_result(f.hdr, res.ack, res.trades, res.levels);
+    }
+    st.elapsed_ns = clk::now_ns() - t0;
+    return st;
+}
+
+// A request routed to a partition by the split pass.
+struct Event {
+    const uint8_t* frame;   // Header then body, in the mapped capture
+    uint64_t exch_order_id; // what a NEW must be given, 0 if it is refused (and for a CANCEL)
+};
+
+// The instruments with one id modulo the partition count, their engine,
+// and one window's requests and results.
+struct Partition {
+    std::unique_ptr<Engine> engine;
+    std::vector<Event> events;           // this window's, in capture order
+    std::vector<AckBody> acks;           // one per event
+    std::vector<uint32_t> trade_counts;  // one per event
+    std::vector<uint32_t> level_counts;
+    std::vector<TradeBody> trades;       // every event's, in order
+    std::vector<LevelUpdateBody> levels;
+    bool consistent = true;
+    // merge cursors
+    size_t next_event = 0;
+    size_t next_trade = 0;
+    size_t next_level = 0;
+
+    void run() {
+        acks.clear();
+        trade_counts.clear();
+        level_counts.clear();
+        trades.clear();
+        levels.clear();
+        next_event = next_trade = next_level = 0;
+        for (const Event& ev : events) {
+            Header hdr;
+            std::memcpy(&hdr, ev.frame, sizeof(Header));
+            const std::span<const uint8_t> body(ev.frame + sizeof(Header), hdr.size - sizeof(Header));
+            const bool is_new = hdr.type == static_cast<uint8_t>(MsgType::NEW);
+            if (is_new && ev.exch_order_id != 0) {
+                engine->set_next_exch_id(ev.exch_order_id);
+            }
+            const EngineResult res = run_request(*engine, hdr, body);
+            if (is_new && res.ack.exch_order_id != ev.exch_order_id) {
+                consistent = false;
+            }
+            acks.push_back(res.ack);
+            trade_counts.push_back(uint32_t(res.trades.size()));
+            level_counts.push_back(uint32_t(res.levels.size()));
+            trades.insert(trades.end(), res.trades.begin(), res.trades.end());
+            levels.insert(levels.end(), res.levels.begin(), res.levels.end());
+        }
+    }
+};
+
+// Runs one window's partitions on `threads` workers: the calling thread and
+// threads - 1 pool threads, released and collected by two barriers. Each
+// worker has a queue of partition indexes; it takes its own from the front
+// (largest first) and, once empty, steals from the back of the others'.
+class WorkerPool {
+public:
+    WorkerPool(unsigned threads, std::vector<Partition>& parts)
+        : parts_(parts), queues_(threads), start_(threads), done_(threads) {
+        for (unsigned w = 1; w < threads; ++w) {
+            threads_.emplace_back([this, w] { work(w); });
+        }
+    }
+    ~WorkerPool() {
+        stop_ = true;
+        start_.arrive_and_wait();
+        for (std::thread& t : threads_) {
+            t.join();
+        }
+    }
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Runs every partition with events; returns once all have run.
+    void run() {
+        std::vector<uint32_t> order;
+        for (uint32_t p = 0; p < parts_.size(); ++p) {
+            if (!parts_[p].events.empty()) {
+                order.push_back(p);
+            }
+        }
+        std::sort(order.begin(), order.end(),
+                  [&](uint32_t a, uint32_t b) { return parts_[a].events.size() > parts_[b].events.size(); });
+        for (size_t i = 0; i < order.size(); ++i) {
+            queues_[i % queues_.size()].ids.push_back(order[i]);
+        }
+        start_.arrive_and_wait();
+        drain(0);
+        done_.arrive_and_wait();
+    }
+
+    uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(kCacheLine) Queue {
+        std::mutex mu;
+        std::deque<uint32_t> ids;
+    };
+
+    void work(unsigned w) {
+        for (;;) {
+            start_.arrive_and_wait();
+            if (stop_) {
+                return;
+            }
+            drain(w);
+            done_.arrive_and_wait();
+        }
+    }
+
+    void drain(unsigned w) {
+        uint32_t p;
+        while (take(w, p)) {
+            parts_[p].run();
+        }
+    }
+
+    // Nothing is queued while a window runs, so all queues empty means done.
+    bool take(unsigned w, uint32_t& p) {
+        {
+            Queue& own = queues_[w];
+            std::lock_guard<std::mutex> lock(own.mu);
+            if (!own.ids.empty()) {
+                p = own.ids.front();
+                own.ids.pop_front();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < queues_.size(); ++k) {
+            Queue& victim = queues_[(w + k) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mu);
+            if (!victim.ids.empty()) {
+                p = victim.ids.back();
+                victim.ids.pop_back();
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Partition>& parts_;
+    std::vector<Queue> queues_;
+    std::vector<std::thread> threads_;
+    std::barrier<> start_;
+    std::barrier<> done_;
+    bool stop_ = false; // set before start_, which orders it for the workers
+    std::atomic<uint64_t> steals_{0};
+};
+
+ReplayStats replay_parallel(CaptureFile& capture, const ReplayOptions& opt, ReplaySink& sink) {
+    ReplayStats st;
+    // predicts which NEWs are accepted, so ids can be numbered up front
+    const auto reference = make_engine(opt.num_instruments);
+    // a few partitions per worker, so stealing can even out skewed instruments
+    const size_t num_parts = std::clamp<size_t>(reference->num_instruments(), 1, size_t(opt.threads) * 4);
+    std::vector<Partition> parts(num_parts);
+    for (Partition& part : parts) {
+        part.engine = make_engine(opt.num_instruments);
+    }
+    WorkerPool pool(opt.threads, parts);
+    const uint64_t t0 = clk::now_ns();
+
+    const uint64_t window = std::max<uint64_t>(opt.window_frames, 1);
+    std::vector<uint32_t> route; // partition of each request of the window, in capture order
+    uint64_t next_exch_id = 1;
+    CaptureFile::Frame f;
+    bool more = true;
+    while (more) {
+        // --- split
+        route.clear();
+        for (Partition& part : parts) {
+            part.events.clear();
+        }
+        while (route.size() < window && (more = capture.next(f))) {
+            if (!is_request(f.hdr)) {
+                continue;
+            }
+            uint32_t instrument_id;
+            uint64_t exch_order_id = 0;
+            if (f.hdr.type == static_cast<uint8_t>(MsgType::NEW)) {
+                const auto m = codec::decode_body<OrderNewBody>(f.body);
+                instrument_id = m.instrument_id;
+                if (reference->valid_new(m, clk::now_ns())) {
+                    exch_order_id = next_exch_id++;
+                }
+            } else {
+                instrument_id = codec::decode_body<OrderCancelBody>(f.body).instrument_id;
+            }
+            const uint32_t p = uint32_t(instrument_id % num_parts);
+            parts[p].events.push_back(Event{f.body.data() - sizeof(Header), exch_order_id});
+            route.push_back(p);
+        }
+        if (route.empty()) {
+            break;
+        }
+        // --- replay
+        pool.run();
+        // --- merge
+        for (const uint32_t p : route) {
+            Partition& part = parts[p];
+            const size_t i = part.next_event++;
+            Header hdr;
+            std::memcpy(&hdr, part.events[i].frame, sizeof(Header));
+            const std::span<const TradeBody> trades(part.trades.data() + part.next_trade, part.trade_counts[i]);
+            const std::span<const LevelUpdateBody> levels(part.levels.data() + part.next_level, part.level_counts[i]);
+            part.next_trade += trades.size();
+            part.next_level += levels.size();
+            tally(st, hdr, part.acks[i], trades.size(), levels.size());
+            sink.on_result(hdr, part.acks[i], trades, levels);
+        }
+    }
+    st.partitions = num_parts;
+    st.steals = pool.steals();
+    for (const Partition& part : parts) {
+        st.consistent = st.consistent && part.consistent;
+    }
+    st.elapsed_ns = clk::now_ns() - t0;
+    return st;
+}
+
+} // namespace
+
+ReplayStats replay(CaptureFile& capture, const ReplayOptions& opt, ReplaySink& sink) {
+    return opt.threads == 0 ? replay_serial(capture, opt, sink) : replay_parallel(capture, opt, sink);
+}
@@ -0,0 +1,97 @@
+#include "session_queue.hpp"
+#include "metrics.hpp"
+#include <sys/socket.h>
+#include <cerrno>
+
+#ifdef MSG_NOSIGNAL
+static constexpr int kSendFlags = MSG_NOSIGNAL | MSG_DONTWAIT;
+#else
+static constexpr int kSendFlags = MSG_DONTWAIT;
+#endif
+
+void SessionOutQueue::append(const uint8_t* frame, size_t len) {
+    buf_.insert(buf_.end(), frame, frame + len);
+}
+
+void SessionOutQueue::push_reliable(const uint8_t* frame, size_t len) {
+    append(frame, len);
+}
+
+void SessionOutQueue::push_conflatable(uint32_t key, const uint8_t* frame, size_t len) {
+    auto it = pending_index_.find(key);
+    if (it != pending_index_.end()) {
+        // an older update for this key never reached the wire: replace it in place
+        pending_[it->second].frame.assign(frame, frame + len);
+        ++conflated_;
+        return;
+    }
+    if (bytes_queued() < cfg_.watermark) {
+        append(frame, len);
+        return;
+    }
+    pending_index_.emplace(key, pending_.size());
+    pending_.push_back(Pending{key, std::vector<uint8_t>(frame, frame + len)});
+}
+
+void SessionOutQueue::release_pending() {
+    if (pending_.empty() || bytes_queued() >= cfg_.watermark) {
+        return;
+    }
+    for (const Pending& p : pending_) {
+        append(p.frame.data(), p.frame.size());
+    }
+    pending_.clear();
+    pending_index_.clear();
+}
+
+bool SessionOutQueue::flush(int fd) {
+    for (int round = 0; round < 2; ++round) {
+        while (head_ < buf_.size()) {
+            ssize_t n = ::send(fd, buf_.data() + head_, buf_.size() - head_, kSendFlags);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                return false;
+            }
+            head_ += size_t(n);
+            metrics::count(Metric::BytesOut, uint64_t(n));
+        }
+        if (head_ == buf_.size()) {
+            buf_.clear();
+            head_ = 0;
+        } else if (head_ > buf_.size() / 2) {
+            buf_.erase(buf_.begin(), buf_.begin() + static_cast<std::ptrdiff_t>(head_));
+            head_ = 0;
+        }
+        // the backlog may have drained enough to let the conflated frames out
+        const size_t before = bytes_queued();
+        release_pending();
+        if (bytes_queued() == before) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool SessionOutQueue::should_disconnect(uint64_t now_ns) {
+    if (bytes_queued() <= cfg_.cap) {
+        over_cap_since_ns_ = 0;
+        return false;
+    }
+    if (over_cap_since_ns_ == 0) {
+        over_cap_since_ns_ = now_ns;
+    }
+    return now_ns - over_cap_since_ns_ > cfg_.max_over_cap_ns;
+}
+
+void SessionOutQueue::discard() {
+    dropped_ += pending_.size();
+    pending_.clear();
+    pending_index_.clear();
+    buf_.clear();
+    head_ = 0;
+}
@@ -0,0 +1,132 @@
+#include "stage_latency.hpp"
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace {
+
+constexpr const char* kNames[kNumLatencyStages] = {
+    "new_total",
+    "cancel_total",
+    "mass_cancel_total",
+    "stats_total",
+    "decode",
+    "validate",
+    "match_0",
+    "match_1",
+    "match_2_4",
+    "match_5_16",
+    "match_17_plus",
+    "cancel",
+    "encode",
+    "write",
+};
+
+struct Registry {
+    std::mutex mu;
+    std::vector<std::unique_ptr<LatencyShard>> shards;
+    std::vector<LatencyShard*> free; // released by threads that exited
+};
+
+// Never destroyed: threads may still record during static destruction.
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+// Hands the thread's shard back when it exits (see metrics.cpp).
+struct ShardLease {
+    LatencyShard* shard = nullptr;
+    ~ShardLease() {
+        if (shard != nullptr) {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mu);
+            r.free.push_back(shard);
+            latency::t_shard = nullptr;
+        }
+    }
+};
+
+thread_local ShardLease t_lease;
+
+} // namespace
+
+const char* latency_stage_name(LatencyStage s) {
+    const size_t i = static_cast<size_t>(s);
+    return i < kNumLatencyStages ? kNames[i] : "unknown";
+}
+
+namespace latency {
+
+LatencyShard* register_thread() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    if (!r.free.empty()) {
+        t_shard = r.free.back();
+        r.free.pop_back();
+    } else {
+        r.shards.push_back(std::make_unique<LatencyShard>());
+        t_shard = r.shards.back().get();
+    }
+    t_lease.shard = t_shard;
+    return t_shard;
+}
+
+LatencyHistogram read(LatencyStage s) {
+    LatencyHistogram total;
+    auto counts = std::make_unique<std::array<uint64_t, LatencyHistogram::kBuckets>>();
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    for (const auto& shard : r.shards) {
+        const LatencyShard::Series& h = shard->series[static_cast<size_t>(s)];
+        if (h.count.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        // buckets first: count and sum may run slightly ahead of them, never behind
+        for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+            (*counts)[i] = h.counts[i].load(std::memory_order_relaxed);
+        }
+        total.merge_counts(*counts, h.sum.load(std::memory_order_relaxed), h.min.load(std::memory_order_relaxed),
+                           h.max.load(std::memory_order_relaxed));
+    }
+    return total;
+}
+
+std::string format() {
+    std::ostringstream out;
+    for (size_t i = 0; i < kNumLatencyStages; ++i) {
+        const LatencyHistogram h = read(static_cast<LatencyStage>(i));
+        if (h.count() == 0) {
+            continue;
+        }
+        out << kNames[i] << " n=" << h.count() << " min=" << h.min() << " p50=" << h.percentile(50)
+            << " p90=" << h.percentile(90) << " p99=" << h.percentile(99) << " p99.9=" << h.percentile(99.9)
+            << " max=" << h.max() << " mean=" << uint64_t(h.mean()) << "\n";
+    }
+    return out.str();
+}
+
+std::vector<LatencyBody> latency_bodies(uint64_t request_id) {
+    std::vector<LatencyBody> out;
+    for (size_t i = 0; i < kNumLatencyStages; ++i) {
+        const LatencyHistogram h = read(static_cast<LatencyStage>(i));
+        if (h.count() == 0) {
+            continue;
+        }
+        LatencyBody b{};
+        b.request_id = request_id;
+        b.stage = static_cast<uint8_t>(i);
+        b.count = h.count();
+        b.min_ns = h.min();
+        b.p50_ns = h.percentile(50);
+        b.p90_ns = h.percentile(90);
+        b.p99_ns = h.percentile(99);
+        b.p999_ns = h.percentile(99.9);
+        b.max_ns = h.max();
+        b.mean_ns = uint64_t(h.mean());
+        out.push_back(b);
+    }
+    return out;
+}
+
+} // namespace latency
@@ -0,0 +1,120 @@
+#include "arena.hpp"
+#include "engine.hpp"
+#include "order_book.hpp"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+static bool aligned(const void* p, size_t to) {
+    return reinterpret_cast<uintptr_t>(p) % to == 0;
+}
+
+// Same orders on the heap and in an arena: same trades, levels and accounting.
+static void check_book(Arena* arena) {
+    OrderBook heap_book(1);
+    OrderBook arena_book(1, arena);
+    std::vector<TradeBody> heap_trades, arena_trades;
+    for (uint64_t id = 1; id <= 20'000; ++id) {
+        const OrderSide side = id % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const int64_t px = side == OrderSide::Bid ? 1000 - int64_t(id % 97) : 1001 + int64_t(id % 89);
+        assert(heap_book.add_resting(id, side, px, 10) && arena_book.add_resting(id, side, px, 10));
+    }
+    for (uint64_t id = 3; id <= 20'000; id += 3) {
+        assert(heap_book.cancel_order(id) && arena_book.cancel_order(id));
+    }
+    assert(heap_book.match_taker(50'000, OrderSide::Bid, 1040, 5'000, heap_trades, 1, 0) ==
+           arena_book.match_taker(50'000, OrderSide::Bid, 1040, 5'000, arena_trades, 1, 0));
+    assert(heap_trades.size() == arena_trades.size() && !arena_trades.empty());
+    assert(std::memcmp(heap_trades.data(), arena_trades.data(), heap_trades.size() * sizeof(TradeBody)) == 0);
+    std::vector<LevelUpdateBody> heap_levels, arena_levels;
+    heap_book.append_levels(heap_levels, 1);
+    arena_book.append_levels(arena_levels, 1);
+    assert(heap_levels.size() == arena_levels.size());
+    assert(std::memcmp(heap_levels.data(), arena_levels.data(), heap_levels.size() * sizeof(LevelUpdateBody)) == 0);
+    assert(heap_book.memory().bytes() == arena_book.memory().bytes());
+}
+
+int main() {
+    assert(std::string(arena_pages_name(ArenaPages::Transparent)) == "transparent");
+    ArenaPages parsed = ArenaPages::Normal;
+    assert(parse_arena_pages("auto", parsed) && parsed == ArenaPages::Auto);
+    assert(!parse_arena_pages("huge", parsed));
+
+    // --- size classes, reuse, alignment
+    {
+        ArenaConfig cfg;
+        cfg.region_bytes = 1; // rounded up to one 2MB region
+        Arena a(cfg);
+        assert(a.num_regions() == 1 && a.mapped_bytes() == Arena::kHugePage);
+        void* p = a.allocate(40);
+        void* q = a.allocate(48);
+        assert(aligned(p, Arena::kAlign) && aligned(q, Arena::kAlign) && p != q);
+        assert(a.used_bytes() == 96);
+        a.deallocate(p, 40);
+        assert(a.allocate(33) == p); // same 48-byte class comes back
+        void* big = a.allocate(600); // 1KB class
+        assert(aligned(big, Arena::kAlign) && a.used_bytes() == 96 + 1024);
+        std::memset(big, 0xab, 600);
+        a.deallocate(big, 600);
+        assert(a.allocate(1000) == big);
+
+        // above kMaxPooled: a mapping of its own, returned on free
+        const size_t mapped = a.mapped_bytes();
+        void* huge = a.allocate(Arena::kMaxPooled + 1);
+        assert(aligned(huge, Arena::kAlign) && a.mapped_bytes() == mapped + Arena::kHugePage);
+        std::memset(huge, 1, Arena::kMaxPooled + 1);
+        a.deallocate(huge, Arena::kMaxPooled + 1);
+        assert(a.mapped_bytes() == mapped);
+
+        // past the first region: another one
+        for (int i = 0; i < 5; ++i) {
+            std::memset(a.allocate(Arena::kMaxPooled), 2, Arena::kMaxPooled);
+        }
+        assert(a.num_regions() >= 3);
+    }
+
+    // --- every backing serves a book exactly like the heap does; explicit
+    // huge pages fall back when no hugetlbfs pool is reserved
+    for (ArenaPages pages : {ArenaPages::Auto, ArenaPages::Explicit, ArenaPages::Transparent, ArenaPages::Normal}) {
+        ArenaConfig cfg;
+        cfg.region_bytes = 4 * Arena::kHugePage;
+        cfg.pages = pages;
+        Arena a(cfg);
+        assert(a.backing() != ArenaPages::Auto);
+        if (pages == ArenaPages::Normal) {
+            assert(a.backing() == ArenaPages::Normal);
+        }
+        if (pages == ArenaPages::Transparent) {
+            assert(a.backing() != ArenaPages::Explicit);
+        }
+        check_book(&a);
+        std::cout << "arena: asked " << arena_pages_name(pages) << ", got " << arena_pages_name(a.backing())
+                  << ", node " << a.node() << "\n";
+    }
+
+    // --- an engine owning its arena
+    ArenaConfig cfg;
+    cfg.pages = ArenaPages::Normal;
+    Engine engine(std::make_unique<Arena>(cfg));
+    assert(engine.arena() != nullptr && engine.arena()->backing() == ArenaPages::Normal);
+    OrderNewBody o{};
+    o.client_order_id = 1;
+    o.instrument_id = 1;
+    o.price_ticks = 100;
+    o.qty = 5;
+    assert(engine.on_new(o, true).ack.status == 0);
+    const size_t used = engine.arena()->used_bytes();
+    assert(used > 0);
+    o.side = 1;
+    o.client_order_id = 2;
+    const EngineResult r = engine.on_new(o, true);
+    assert(r.trades.size() == 1 && engine.num_resting_orders() == 0);
+    assert(engine.arena()->used_bytes() < used);
+    assert(Engine().arena() == nullptr);
+
+    std::cout << "arena test passed\n";
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "engine.hpp"
+#include "order_book.hpp"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+static OrderNewBody order(uint64_t cid, uint8_t side, int64_t px, int32_t qty) {
+    OrderNewBody o{};
+    o.client_order_id = cid;
+    o.instrument_id = 1;
+    o.side = side;
+    o.price_ticks = px;
+    o.qty = qty;
+    return o;
+}
+
+static AuctionPrice price_of(std::initializer_list<std::pair<int64_t, int32_t>> bids,
+                             std::initializer_list<std::pair<int64_t, int32_t>> asks, int64_t reference = -1) {
+    OrderBook ob;
+    uint64_t id = 1;
+    for (auto [px, qty] : bids) {
+        ob.add_resting(id++, OrderSide::Bid, px, qty);
+    }
+    for (auto [px, qty] : asks) {
+        ob.add_resting(id++, OrderSide::Ask, px, qty);
+    }
+    return ob.auction_price(reference);
+}
+
+int main() {
+    // --- equilibrium: maximum executable volume
+    //   px   cum bid  cum ask  volume
+    //   99     60       25       25
+    //  100     60       40       40   <- surplus +20
+    //  101     30       60       30
+    //  102     10       60       10
+    OrderBook ob;
+    assert(ob.add_resting(1, OrderSide::Bid, 102, 10, 5));
+    assert(ob.add_resting(2, OrderSide::Bid, 101, 20, 5));
+    assert(ob.add_resting(3, OrderSide::Bid, 100, 30, 5));
+    assert(ob.add_resting(4, OrderSide::Ask, 99, 25, 6));
+    assert(ob.add_resting(5, OrderSide::Ask, 100, 15, 6));
+    assert(ob.add_resting(6, OrderSide::Ask, 101, 20, 6));
+    AuctionPrice p = ob.auction_price();
+    assert(p.price_ticks == 100 && p.volume == 40 && p.surplus == 20);
+
+    // --- tie-breaks
+    assert(price_of({{99, 10}}, {{100, 10}}).volume == 0);                 // not crossed
+    assert(price_of({{102, 10}}, {{100, 5}}).price_ticks == 102);          // buy surplus: highest
+    assert(price_of({{102, 5}}, {{100, 10}}).price_ticks == 100);          // sell surplus: lowest
+    assert(price_of({{104, 10}}, {{100, 10}}).price_ticks == 100);         // balanced: middle, lower on a tie
+    assert(price_of({{104, 10}}, {{100, 10}}, 104).price_ticks == 104);    // balanced: nearest the reference
+    assert(price_of({{104, 10}}, {{100, 10}, {103, 10}}, 101).price_ticks == 100);
+    // equal volume everywhere: the smaller surplus (+5 at 100 and 101, -10 above) wins, then buy pressure
+    const AuctionPrice s = price_of({{103, 10}, {101, 5}}, {{100, 10}, {102, 10}});
+    assert(s.volume == 10 && s.price_ticks == 101 && s.surplus == 5);
+
+    // --- uncross: every fill at the one price, bids and asks best-first
+    std::vector<TradeBody> trades;
+    std::vector<LevelUpdateBody> levels;
+    assert(ob.uncross(p, trades, levels, 1) == 40);
+    assert(trades.size() == 4);
+    const uint64_t pairs[4][3] = {{1, 4, 10}, {2, 4, 15}, {2, 5, 5}, {3, 5, 10}}; // buy, sell, qty
+    for (size_t i = 0; i < trades.size(); ++i) {
+        assert(trades[i].price_ticks == 100 && trades[i].liquidity_flag == kLiquidityAuction);
+        assert(trades[i].taking_exch_order_id == pairs[i][0] && trades[i].resting_exch_order_id == pairs[i][1]);
+        assert(uint64_t(trades[i].qty) == pairs[i][2]);
+    }
+    assert(levels.size() == 5);
+    assert(levels[0].side == 0 && levels[0].price_ticks == 102 && levels[0].action == uint8_t(LevelAction::DELETE));
+    assert(levels[1].price_ticks == 101 && levels[1].action == uint8_t(LevelAction::DELETE));
+    assert(levels[2].price_ticks == 100 && levels[2].action == uint8_t(LevelAction::UPDATE) && levels[2].total_qty == 20);
+    assert(levels[3].side == 1 && levels[3].price_ticks == 99 && levels[3].action == uint8_t(LevelAction::DELETE));
+    assert(levels[4].price_ticks == 100 && levels[4].action == uint8_t(LevelAction::DELETE));
+    int64_t bpx = 0, apx = 0;
+    int32_t bq = 0, aq = 0;
+    assert(ob.best_bid(bpx, bq) && ob.best_ask(apx, aq) && bpx == 100 && apx == 101 && bq == 20 && aq == 20);
+    assert(ob.num_orders() == 2 && ob.auction_price().volume == 0);
+
+    // --- engine: orders rest without matching until the uncross
+    Engine engine;
+    assert(engine.start_auction(1) && !engine.start_auction(99));
+    assert(engine.on_new(order(1, 0, 105, 10), true, 1).trades.empty());
+    assert(engine.on_new(order(2, 1, 95, 4), true, 2).trades.empty());   // crosses, does not trade
+    assert(engine.on_new(order(3, 1, 100, 10), true, 2).trades.empty());
+    assert(engine.on_new(order(4, 1, 95, 5), false, 2).ack.status == 1); // IOC refused in auction
+    OrderCancelBody c{};
+    c.exch_order_id = 2;
+    c.instrument_id = 1;
+    assert(engine.on_cancel(c).ack.status == 0);                          // cancels still work
+    assert(engine.on_new(order(5, 1, 96, 4), true, 2).ack.status == 0);
+    AuctionPrice ind;
+    assert(engine.indicative_auction(1, ind) && ind.volume == 10 && !engine.indicative_auction(2, ind));
+    // cum bid 10 everywhere in [96, 105]; cum ask 4 at 96..99, 14 from 100: volume 10 at 100..105 with
+    // sell surplus -4 -> lowest
+    assert(ind.price_ticks == 100 && ind.surplus == -4);
+    assert(engine.num_session_orders(1) == 1);
+
+    EngineResult r = engine.uncross(1);
+    assert(r.ack.status == 0 && r.trades.size() == 2);
+    assert(r.trades[0].price_ticks == 100 && r.trades[1].price_ticks == 100);
+    assert(r.trades[0].qty == 4 && r.trades[1].qty == 6);
+    assert(engine.num_session_orders(1) == 0 && engine.num_session_orders(2) == 1); // filled orders unlinked
+    std::vector<BboBody> bbos;
+    engine.flush_bbo(bbos);
+    assert(bbos.size() == 1 && bbos[0].ask_price_ticks == 100 && bbos[0].ask_total_qty == 4);
+    assert(engine.uncross(1).ack.status == 1); // no longer in auction
+
+    // continuous matching resumes
+    r = engine.on_new(order(6, 0, 100, 4), false, 1);
+    assert(r.trades.size() == 1 && r.trades[0].liquidity_flag == 0);
+
+    std::cout << "auction test passed\n";
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "bar_aggregator.hpp"
+#include <cassert>
+#include <iostream>
+
+static TradeBody trade(uint32_t instr, int64_t px, int32_t qty) {
+    TradeBody t{};
+    t.instrument_id = instr;
+    t.price_ticks = px;
+    t.qty = qty;
+    return t;
+}
+
+int main() {
+    // intervals 100ns and 1000ns, instruments 0..3
+    BarAggregator bars(4, {100, 1000});
+    BarBody b;
+    assert(!bars.try_pop(b));
+    assert(!bars.current(1, 0, b));
+
+    bars.on_trade(trade(1, 100, 10), 5);
+    bars.on_trade(trade(1, 104, 5), 20);
+    bars.on_trade(trade(1, 98, 5), 60);
+    bars.on_trade(trade(2, 500, 1), 70);
+    assert(bars.current(1, 0, b) && b.trade_count == 3 && b.close_ticks == 98);
+    assert(!bars.try_pop(b)); // nothing completed yet
+
+    // a trade in the next 100ns interval closes instrument 1's first bar only
+    bars.on_trade(trade(1, 101, 1), 150);
+    assert(bars.try_pop(b));
+    assert(b.instrument_id == 1 && b.interval_ns == 100 && b.start_ns == 0);
+    assert(b.open_ticks == 100 && b.high_ticks == 104 && b.low_ticks == 98 && b.close_ticks == 98);
+    assert(b.volume == 20 && b.notional == 100 * 10 + 104 * 5 + 98 * 5 && b.trade_count == 3);
+    assert(!bars.try_pop(b));
+    // the 1000ns bar keeps accumulating
+    assert(bars.current(1, 1, b) && b.trade_count == 4 && b.volume == 21 && b.open_ticks == 100);
+
+    // timer: closes whatever has ended
+    bars.close_expired(199); // instrument 2's [0,100)
+    assert(bars.try_pop(b) && b.instrument_id == 2 && b.start_ns == 0 && b.open_ticks == 500);
+    assert(!bars.try_pop(b));
+    bars.close_expired(200); // instrument 1's [100,200)
+    assert(bars.try_pop(b) && b.instrument_id == 1 && b.start_ns == 100 && b.trade_count == 1);
+    assert(!bars.try_pop(b));
+    bars.close_expired(1000);
+    assert(bars.try_pop(b) && b.instrument_id == 1 && b.interval_ns == 1000 && b.trade_count == 4);
+    assert(bars.try_pop(b) && b.instrument_id == 2 && b.interval_ns == 1000);
+    assert(!bars.try_pop(b) && bars.bars_closed() == 5);
+
+    // out-of-range instrument: ignored, counted
+    bars.on_trade(trade(9, 1, 1), 2000);
+    assert(bars.trades_ignored() == 1);
+
+    // the clock stepping back does not reopen an earlier bar
+    BarAggregator wall(2, {100});
+    wall.on_trade(trade(1, 10, 1), 250);
+    wall.on_trade(trade(1, 11, 1), 190);
+    assert(!wall.try_pop(b) && wall.current(1, 0, b) && b.start_ns == 200 && b.trade_count == 2);
+
+    // full output ring: bars are dropped, never waited on
+    BarAggregator small(2, {10}, 2);
+    for (uint64_t ts = 0; ts < 100; ts += 10) {
+        small.on_trade(trade(1, 7, 1), ts);
+    }
+    assert(small.bars_closed() == 2 && small.bars_dropped() == 7);
+
+    std::cout << "bar_aggregator test passed\n";
+    return 0;
+}
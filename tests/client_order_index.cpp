@@ -0,0 +1,188 @@
+#include "clock.hpp"
+#include "engine.hpp"
+#include "flat_id_map.hpp"
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+struct Xorshift {
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    uint64_t next() {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x;
+    }
+};
+
+static OrderNewBody order(uint64_t cid, uint32_t instrument_id, uint8_t side, int64_t px, int32_t qty,
+                          uint8_t flags = 0) {
+    OrderNewBody o{};
+    o.client_order_id = cid;
+    o.instrument_id = instrument_id;
+    o.side = side;
+    o.price_ticks = px;
+    o.qty = qty;
+    o.flags = flags;
+    if (flags & TIF_GTT) {
+        o.expire_after_s = 1;
+    }
+    return o;
+}
+
+static OrderCancelBody cancel_cid(uint64_t cid, uint32_t instrument_id = 0) {
+    OrderCancelBody c{};
+    c.client_order_id = cid;
+    c.instrument_id = instrument_id;
+    return c;
+}
+
+int main() {
+    // --- FlatIdMap: basics, then a random mix checked against unordered_map
+    {
+        FlatIdMap<uint32_t> m;
+        assert(m.empty() && m.find(1) == nullptr && !m.erase(1));
+        assert(m.capacity() == 0 && m.memory_bytes() == 0); // no table until the first id
+        m.reserve(0);
+        assert(m.capacity() == 0);
+        assert(m.insert(7, 70) && !m.insert(7, 71) && *m.find(7) == 70 && m.size() == 1);
+        assert(m.find(0) == nullptr);
+        assert(m.erase(7) && m.find(7) == nullptr && m.empty());
+        m.reserve(1000);
+        const size_t cap = m.capacity();
+        assert(cap * 3 / 4 >= 1000);
+        for (uint64_t k = 1; k <= 1000; ++k) {
+            assert(m.insert(k << 32, uint32_t(k))); // ids differing only in high bits
+        }
+        assert(m.capacity() == cap && m.size() == 1000);
+        m.clear();
+        assert(m.empty() && m.find(1ull << 32) == nullptr);
+
+        FlatIdMap<uint64_t> flat;
+        std::unordered_map<uint64_t, uint64_t> ref;
+        Xorshift rng;
+        for (int i = 0; i < 400'000; ++i) {
+            // a small key space, so inserts collide with live keys and
+            // erases hit both present and absent ones
+            const uint64_t key = 1 + rng.next() % 20'000;
+            switch (rng.next() % 3) {
+            case 0:
+                assert(flat.insert(key, uint64_t(i)) == ref.emplace(key, uint64_t(i)).second);
+                break;
+            case 1:
+                assert(flat.erase(key) == (ref.erase(key) == 1));
+                break;
+            default: {
+                const uint64_t* v = flat.find(key);
+                const auto it = ref.find(key);
+                assert((v != nullptr) == (it != ref.end()));
+                assert(v == nullptr || *v == it->second);
+            }
+            }
+            assert(flat.size() == ref.size());
+        }
+        for (const auto& [k, v] : ref) {
+            assert(flat.find(k) != nullptr && *flat.find(k) == v);
+        }
+    }
+
+    // --- duplicate client order ids, per session
+    {
+        Engine engine;
+        assert(engine.on_new(order(1, 1, 0, 100, 10), true, 1).ack.status == 0);
+        assert(engine.on_new(order(1, 2, 1, 200, 10), true, 1).ack.status == 1); // live in session 1
+        assert(engine.on_new(order(1, 1, 0, 100, 10), true, 2).ack.status == 0); // other session
+        assert(engine.on_new(order(1, 1, 0, 100, 10), true).ack.status == 0);    // no session
+        assert(engine.on_new(order(0, 1, 0, 100, 10), true, 1).ack.status == 0); // 0 is never indexed
+        assert(engine.on_new(order(0, 1, 0, 100, 10), true, 1).ack.status == 0);
+        assert(engine.num_resting_orders() == 5);
+
+        // a duplicate is refused before it can trade
+        const EngineResult dup = engine.on_new(order(1, 1, 1, 100, 10), true, 1);
+        assert(dup.ack.status == 1 && dup.trades.empty() && engine.num_resting_orders() == 5);
+
+        // an IOC is never indexed, so its id is free again at once
+        assert(engine.on_new(order(9, 1, 1, 200, 1), false, 1).ack.status == 0);
+        assert(engine.on_new(order(9, 1, 1, 200, 1), false, 1).ack.status == 0);
+    }
+
+    // --- cancel by client order id alone
+    {
+        Engine engine;
+        engine.reserve_client_ids(3, 1000);
+        const uint64_t exch = engine.on_new(order(42, 2, 1, 150, 10), true, 3).ack.exch_order_id;
+        assert(engine.on_cancel(cancel_cid(42), 4).ack.status == 1);    // not that session's id
+        assert(engine.on_cancel(cancel_cid(43), 3).ack.status == 1);    // unknown id
+        assert(engine.on_cancel(cancel_cid(42, 1), 3).ack.status == 1); // wrong instrument
+        assert(engine.on_cancel(cancel_cid(42)).ack.status == 1);       // no session: needs an exch id
+        const EngineResult r = engine.on_cancel(cancel_cid(42, 2), 3);
+        assert(r.ack.status == 0 && r.ack.exch_order_id == exch && r.ack.client_order_id == 42);
+        assert(r.levels.size() == 1 && r.levels[0].instrument_id == 2 && r.levels[0].price_ticks == 150);
+        assert(engine.num_session_orders(3) == 0);
+        assert(engine.on_cancel(cancel_cid(42), 3).ack.status == 1); // gone
+        assert(engine.on_new(order(42, 2, 1, 150, 10), true, 3).ack.status == 0); // reusable
+
+        // cancelling by exchange id also frees the client id
+        const uint64_t exch2 = engine.on_new(order(50, 1, 0, 90, 5), true, 3).ack.exch_order_id;
+        OrderCancelBody c{};
+        c.client_order_id = 50;
+        c.instrument_id = 1;
+        c.exch_order_id = exch2;
+        assert(engine.on_cancel(c, 3).ack.status == 0);
+        assert(engine.on_new(order(50, 1, 0, 90, 5), true, 3).ack.status == 0);
+    }
+
+    // --- fills: a full fill frees the id, a partial fill keeps it
+    {
+        Engine engine;
+        assert(engine.on_new(order(1, 1, 1, 100, 10), true, 1).ack.status == 0);
+        assert(engine.on_new(order(2, 1, 1, 101, 10), true, 1).ack.status == 0);
+        // session 2 sweeps 100 entirely and half of 101
+        assert(engine.on_new(order(1, 1, 0, 101, 15), false, 2).trades.size() == 2);
+        assert(engine.on_cancel(cancel_cid(1), 1).ack.status == 1);
+        assert(engine.on_new(order(1, 1, 1, 105, 10), true, 1).ack.status == 0);
+        assert(engine.on_new(order(2, 1, 1, 105, 10), true, 1).ack.status == 1); // still live, 5 left
+        const EngineResult r = engine.on_cancel(cancel_cid(2), 1);
+        assert(r.ack.status == 0 && r.levels.size() == 1 && r.levels[0].total_qty == 0);
+
+        // a taker that fully fills on entry never rests, so is never indexed
+        assert(engine.on_new(order(7, 1, 0, 105, 10), true, 2).trades.size() == 1);
+        assert(engine.on_new(order(7, 1, 0, 99, 1), true, 2).ack.status == 0);
+    }
+
+    // --- bulk removals: mass cancel, cancel-on-disconnect, expiry
+    {
+        Engine engine;
+        for (uint64_t cid = 1; cid <= 100; ++cid) {
+            assert(engine.on_new(order(cid, 1 + uint32_t(cid % 3), uint8_t(cid & 1), 100 + int64_t(cid & 1) * 10, 1),
+                                 true, 1).ack.status == 0);
+        }
+        MassCancelBody mc{};
+        mc.instrument_id = 1;
+        mc.side = kBothSides;
+        const uint32_t n1 = engine.on_mass_cancel(mc, 1).ack.cancelled_count;
+        assert(n1 == 33);
+        assert(engine.on_new(order(3, 1, 0, 100, 1), true, 1).ack.status == 0); // was on instrument 1
+        assert(engine.on_new(order(1, 1, 0, 100, 1), true, 1).ack.status == 1); // on instrument 2, live
+
+        // every owner on every book at once (the book's whole-index sweep)
+        mc.instrument_id = kAllInstruments;
+        assert(engine.on_mass_cancel(mc, kAnyOwner).ack.cancelled_count == 68);
+        assert(engine.on_new(order(1, 1, 0, 100, 1), true, 1).ack.status == 0);
+
+        assert(engine.cancel_session(1).ack.cancelled_count == 1);
+        assert(engine.on_new(order(1, 1, 0, 100, 1), true, 1).ack.status == 0);
+
+        Engine timed;
+        assert(timed.on_new(order(5, 1, 0, 100, 1, TIF_GTT), true, 1).ack.status == 0);
+        assert(timed.on_new(order(5, 1, 0, 100, 1), true, 1).ack.status == 1);
+        assert(timed.expire(clk::now_ns() + 2'000'000'000).ack.cancelled_count == 1);
+        assert(timed.on_new(order(5, 1, 0, 100, 1), true, 1).ack.status == 0);
+        assert(timed.on_cancel(cancel_cid(5), 1).ack.status == 0);
+    }
+
+    std::cout << "client_order_index test passed\n";
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "clock.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static int64_t steady_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t off_steady(int64_t ns) {
+    return std::llabs(ns - steady_ns());
+}
+
+// Every thread sees its own stamps non-decreasing, across resyncs.
+static void check_monotonic(int64_t run_ns) {
+    const int64_t end = steady_ns() + run_ns;
+    uint64_t prev = clk::now_ns();
+    while (steady_ns() < end) {
+        for (int i = 0; i < 1000; ++i) {
+            const uint64_t t = clk::now_ns();
+            assert(t >= prev);
+            prev = t;
+        }
+    }
+}
+
+int main() {
+    const clk::Source src = clk::source();
+    std::cout << "clock: source=" << (src == clk::Source::Tsc ? "tsc" : "steady") << " hz=" << clk::tsc_hz() << "\n";
+    assert(src == clk::Source::Steady || clk::tsc_hz() > 1e8);
+
+    // --- steady_clock time base, across the first resyncs (10ms, 20ms, ...)
+    assert(off_steady(int64_t(clk::now_ns())) < 1'000'000);
+    check_monotonic(50'000'000);
+    assert(off_steady(int64_t(clk::now_ns())) < 100'000);
+
+    // --- concurrent readers while resyncs happen
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] { check_monotonic(100'000'000); });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    assert(off_steady(int64_t(clk::now_ns())) < 100'000);
+
+    // --- wall time conversion
+    using namespace std::chrono;
+    const int64_t wall = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+    assert(std::llabs(int64_t(clk::to_wall_ns(clk::now_ns())) - wall) < 1'000'000);
+
+    // --- forced fallback, then back
+    assert(clk::select(clk::Source::Steady) == clk::Source::Steady && clk::tsc_hz() == 0.0);
+    assert(off_steady(int64_t(clk::now_ns())) < 1'000'000);
+    check_monotonic(5'000'000);
+    assert(clk::select(clk::Source::Tsc) == src);
+    assert(off_steady(int64_t(clk::now_ns())) < 1'000'000);
+
+    std::cout << "clock test passed\n";
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include "consumer_book.hpp"
+#include "engine.hpp"
+#include "flow_gen.hpp"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+static LevelUpdateBody level(uint32_t instr, uint8_t side, int64_t px, int64_t qty, uint32_t count, LevelAction a) {
+    LevelUpdateBody u{};
+    u.instrument_id = instr;
+    u.side = side;
+    u.price_ticks = px;
+    u.total_qty = qty;
+    u.order_count = count;
+    u.action = static_cast<uint8_t>(a);
+    return u;
+}
+
+// Wire frame for a body, as the publisher sends it.
+template <typename BodyT>
+static std::vector<uint8_t> frame(MsgType type, const BodyT& body, uint64_t seqno) {
+    Header h = codec::make_header(type, sizeof(BodyT), seqno, 0);
+    return codec::pack(h, body);
+}
+
+static ConsumerBooks::Result feed(ConsumerBooks& books, const std::vector<uint8_t>& bytes) {
+    auto fv = codec::unpack_frame(bytes);
+    return books.on_frame(fv.hdr, fv.body);
+}
+
+int main() {
+    // --- single book: ordering, update, delete, top-N
+    ConsumerBook b;
+    b.apply(level(1, 0, 100, 10, 1, LevelAction::ADD));
+    b.apply(level(1, 0, 102, 20, 2, LevelAction::ADD));
+    b.apply(level(1, 0, 101, 30, 3, LevelAction::ADD));
+    b.apply(level(1, 1, 105, 5, 1, LevelAction::ADD));
+    b.apply(level(1, 1, 103, 6, 1, LevelAction::ADD));
+    assert(b.num_levels(0) == 3 && b.num_levels(1) == 2);
+
+    ConsumerLevel top[4];
+    assert(b.top(0, top) == 3);
+    assert(top[0].price_ticks == 102 && top[1].price_ticks == 101 && top[2].price_ticks == 100);
+    assert(top[1].total_qty == 30 && top[1].order_count == 3);
+    assert(b.top(1, std::span<ConsumerLevel>(top, 1)) == 1 && top[0].price_ticks == 103);
+
+    b.apply(level(1, 0, 102, 25, 3, LevelAction::UPDATE));
+    ConsumerLevel l;
+    assert(b.best(0, l) && l.price_ticks == 102 && l.total_qty == 25 && l.order_count == 3);
+    b.apply(level(1, 1, 103, 0, 0, LevelAction::DELETE));
+    assert(b.best(1, l) && l.price_ticks == 105);
+    assert(!b.level(1, 103, l) && b.level(0, 100, l) && l.total_qty == 10);
+    b.apply(level(1, 1, 999, 0, 0, LevelAction::DELETE)); // unknown level: no-op
+    assert(b.num_levels(1) == 1);
+
+    // deep book: lookups beyond the scanned top fall back to binary search
+    ConsumerBook deep;
+    for (int64_t px = 1; px <= 100; ++px) {
+        deep.apply(level(1, 1, px, px, 1, LevelAction::ADD));
+    }
+    for (int64_t px = 1; px <= 100; ++px) {
+        assert(deep.level(1, px, l) && l.total_qty == px);
+    }
+    deep.apply(level(1, 1, 50, 0, 0, LevelAction::DELETE));
+    assert(!deep.level(1, 50, l) && deep.num_levels(1) == 99);
+    assert(deep.best(1, l) && l.price_ticks == 1);
+
+    // --- feed: sequencing and routing by instrument
+    ConsumerBooks books;
+    using Result = ConsumerBooks::Result;
+    Result r = feed(books, frame(MsgType::BOOK_UPDATE, level(2, 0, 100, 10, 1, LevelAction::ADD), 1));
+    assert(r == Result::Applied);
+    TradeBody t{};
+    t.instrument_id = 2;
+    t.price_ticks = 100;
+    t.qty = 4;
+    r = feed(books, frame(MsgType::TRADE, t, 2));
+    assert(r == Result::Applied);
+    r = feed(books, frame(MsgType::BBO, BboBody{}, 3));
+    assert(r == Result::Skipped);
+    r = feed(books, frame(MsgType::TRADE, t, 2));
+    assert(r == Result::Duplicate);
+    // seqno 4 lost: 5 is refused until 4 arrives
+    const auto f5 = frame(MsgType::BOOK_UPDATE, level(2, 0, 100, 6, 1, LevelAction::UPDATE), 5);
+    r = feed(books, f5);
+    assert(r == Result::Gap);
+    assert(books.gaps() == 1 && books.next_seqno() == 4);
+    r = feed(books, frame(MsgType::BOOK_UPDATE, level(3, 1, 200, 1, 1, LevelAction::ADD), 4));
+    assert(r == Result::Applied);
+    r = feed(books, f5);
+    assert(r == Result::Applied);
+    (void)r;
+    const ConsumerBook* b2 = books.book(2);
+    assert(b2 && b2->best(0, l) && l.total_qty == 6);
+    assert(b2->num_trades() == 1 && b2->volume() == 4 && b2->last_trade_px() == 100);
+    assert(books.book(3) && books.book(3)->num_levels(1) == 1);
+    assert(books.book(9) == nullptr);
+    assert(books.book(1) == nullptr); // below a seen id, but nothing arrived for it
+    {
+        // a book held across frames for higher instrument ids stays put
+        const ConsumerBook* held = books.book(2);
+        for (uint32_t id = 10; id < 5000; id += 10) {
+            r = feed(books, frame(MsgType::BOOK_UPDATE, level(id, 0, 100, 1, 1, LevelAction::ADD), books.next_seqno()));
+            assert(r == Result::Applied);
+        }
+        assert(books.book(2) == held && held->num_trades() == 1);
+        (void)held;
+    }
+    books.reset();
+    assert(books.book(2) == nullptr && books.next_seqno() == 1);
+
+    // --- follows the engine: every level of every book matches after a generated flow
+    Engine engine;
+    ConsumerBooks mirror;
+    FlowGenConfig cfg;
+    cfg.num_instruments = 3;
+    FlowGenerator gen(cfg);
+    uint64_t seq = 0;
+    for (int i = 0; i < 20000; ++i) {
+        FlowEvent ev = gen.next();
+        EngineResult res = ev.type == MsgType::NEW ? engine.on_new(ev.new_order, (ev.new_order.flags & TIF_IOC) == 0)
+                                                   : engine.on_cancel(ev.cancel);
+        for (const TradeBody& tr : res.trades) {
+            const Result applied = feed(mirror, frame(MsgType::TRADE, tr, ++seq));
+            assert(applied == Result::Applied);
+            (void)applied;
+        }
+        for (const LevelUpdateBody& u : res.levels) {
+            const Result applied = feed(mirror, frame(MsgType::BOOK_UPDATE, u, ++seq));
+            assert(applied == Result::Applied);
+            (void)applied;
+        }
+    }
+    for (uint32_t instr = 1; instr <= 3; ++instr) {
+        BookSnapshot snap;
+        const bool ok = engine.snapshot(instr, seq, snap);
+        assert(ok);
+        (void)ok;
+        const ConsumerBook* cb = mirror.book(instr);
+        assert(cb);
+        if (!cb) {
+            return 1;
+        }
+        assert(cb->num_levels(0) + cb->num_levels(1) == snap.levels.size());
+        std::vector<ConsumerLevel> bids(cb->num_levels(0)), asks(cb->num_levels(1));
+        cb->top(0, bids);
+        cb->top(1, asks);
+        size_t k = 0;
+        for (const ConsumerLevel& c : bids) {
+            const LevelUpdateBody& s = snap.levels[k++];
+            assert(s.side == 0 && s.price_ticks == c.price_ticks && s.total_qty == c.total_qty &&
+                   s.order_count == c.order_count);
+        }
+        for (const ConsumerLevel& c : asks) {
+            const LevelUpdateBody& s = snap.levels[k++];
+            assert(s.side == 1 && s.price_ticks == c.price_ticks && s.total_qty == c.total_qty);
+        }
+
+        // a snapshot load gives the same book
+        ConsumerBook fresh;
+        fresh.load(snap);
+        ConsumerLevel a, c;
+        assert(fresh.num_levels(0) == cb->num_levels(0));
+        assert(!fresh.best(0, a) || (cb->best(0, c) && a.price_ticks == c.price_ticks && a.total_qty == c.total_qty));
+    }
+
+    std::cout << "consumer_book test passed\n";
+    return 0;
+}
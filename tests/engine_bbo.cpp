@@ -0,0 +1,78 @@
+#include "engine.hpp"
+#include <cassert>
+#include <iostream>
+
+static OrderNewBody make_new(uint64_t cid, uint32_t instr, OrderSide side, int64_t px, int32_t qty) {
+    OrderNewBody o{};
+    o.client_order_id = cid;
+    o.price_ticks = px;
+    o.qty = qty;
+    o.instrument_id = instr;
+    o.side = static_cast<uint8_t>(side);
+    return o;
+}
+
+int main() {
+    Engine eng;
+    std::vector<BboBody> out;
+
+    // --- 1) Nothing happened: nothing to publish
+    eng.flush_bbo(out);
+    assert(out.empty());
+
+    // --- 2) Several changes to two instruments in one batch: one BBO each
+    eng.on_new(make_new(1, 1, OrderSide::Bid, 100, 10), true);
+    eng.on_new(make_new(2, 1, OrderSide::Bid, 100, 5), true);
+    eng.on_new(make_new(3, 1, OrderSide::Ask, 105, 7), true);
+    eng.on_new(make_new(4, 2, OrderSide::Ask, 50, 3), true);
+    eng.flush_bbo(out);
+    assert(out.size() == 2);
+    assert(out[0].instrument_id == 1);
+    assert(out[0].bid_price_ticks == 100 && out[0].bid_total_qty == 15 && out[0].bid_order_count == 2);
+    assert(out[0].ask_price_ticks == 105 && out[0].ask_total_qty == 7 && out[0].ask_order_count == 1);
+    assert(out[1].instrument_id == 2);
+    assert(out[1].bid_order_count == 0 && out[1].bid_total_qty == 0);
+    assert(out[1].ask_price_ticks == 50 && out[1].ask_total_qty == 3);
+
+    // --- 3) A level behind the best doesn't move the quote
+    out.clear();
+    eng.on_new(make_new(5, 1, OrderSide::Bid, 98, 10), true);
+    eng.on_new(make_new(6, 1, OrderSide::Ask, 110, 10), true);
+    eng.flush_bbo(out);
+    assert(out.empty());
+
+    // --- 4) Many fills inside a batch still give a single update
+    EngineResult sweep = eng.on_new(make_new(7, 1, OrderSide::Ask, 100, 12), true);
+    assert(sweep.trades.size() == 2);
+    EngineResult hit = eng.on_new(make_new(8, 1, OrderSide::Ask, 98, 1), true);
+    assert(hit.trades.size() == 1);
+    eng.flush_bbo(out);
+    assert(out.size() == 1);
+    assert(out[0].bid_price_ticks == 100 && out[0].bid_total_qty == 2 && out[0].bid_order_count == 1);
+
+    // --- 5) Add then cancel at the top within a batch: quote unchanged, nothing sent
+    out.clear();
+    EngineResult add = eng.on_new(make_new(9, 1, OrderSide::Bid, 101, 4), true);
+    OrderCancelBody c{};
+    c.client_order_id = 10;
+    c.exch_order_id = add.ack.exch_order_id;
+    c.instrument_id = 1;
+    EngineResult cancel = eng.on_cancel(c);
+    assert(cancel.ack.status == 0);
+    eng.flush_bbo(out);
+    assert(out.empty());
+
+    // --- 6) Cancel of the best level moves the quote to the next one
+    OrderCancelBody c2{};
+    c2.client_order_id = 11;
+    c2.exch_order_id = 3; // ask 105
+    c2.instrument_id = 1;
+    EngineResult cancel2 = eng.on_cancel(c2);
+    assert(cancel2.ack.status == 0);
+    eng.flush_bbo(out);
+    assert(out.size() == 1);
+    assert(out[0].ask_price_ticks == 110 && out[0].ask_total_qty == 10);
+
+    std::cout << "engine_bbo test passed\n";
+    return 0;
+}
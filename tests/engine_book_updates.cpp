@@ -0,0 +1,74 @@
+#include "engine.hpp"
+#include <cassert>
+#include <iostream>
+
+static OrderNewBody make_new(uint64_t cid, OrderSide side, int64_t px, int32_t qty) {
+    OrderNewBody o{};
+    o.client_order_id = cid;
+    o.price_ticks = px;
+    o.qty = qty;
+    o.instrument_id = 1;
+    o.side = static_cast<uint8_t>(side);
+    return o;
+}
+
+int main() {
+    Engine eng;
+
+    // --- 1) First order at a price creates the level, second one updates it
+    EngineResult r1 = eng.on_new(make_new(1, OrderSide::Ask, 101, 30), /*rest_leftover=*/true);
+    assert(r1.levels.size() == 1);
+    assert(r1.levels[0].action == static_cast<uint8_t>(LevelAction::ADD));
+    assert(r1.levels[0].side == static_cast<uint8_t>(OrderSide::Ask));
+    assert(r1.levels[0].price_ticks == 101);
+    assert(r1.levels[0].total_qty == 30);
+    assert(r1.levels[0].order_count == 1);
+    assert(r1.levels[0].instrument_id == 1);
+
+    EngineResult r2 = eng.on_new(make_new(2, OrderSide::Ask, 101, 20), true);
+    assert(r2.levels.size() == 1);
+    assert(r2.levels[0].action == static_cast<uint8_t>(LevelAction::UPDATE));
+    assert(r2.levels[0].total_qty == 50);
+    assert(r2.levels[0].order_count == 2);
+
+    EngineResult r3 = eng.on_new(make_new(3, OrderSide::Ask, 102, 40), true);
+    assert(r3.levels.size() == 1);
+    assert(r3.levels[0].action == static_cast<uint8_t>(LevelAction::ADD));
+
+    // --- 2) Taker sweeps 101 and part of 102, remainder rests on the bid side
+    // one update per touched maker level, then the new bid level
+    EngineResult r4 = eng.on_new(make_new(4, OrderSide::Bid, 102, 100), true);
+    assert(r4.trades.size() == 3);
+    assert(r4.levels.size() == 3);
+    assert(r4.levels[0].price_ticks == 101);
+    assert(r4.levels[0].action == static_cast<uint8_t>(LevelAction::DELETE));
+    assert(r4.levels[0].total_qty == 0 && r4.levels[0].order_count == 0);
+    assert(r4.levels[1].price_ticks == 102);
+    assert(r4.levels[1].action == static_cast<uint8_t>(LevelAction::DELETE));
+    assert(r4.levels[2].side == static_cast<uint8_t>(OrderSide::Bid));
+    assert(r4.levels[2].action == static_cast<uint8_t>(LevelAction::ADD));
+    assert(r4.levels[2].total_qty == 10);
+
+    // --- 3) Cancel reports the level it left
+    EngineResult r5 = eng.on_new(make_new(5, OrderSide::Bid, 102, 5), true);
+    assert(r5.levels.size() == 1 && r5.levels[0].total_qty == 15);
+
+    OrderCancelBody c{};
+    c.client_order_id = 6;
+    c.exch_order_id = r4.ack.exch_order_id;
+    c.instrument_id = 1;
+    EngineResult r6 = eng.on_cancel(c);
+    assert(r6.ack.status == 0);
+    assert(r6.levels.size() == 1);
+    assert(r6.levels[0].action == static_cast<uint8_t>(LevelAction::UPDATE));
+    assert(r6.levels[0].total_qty == 5);
+    assert(r6.levels[0].order_count == 1);
+
+    // failed cancel publishes nothing
+    EngineResult r7 = eng.on_cancel(c);
+    assert(r7.ack.status == 1);
+    assert(r7.levels.empty());
+
+    std::cout << "engine_book_updates test passed\n";
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "engine.hpp"
+#include "instrument_universe.hpp"
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+static bool parse(const std::string& text, std::vector<InstrumentSpec>& out) {
+    std::istringstream in(text);
+    return parse_universe(in, "test", out);
+}
+
+int main() {
+    // --- file format
+    std::vector<InstrumentSpec> universe;
+    assert(parse("# symbol orders lo hi tick\n"
+                 "AAPL 5000 15000 25000 0.01\n"
+                 "\n"
+                 "ESZ6   200  400000 600000 0.25   # futures\n"
+                 "TINY 0 1 10 0.0001\n",
+                 universe));
+    assert(universe.size() == 3);
+    assert(universe[1].symbol == "ESZ6" && universe[1].expected_orders == 200);
+    assert(universe[1].band_lo_ticks == 400000 && universe[1].band_hi_ticks == 600000);
+    assert(universe[1].tick_size == 0.25);
+
+    std::vector<InstrumentSpec> bad;
+    assert(!parse("AAPL 10 1 2\n", bad));                    // missing field
+    assert(!parse("AAPL 10 1 2 0.01 extra\n", bad));         // trailing field
+    assert(!parse("AAPL 10 5 2 0.01\n", bad));               // inverted band
+    assert(!parse("AAPL 10 1 2 0\n", bad));                  // zero tick
+    assert(!parse("AAPL -1 1 2 0.01\n", bad));               // negative orders, not wrapped
+    assert(!parse("AAPL 4294967296 1 2 0.01\n", bad));       // past uint32
+    assert(!parse("AAPL 100000001 1 2 0.01\n", bad));        // past kMaxExpectedOrders
+    bad.clear();
+    assert(!parse("AAPL 10 1 2 0.01\nAAPL 10 1 2 0.01\n", bad)); // duplicate
+    std::vector<InstrumentSpec> largest;
+    assert(parse("AAPL 100000000 1 2 0.01\n", largest) && largest[0].expected_orders == kMaxExpectedOrders);
+
+    // --- engine listing: ids follow the file, symbols resolve both ways
+    Engine engine(universe);
+    assert(engine.num_instruments() == 3);
+    assert(engine.instrument_id("AAPL") == 1 && engine.instrument_id("TINY") == 3);
+    assert(engine.instrument_id("MSFT") == 0); // not in the universe
+    assert(engine.instrument(2) && engine.instrument(2)->symbol == "ESZ6");
+    assert(engine.instrument(0) == nullptr && engine.instrument(4) == nullptr);
+    assert(engine.add_new_instrument("ESZ6") == 0);
+    assert(engine.add_new_instrument("NEW") == 4 && engine.instrument_id("NEW") == 4);
+
+    // books are presized: the hinted ones hold an index before any order arrives
+    const BookMemory presized = engine.memory_usage();
+    Engine lazy;
+    assert(presized.index.bytes > lazy.memory_usage().index.bytes);
+    assert(presized.index.bytes >= int64_t((5000 + 200) * sizeof(void*)));
+    assert(engine.instrument_id("AAPL") == 1 && lazy.instrument_id("AAPL") == 1);
+
+    // and trade like any other
+    OrderNewBody o{};
+    o.client_order_id = 1;
+    o.instrument_id = engine.instrument_id("ESZ6");
+    o.side = 0;
+    o.price_ticks = 500000;
+    o.qty = 3;
+    EngineResult r = engine.on_new(o, true);
+    assert(r.ack.status == 0 && r.levels.size() == 1);
+    int64_t px = 0;
+    int32_t qty = 0;
+    assert(engine.best_bid(2, px, qty) && px == 500000 && qty == 3);
+    // the reserved index is not charged again by the first orders
+    assert(engine.memory_usage().index.bytes - presized.index.bytes < 256);
+
+    std::cout << "instrument_universe test passed\n";
+    return 0;
+}
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# Short open-loop run against a quiet server: every message must be answered
+# and the report must be well-formed.
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+SOCK = "/tmp/demo.sock"
+
+def wait_for_socket(path: str, timeout_s: float = 5.0) -> bool:
+    t0 = time.time()
+    while time.time() - t0 < timeout_s:
+        if os.path.exists(path):
+            return True
+        time.sleep(0.05)
+    return False
+
+def main() -> int:
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--server", required=True)
+    ap.add_argument("--loadgen", required=True)
+    args = ap.parse_args()
+
+    try:
+        os.unlink(SOCK)
+    except FileNotFoundError:
+        pass
+
+    srv = subprocess.Popen([args.server, "--quiet"], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    if not wait_for_socket(SOCK):
+        srv.kill()
+        print("[FAIL] server did not create socket in time")
+        return 1
+
+    lg = subprocess.run([args.loadgen, "--rate", "20000", "--count", "5000", "--instruments", "1:3,2:1",
+                         "--cancel-ratio", "0.3", "--aggressive", "0.2", "--json"],
+                        capture_output=True, text=True, timeout=20)
+    try:
+        srv.wait(timeout=5)
+    except subprocess.TimeoutExpired:
+        srv.kill()
+        srv.wait()
+
+    if lg.returncode != 0:
+        print(f"[FAIL] loadgen exited with {lg.returncode}\n{lg.stdout}{lg.stderr}")
+        return 1
+    report = json.loads(lg.stdout.strip().splitlines()[-1])
+    print(report)
+    ok = report["sent"] == 5000 and report["acked"] == 5000 and report["lost"] == 0
+    rtt = report["rtt_ns"]
+    ok = ok and 0 < rtt["p50"] <= rtt["p99"] <= rtt["p999"] <= rtt["max"]
+    # intended-time RTT can only be longer than actual-send RTT
+    ok = ok and rtt["p50"] >= report["rtt_uncorrected_ns"]["p50"]
+    # the wire-in / engine / wire-out split covers every ACK's round trip
+    parts = report["breakdown_ns"]
+    ok = ok and all(0 < parts[k]["p50"] <= parts[k]["max"] for k in ("wire_in", "engine", "wire_out"))
+    ok = ok and parts["engine"]["p50"] <= report["rtt_uncorrected_ns"]["p50"]
+    if not ok:
+        print("[FAIL] unexpected loadgen report")
+        return 1
+    print("[OK] loadgen answered in full")
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
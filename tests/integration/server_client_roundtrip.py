@@ -11,6 +11,10 @@ PASS_MARKERS = [
     "client: connected to server",
     "NEW ACK:",
     "CANCEL ACK:",
+    "MASS_CANCEL ACK: cid=200 status=0 (ACCEPTED) cancelled=2",
+    "STATS: request=300 msgs_new=3 msgs_cancel=1 msgs_mass_cancel=1 msgs_stats_request=1",
+    "LATENCY: new_total n=3",
+    "LATENCY: mass_cancel_total n=1",
     "client: workflow completed successfully",
 ]
 
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# A session that never reads must not hold up order entry for the others:
+# its top-of-book updates get conflated while a fast session keeps trading.
+import argparse
+import os
+import re
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+SOCK = "/tmp/demo.sock"
+HDR = struct.Struct("<BBHxxxxQQ")          # Header (24 bytes)
+NEW = struct.Struct("<QqiIBBHxxxx")        # OrderNewBody (32 bytes)
+ACK_FRAME = 64                             # Header + AckBody
+MSG_NEW, MSG_ACK = 1, 3
+ORDERS = 3000
+
+def wait_for_socket(path: str, timeout_s: float = 5.0) -> bool:
+    t0 = time.time()
+    while time.time() - t0 < timeout_s:
+        if os.path.exists(path):
+            return True
+        time.sleep(0.05)
+    return False
+
+def recv_exact(s: socket.socket, n: int) -> bytes:
+    buf = b""
+    while len(buf) < n:
+        chunk = s.recv(n - len(buf))
+        if not chunk:
+            raise ConnectionError("server closed the session")
+        buf += chunk
+    return buf
+
+def main() -> int:
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--server", required=True)
+    args = ap.parse_args()
+
+    try:
+        os.unlink(SOCK)
+    except FileNotFoundError:
+        pass
+
+    # server logs every message; send them to a file so a full pipe can't stall it
+    log = tempfile.TemporaryFile(mode="w+")
+    srv = subprocess.Popen([args.server, "--session-bbo", "--out-watermark", "1024"],
+                           stdout=log, stderr=subprocess.STDOUT, text=True)
+    if not wait_for_socket(SOCK):
+        srv.kill()
+        print("[FAIL] server did not create socket in time")
+        return 1
+
+    slow = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    slow.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4096)
+    slow.connect(SOCK)
+
+    fast = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    fast.connect(SOCK)
+    fast.settimeout(5.0)
+
+    ok = True
+    t0 = time.time()
+    acks = 0
+    try:
+        for i in range(ORDERS):
+            side = i % 2
+            px = 100 + (i % 7) if side == 0 else 103 + (i % 5)
+            body = NEW.pack(i + 1, px, 10, 1, side, 0, 0)
+            fast.sendall(HDR.pack(MSG_NEW, 1, HDR.size + NEW.size, i, 0) + body)
+            # the fast session also gets top-of-book; skip until the ACK
+            while True:
+                hdr = HDR.unpack(recv_exact(fast, HDR.size))
+                recv_exact(fast, hdr[2] - HDR.size)
+                if hdr[0] == MSG_ACK:
+                    acks += 1
+                    break
+    except (ConnectionError, socket.timeout) as e:
+        print(f"[FAIL] fast session stalled after {acks} ACKs: {e}")
+        ok = False
+    elapsed = time.time() - t0
+
+    fast.close()
+    slow.close()
+    try:
+        srv.wait(timeout=5)
+    except subprocess.TimeoutExpired:
+        srv.kill()
+        srv.wait()
+    log.seek(0)
+    out = log.read()
+
+    m = re.search(r"conflated=(\d+)", out)
+    conflated = int(m.group(1)) if m else 0
+    print(f"fast session: {acks}/{ORDERS} ACKs in {elapsed:.2f}s, conflated={conflated}")
+    if acks != ORDERS:
+        ok = False
+    if conflated == 0:
+        print("[FAIL] expected the slow session's top-of-book updates to be conflated")
+        print("--- server output (tail) ---\n" + "\n".join(out.splitlines()[-10:]))
+        ok = False
+
+    if not ok:
+        return 1
+    print("[OK] slow consumer did not stall order entry")
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,59 @@
+#include "latency_histogram.hpp"
+#include <cassert>
+#include <iostream>
+
+int main() {
+    // --- 1) Bucket boundaries are contiguous and round-trip
+    const uint64_t probes[] = {0, 1, 255, 256, 257, 1000, 123'456'789, UINT64_MAX};
+    for (uint64_t v : probes) {
+        const size_t idx = LatencyHistogram::index_of(v);
+        assert(idx < LatencyHistogram::kBuckets);
+        assert(LatencyHistogram::lowest_equivalent(idx) <= v);
+        assert(LatencyHistogram::highest_equivalent(idx) >= v);
+    }
+    for (size_t i = 1; i < LatencyHistogram::kBuckets; ++i) {
+        assert(LatencyHistogram::lowest_equivalent(i) == LatencyHistogram::highest_equivalent(i - 1) + 1);
+    }
+
+    // --- 2) Small values are exact
+    LatencyHistogram h;
+    assert(h.count() == 0 && h.percentile(50) == 0 && h.min() == 0);
+    for (uint64_t v = 1; v <= 100; ++v) {
+        h.record(v);
+    }
+    assert(h.count() == 100);
+    assert(h.min() == 1 && h.max() == 100);
+    assert(h.percentile(50) == 50);
+    assert(h.percentile(99) == 99);
+    assert(h.percentile(100) == 100);
+    assert(h.mean() == 50.5);
+
+    // --- 3) Large values stay within the advertised relative error
+    LatencyHistogram big;
+    for (uint64_t i = 1; i <= 10'000; ++i) {
+        big.record(i * 1000); // 1us .. 10ms
+    }
+    const uint64_t p50 = big.percentile(50);
+    const uint64_t p999 = big.percentile(99.9);
+    assert(p50 >= 5'000'000 && p50 <= 5'000'000 + 5'000'000 / 128);
+    assert(p999 >= 9'990'000 && p999 <= 9'990'000 + 9'990'000 / 128);
+    assert(big.percentile(100) == 10'000'000); // clamped to the exact max
+
+    // --- 4) One outlier owns the tail
+    LatencyHistogram tail;
+    tail.record_n(1000, 999);
+    tail.record(1'000'000);
+    assert(tail.percentile(99) <= 1000 + 1000 / 128);
+    assert(tail.percentile(99.95) == 1'000'000);
+
+    // --- 5) merge() is the same as recording into one histogram
+    LatencyHistogram a, b;
+    a.record(10);
+    b.record(5000);
+    a.merge(b);
+    assert(a.count() == 2 && a.min() == 10 && a.max() == 5000);
+    assert(a.percentile(50) == 10);
+
+    std::cout << "latency_histogram test passed\n";
+    return 0;
+}
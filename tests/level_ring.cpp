@@ -0,0 +1,178 @@
+#include "level_ring.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+struct Xorshift {
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    uint64_t next() {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x;
+    }
+};
+
+struct Maker {
+    uint64_t id;
+    int32_t qty;
+};
+
+// The list layout's sweep, as OrderBook::match_taker walks a level.
+static int32_t list_sweep(std::list<Maker>& level, int32_t qty, const TradeBody& proto, std::vector<TradeBody>& out) {
+    int32_t filled = 0;
+    while (qty > 0 && !level.empty()) {
+        Maker& m = level.front();
+        const int32_t q = std::min(qty, m.qty);
+        TradeBody t = proto;
+        t.qty = q;
+        t.resting_exch_order_id = m.id;
+        out.push_back(t);
+        qty -= q;
+        m.qty -= q;
+        filled += q;
+        if (m.qty == 0) {
+            level.pop_front();
+        }
+    }
+    return filled;
+}
+
+static bool same_trades(const std::vector<TradeBody>& a, const std::vector<TradeBody>& b) {
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(TradeBody)) == 0);
+}
+
+int main() {
+    TradeBody proto{};
+    proto.price_ticks = 100;
+    proto.taking_exch_order_id = 999;
+    proto.instrument_id = 1;
+    proto.liquidity_flag = 1;
+
+    // --- prefix: SIMD and scalar agree, at every budget and length
+    {
+        Xorshift rng;
+        std::vector<int32_t> q(203);
+        for (int32_t& v : q) {
+            v = rng.next() % 4 == 0 ? 0 : int32_t(rng.next() % 1000);
+        }
+        q[50] = INT32_MAX; // sums must not wrap
+        q[51] = INT32_MAX;
+        for (size_t n : {size_t(0), size_t(7), size_t(8), size_t(64), size_t(203)}) {
+            for (int64_t budget : {int64_t(0), int64_t(1), int64_t(999), int64_t(25'000), int64_t(INT32_MAX),
+                                   int64_t(1) << 40}) {
+                int64_t s1 = 3, s2 = 3;
+                assert(level_ring::consumed_prefix(q.data(), n, budget, s1) ==
+                       level_ring::consumed_prefix_scalar(q.data(), n, budget, s2));
+                assert(s1 == s2);
+            }
+        }
+    }
+
+    // --- basics: FIFO, partial fill, handles, holes
+    {
+        LevelRing r;
+        std::vector<TradeBody> out;
+        assert(r.empty() && r.sweep(10, proto, out).filled == 0 && out.empty());
+        const uint64_t h1 = r.push_back(1, 5);
+        const uint64_t h2 = r.push_back(2, 7);
+        const uint64_t h3 = r.push_back(3, 4);
+        assert(r.size() == 3 && r.total_qty() == 16 && r.qty(h2) == 7);
+        assert(r.cancel(h2) == 7 && r.cancel(h2) == 0 && r.size() == 2 && r.total_qty() == 9);
+        const LevelRing::Sweep s = r.sweep(6, proto, out);
+        assert(s.filled == 6 && s.removed == 1 && out.size() == 2);
+        assert(out[0].resting_exch_order_id == 1 && out[0].qty == 5);
+        assert(out[1].resting_exch_order_id == 3 && out[1].qty == 1);
+        assert(r.qty(h1) == 0 && r.qty(h3) == 3 && r.front_id() == 3 && r.front_qty() == 3);
+        out.clear();
+        assert(r.sweep(10, proto, out).filled == 3 && r.empty() && r.total_qty() == 0);
+        // a taker that exactly clears the level leaves it empty
+        r.push_back(4, 2);
+        r.push_back(5, 2);
+        out.clear();
+        const LevelRing::Sweep e = r.sweep(4, proto, out);
+        assert(e.filled == 4 && e.removed == 2 && r.empty());
+    }
+
+    // --- random push / cancel / sweep against the list layout, with
+    // wrap-around, growth and compactions; handles followed through on_move
+    {
+        Xorshift rng;
+        LevelRing ring;
+        std::list<Maker> list;
+        std::unordered_map<uint64_t, std::list<Maker>::iterator> in_list;
+        std::unordered_map<uint64_t, uint64_t> handle; // id -> ring handle
+        std::vector<uint64_t> live;                    // ids, any order
+        std::unordered_map<uint64_t, size_t> in_live;  // id -> index in live
+        auto forget = [&](uint64_t id) {
+            const size_t i = in_live[id];
+            live[i] = live.back();
+            in_live[live[i]] = i;
+            live.pop_back();
+            in_live.erase(id);
+            in_list.erase(id);
+            handle.erase(id);
+        };
+        uint64_t next_id = 1;
+        size_t compacted = 0;
+        size_t max_size = 0;
+        for (int step = 0; step < 300'000; ++step) {
+            // the level builds up to thousands of orders, is mostly
+            // cancelled from the middle (holes outnumber the live orders and
+            // get compacted), then drains
+            const bool build = step < 150'000;
+            const bool thin = !build && step < 170'000;
+            const uint64_t op = rng.next() % 10;
+            if (op < (build ? 6u : thin ? 1u : 4u) || live.empty()) {
+                const int32_t q = 1 + int32_t(rng.next() % 20);
+                handle[next_id] = ring.push_back(next_id, q);
+                in_list[next_id] = list.insert(list.end(), Maker{next_id, q});
+                in_live[next_id] = live.size();
+                live.push_back(next_id++);
+            } else if (op < (build || thin ? 9u : 7u) || thin) {
+                const uint64_t id = live[rng.next() % live.size()];
+                const int32_t want = in_list[id]->qty;
+                list.erase(in_list[id]);
+                const int32_t got = ring.cancel(handle[id], [&](uint64_t moved, uint64_t h) {
+                    handle[moved] = h;
+                    ++compacted;
+                });
+                assert(got == want && got > 0);
+                forget(id);
+            } else {
+                const int32_t q = 1 + int32_t(rng.next() % (build ? 30 : 200));
+                std::vector<TradeBody> a, b;
+                const int32_t want = list_sweep(list, q, proto, a);
+                const LevelRing::Sweep got = ring.sweep(q, proto, b);
+                assert(got.filled == want && same_trades(a, b));
+                for (uint32_t k = 0; k < got.removed; ++k) {
+                    forget(b[k].resting_exch_order_id);
+                }
+            }
+            assert(ring.size() == list.size());
+            max_size = std::max<size_t>(max_size, ring.size());
+            if (step % 1000 == 0) {
+                int64_t total = 0;
+                auto it = list.begin();
+                ring.for_each([&](uint64_t id, int32_t q, uint64_t h) {
+                    assert(it != list.end() && it->id == id && it->qty == q && handle[id] == h && ring.qty(h) == q);
+                    total += q;
+                    ++it;
+                });
+                assert(it == list.end() && total == ring.total_qty());
+            }
+        }
+        assert(compacted > 0 && max_size > 1000);
+        // holes never outnumber the live orders, so the ring (a power of
+        // two) stays within 4x the largest the level has been
+        assert(ring.capacity() <= 4 * max_size);
+    }
+
+    std::cout << "level_ring test passed\n";
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "engine.hpp"
+#include "order_book.hpp"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+static OrderNewBody order(uint64_t cid, uint32_t instr, uint8_t side, int64_t px, int32_t qty) {
+    OrderNewBody o{};
+    o.client_order_id = cid;
+    o.instrument_id = instr;
+    o.side = side;
+    o.price_ticks = px;
+    o.qty = qty;
+    return o;
+}
+
+static MassCancelBody mass(uint64_t cid, uint32_t instr, uint8_t side) {
+    MassCancelBody m{};
+    m.client_order_id = cid;
+    m.instrument_id = instr;
+    m.side = side;
+    return m;
+}
+
+int main() {
+    // --- book: owner filter leaves other owners' orders, updates their levels
+    OrderBook ob;
+    assert(ob.add_resting(1, OrderSide::Bid, 100, 10, 7));
+    assert(ob.add_resting(2, OrderSide::Bid, 100, 20, 8));
+    assert(ob.add_resting(3, OrderSide::Bid, 99, 5, 7));
+    assert(ob.add_resting(4, OrderSide::Ask, 101, 5, 7));
+    assert(ob.add_resting(5, OrderSide::Ask, 102, 6, 8));
+    ob.clear_top_dirty();
+
+    std::vector<LevelUpdateBody> out;
+    assert(ob.mass_cancel(kBothSides, 7, out, 1) == 3);
+    assert(out.size() == 3);
+    // bids best-first: 100 keeps owner 8's order, 99 goes; then asks
+    assert(out[0].side == 0 && out[0].price_ticks == 100 && out[0].action == uint8_t(LevelAction::UPDATE));
+    assert(out[0].total_qty == 20 && out[0].order_count == 1);
+    assert(out[1].price_ticks == 99 && out[1].action == uint8_t(LevelAction::DELETE) && out[1].total_qty == 0);
+    assert(out[2].side == 1 && out[2].price_ticks == 101 && out[2].action == uint8_t(LevelAction::DELETE));
+    assert(ob.num_orders() == 2 && ob.top_dirty());
+    assert(!ob.cancel_order(1) && ob.cancel_order(2));
+    assert(ob.add_resting(2, OrderSide::Bid, 100, 20, 8)); // id reusable once gone
+
+    // nothing of that owner left: no updates, top untouched
+    ob.clear_top_dirty();
+    out.clear();
+    assert(ob.mass_cancel(kBothSides, 7, out, 1) == 0 && out.empty() && !ob.top_dirty());
+
+    // --- book: no owner filter drops whole levels, one side at a time
+    for (uint64_t id = 10; id < 20; ++id) {
+        assert(ob.add_resting(id, OrderSide::Ask, 110 + int64_t(id % 3), 1, uint32_t(id)));
+    }
+    out.clear();
+    assert(ob.mass_cancel(uint8_t(OrderSide::Ask), kAnyOwner, out, 1) == 11);
+    assert(out.size() == 4 && out[0].price_ticks == 102 && out[3].price_ticks == 112);
+    assert(ob.empty_ask() && !ob.empty_bid() && ob.num_orders() == 1);
+    assert(!ob.cancel_order(15));
+    out.clear();
+    assert(ob.mass_cancel(kBothSides, kAnyOwner, out, 1) == 1 && ob.num_orders() == 0 && ob.empty_bid());
+    assert(ob.memory().orders.bytes == 0 && ob.memory().levels.bytes == 0);
+
+    // --- engine: only the session's orders, instruments in id order, one ACK
+    Engine engine;
+    assert(engine.on_new(order(1, 1, 0, 100, 10), true, 1).ack.status == 0);
+    assert(engine.on_new(order(2, 2, 1, 200, 10), true, 1).ack.status == 0);
+    assert(engine.on_new(order(3, 3, 0, 300, 10), true, 1).ack.status == 0);
+    assert(engine.on_new(order(4, 1, 0, 100, 5), true, 2).ack.status == 0);
+    std::vector<BboBody> bbos;
+    engine.flush_bbo(bbos);
+
+    EngineResult r = engine.on_mass_cancel(mass(9, kAllInstruments, kBothSides), 1);
+    assert(r.ack.status == 0 && r.ack.client_order_id == 9 && r.ack.cancelled_count == 3);
+    assert(r.trades.empty() && r.levels.size() == 3);
+    assert(r.levels[0].instrument_id == 1 && r.levels[0].action == uint8_t(LevelAction::UPDATE));
+    assert(r.levels[1].instrument_id == 2 && r.levels[2].instrument_id == 3);
+    assert(engine.num_resting_orders() == 1);
+    bbos.clear();
+    engine.flush_bbo(bbos);
+    assert(bbos.size() == 3);
+
+    // a side filter, then the other session's order
+    assert(engine.on_mass_cancel(mass(10, 1, uint8_t(OrderSide::Ask)), 2).ack.cancelled_count == 0);
+    r = engine.on_mass_cancel(mass(11, 1, uint8_t(OrderSide::Bid)), 2);
+    assert(r.ack.cancelled_count == 1 && engine.num_resting_orders() == 0);
+
+    // rejects
+    assert(engine.on_mass_cancel(mass(12, 9, kBothSides), 1).ack.status == 1);
+    assert(engine.on_mass_cancel(mass(13, 1, 3), 1).ack.status == 1);
+    assert(engine.on_mass_cancel(mass(14, 1, kBothSides), 1).ack.status == 0);
+
+    std::cout << "mass_cancel test passed\n";
+    return 0;
+}
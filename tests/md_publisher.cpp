@@ -0,0 +1,204 @@
+#include "engine.hpp"
+#include "md_publisher.hpp"
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool read_exact(int fd, void* buf, size_t n) {
+    uint8_t* p = static_cast<uint8_t*>(buf);
+    size_t done = 0;
+    while (done < n) {
+        ssize_t r = ::read(fd, p + done, n - done);
+        if (r <= 0) {
+            return false;
+        }
+        done += size_t(r);
+    }
+    return true;
+}
+
+// Sends one RETRANS_REQUEST and collects the seqnos of the frames that come back.
+static RetransResponseBody request(int fd, uint64_t begin, uint32_t count, std::vector<TradeBody>& out) {
+    RetransRequestBody req{};
+    req.begin_seqno = begin;
+    req.count = count;
+    Header h = codec::make_header(MsgType::RETRANS_REQUEST, sizeof(req), 0, 0);
+    auto bytes = codec::pack(h, req);
+    bool sent = ::write(fd, bytes.data(), bytes.size()) == ssize_t(bytes.size());
+    assert(sent);
+
+    uint8_t buf[sizeof(Header) + sizeof(RetransResponseBody)];
+    bool got = read_exact(fd, buf, sizeof(buf));
+    assert(got);
+    auto resp = codec::decode_expected<RetransResponseBody>(std::span<const uint8_t>(buf, sizeof(buf)),
+                                                            MsgType::RETRANS_RESPONSE);
+    out.clear();
+    for (uint32_t i = 0; i < resp.count; ++i) {
+        uint8_t fr[sizeof(Header) + sizeof(TradeBody)];
+        got = read_exact(fd, fr, sizeof(fr));
+        assert(got);
+        auto fv = codec::unpack_frame(std::span<const uint8_t>(fr, sizeof(fr)));
+        assert(fv.hdr.seqno == resp.begin_seqno + i);
+        out.push_back(codec::decode_body<TradeBody>(fv.body));
+    }
+    return resp;
+}
+
+int main() {
+    // Subscriber socket on an ephemeral loopback port
+    int sub = ::socket(AF_INET, SOCK_DGRAM, 0);
+    assert(sub >= 0);
+    sockaddr_in sub_addr{};
+    sub_addr.sin_family = AF_INET;
+    sub_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(sub_addr);
+    int rc = ::bind(sub, reinterpret_cast<sockaddr*>(&sub_addr), sizeof(sub_addr));
+    assert(rc == 0);
+    rc = ::getsockname(sub, reinterpret_cast<sockaddr*>(&sub_addr), &len);
+    assert(rc == 0);
+    timeval tv{2, 0};
+    ::setsockopt(sub, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    sockaddr_in parsed{};
+    assert(parse_udp_endpoint("127.0.0.1:5000", parsed));
+    assert(ntohs(parsed.sin_port) == 5000);
+    assert(!parse_udp_endpoint("127.0.0.1", parsed));
+    assert(!parse_udp_endpoint("nohost:12", parsed));
+
+    MdPublisherConfig cfg;
+    cfg.udp_destinations.push_back(sub_addr);
+    cfg.retrans_unix_path = "/tmp/md_publisher_test." + std::to_string(::getpid()) + ".sock";
+    cfg.retrans_tcp_port = 0;
+    cfg.retrans_capacity = 16;
+    MdPublisher md(cfg);
+    bool started = md.start();
+    assert(started);
+    assert(md.retrans_tcp_port() != 0);
+
+    // --- 1) Published frames arrive over UDP, sequenced from 1 with no gaps
+    constexpr int kFrames = 40;
+    for (int i = 1; i <= kFrames; ++i) {
+        TradeBody t{};
+        t.price_ticks = 100 + i;
+        t.qty = i;
+        t.instrument_id = 1;
+        uint64_t seq = md.publish(MsgType::TRADE, t, 0);
+        assert(seq == uint64_t(i));
+    }
+    assert(md.last_seqno() == kFrames);
+
+    uint64_t expected = 1;
+    while (expected <= kFrames) {
+        uint8_t dgram[kMdMaxDatagram];
+        ssize_t n = ::recv(sub, dgram, sizeof(dgram), 0);
+        assert(n > 0);
+        size_t off = 0;
+        while (off < size_t(n)) {
+            Header h = codec::decode<Header>(dgram + off, size_t(n) - off);
+            assert(h.type == static_cast<uint8_t>(MsgType::TRADE));
+            assert(h.seqno == expected);
+            auto t = codec::decode_body<TradeBody>(std::span<const uint8_t>(dgram + off + sizeof(Header), sizeof(TradeBody)));
+            assert(t.qty == int32_t(expected));
+            ++expected;
+            off += h.size;
+        }
+    }
+
+    // --- 2) Gap fill over the UNIX retransmit server
+    int ufd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un ua{};
+    ua.sun_family = AF_UNIX;
+    std::strncpy(ua.sun_path, cfg.retrans_unix_path.c_str(), sizeof(ua.sun_path) - 1);
+    rc = ::connect(ufd, reinterpret_cast<sockaddr*>(&ua), sizeof(ua));
+    assert(rc == 0);
+
+    std::vector<TradeBody> frames;
+    RetransResponseBody r = request(ufd, 30, 5, frames);
+    assert(r.status == 0 && r.begin_seqno == 30 && r.count == 5);
+    assert(frames.size() == 5 && frames[0].qty == 30 && frames[4].qty == 34);
+
+    // ring keeps the last 16 frames (25..40); older ones are reported as partial
+    r = request(ufd, 20, 10, frames);
+    assert(r.status == 1 && r.begin_seqno == 25 && r.count == 5);
+
+    // beyond the head: only what exists is returned
+    r = request(ufd, 39, 10, frames);
+    assert(r.status == 1 && r.count == 2);
+    ::close(ufd);
+
+    // --- 3) Same service over TCP
+    int tfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in ta{};
+    ta.sin_family = AF_INET;
+    ta.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ta.sin_port = htons(md.retrans_tcp_port());
+    rc = ::connect(tfd, reinterpret_cast<sockaddr*>(&ta), sizeof(ta));
+    assert(rc == 0);
+    r = request(tfd, 40, 1, frames);
+    assert(r.status == 0 && r.count == 1 && frames[0].price_ticks == 140);
+    ::close(tfd);
+
+    // --- 4) Snapshot request: the test thread plays the engine thread
+    Engine eng;
+    OrderNewBody o{};
+    o.client_order_id = 1;
+    o.instrument_id = 1;
+    o.side = static_cast<uint8_t>(OrderSide::Bid);
+    o.price_ticks = 100;
+    o.qty = 10;
+    eng.on_new(o, true);
+    o.price_ticks = 99;
+    eng.on_new(o, true);
+
+    ufd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    rc = ::connect(ufd, reinterpret_cast<sockaddr*>(&ua), sizeof(ua));
+    assert(rc == 0);
+    SnapshotRequestBody sreq{};
+    sreq.instrument_id = 1;
+    Header sh = codec::make_header(MsgType::SNAPSHOT_REQUEST, sizeof(sreq), 0, 0);
+    auto sbytes = codec::pack(sh, sreq);
+    bool sent = ::write(ufd, sbytes.data(), sbytes.size()) == ssize_t(sbytes.size());
+    assert(sent);
+
+    SnapshotRequest pending{};
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!md.next_snapshot_request(pending)) {
+        assert(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(pending.instrument_id == 1);
+    auto snap = std::make_unique<BookSnapshot>();
+    eng.snapshot(pending.instrument_id, md.last_seqno(), *snap);
+    md.deliver_snapshot(pending, std::move(snap));
+
+    uint8_t sbuf[sizeof(Header) + sizeof(SnapshotBody)];
+    bool got = read_exact(ufd, sbuf, sizeof(sbuf));
+    assert(got);
+    auto sbody = codec::decode_expected<SnapshotBody>(std::span<const uint8_t>(sbuf, sizeof(sbuf)), MsgType::SNAPSHOT);
+    assert(sbody.status == 0 && sbody.md_seqno == kFrames && sbody.num_levels == 2);
+    for (uint32_t i = 0; i < sbody.num_levels; ++i) {
+        uint8_t lbuf[sizeof(Header) + sizeof(LevelUpdateBody)];
+        got = read_exact(ufd, lbuf, sizeof(lbuf));
+        assert(got);
+        auto lvl = codec::decode_expected<LevelUpdateBody>(std::span<const uint8_t>(lbuf, sizeof(lbuf)), MsgType::BOOK_UPDATE);
+        assert(lvl.price_ticks == (i == 0 ? 100 : 99)); // best bid first
+        assert(lvl.total_qty == 10 && lvl.order_count == 1);
+    }
+    ::close(ufd);
+
+    md.stop();
+    assert(md.snapshots_served() == 1);
+    assert(md.frames_published() == kFrames);
+    assert(md.retrans_frames_served() == 13);
+    ::close(sub);
+
+    std::cout << "md_publisher test passed\n";
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "engine.hpp"
+#include "metrics.hpp"
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static OrderNewBody order(uint64_t cid, uint8_t side, int64_t px, int32_t qty) {
+    OrderNewBody o{};
+    o.client_order_id = cid;
+    o.instrument_id = 1;
+    o.side = side;
+    o.price_ticks = px;
+    o.qty = qty;
+    return o;
+}
+
+static uint64_t delta(const MetricValues& before, Metric m) {
+    return metrics::read()[static_cast<size_t>(m)] - before[static_cast<size_t>(m)];
+}
+
+int main() {
+    static_assert(alignof(MetricsShard) == kCacheLine && sizeof(MetricsShard) % kCacheLine == 0);
+    assert(std::string(metric_name(Metric::MsgsNew)) == "msgs_new");
+    assert(std::string(metric_name(Metric::LevelsDeleted)) == "levels_deleted");
+
+    // --- one shard per counting thread, summed on read
+    const MetricValues start = metrics::read();
+    metrics::count(Metric::MsgsOther, 5);
+    const size_t shards = metrics::num_shards();
+    std::vector<std::thread> threads;
+    for (int round = 0; round < 2; ++round) {
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([] {
+                for (int i = 0; i < 100'000; ++i) {
+                    metrics::count(Metric::MsgsOther);
+                }
+            });
+        }
+        for (std::thread& t : threads) {
+            t.join();
+        }
+        threads.clear();
+    }
+#ifndef MARKETFEED_NO_METRICS
+    // the second round reuses the first round's shards, counts and all
+    assert(metrics::num_shards() > shards && metrics::num_shards() <= shards + 4);
+    assert(delta(start, Metric::MsgsOther) == 800'005); // finished threads still count
+#else
+    assert(metrics::num_shards() == shards && delta(start, Metric::MsgsOther) == 0);
+#endif
+
+    // --- engine and book counters
+    Engine engine;
+    const MetricValues before = metrics::read();
+    engine.on_new(order(1, 1, 101, 5), true);  // new ask level
+    engine.on_new(order(2, 1, 102, 5), true);  // another
+    engine.on_new(order(3, 0, 102, 8), true);  // fills 5 @101, 3 @102; deletes 101
+    engine.on_new(order(4, 0, 0, 0), true);    // rejected
+    OrderCancelBody c{};
+    c.exch_order_id = 2;
+    c.instrument_id = 1;
+    engine.on_cancel(c);                       // deletes 102
+    engine.on_cancel(c);                       // rejected: already gone
+#ifndef MARKETFEED_NO_METRICS
+    assert(delta(before, Metric::OrdersAccepted) == 3);
+    assert(delta(before, Metric::Rejects) == 2);
+    assert(delta(before, Metric::Fills) == 2 && delta(before, Metric::FilledQty) == 8);
+    assert(delta(before, Metric::OrdersCancelled) == 1);
+    assert(delta(before, Metric::LevelsCreated) == 2 && delta(before, Metric::LevelsDeleted) == 2);
+#endif
+
+    // --- STATS reply and the dump line
+    const StatsBody b = metrics::stats_body(7, 123);
+    assert(b.request_id == 7 && b.ts_ns == 123 && b.num_values == kNumMetrics);
+#ifndef MARKETFEED_NO_METRICS
+    assert(b.values[static_cast<size_t>(Metric::MsgsOther)] >= 800'005);
+#endif
+    const std::string line = metrics::format(metrics::read());
+    assert(line.rfind("msgs_new=", 0) == 0 && line.find(" levels_deleted=") != std::string::npos);
+
+    std::cout << "metrics test passed\n";
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "engine.hpp"
+#include "order_book.hpp"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+int main() {
+    OrderBook ob;
+    assert(ob.memory().levels.bytes == 0 && ob.memory().orders.bytes == 0);
+    const int64_t empty_index = ob.memory().index.bytes;
+
+    // One order: one level node, one queue node, one index node
+    assert(ob.add_resting(1, OrderSide::Bid, 100, 10));
+    assert(ob.memory().levels.blocks == 1);
+    assert(ob.memory().orders.blocks == 1);
+    assert(ob.memory().orders.bytes >= int64_t(sizeof(BookOrder)));
+    assert(ob.memory().index.bytes > empty_index);
+
+    // Same level: only orders and index grow
+    const BookMemory one = ob.memory();
+    assert(ob.add_resting(2, OrderSide::Bid, 100, 10));
+    assert(ob.memory().levels.bytes == one.levels.bytes);
+    assert(ob.memory().orders.bytes == 2 * one.orders.bytes);
+
+    // New level on the other side
+    assert(ob.add_resting(3, OrderSide::Ask, 101, 10));
+    assert(ob.memory().levels.blocks == 2);
+    assert(ob.memory().orders.blocks == 3);
+
+    // Fills and cancels give everything back except the bucket array
+    std::vector<TradeBody> trades;
+    assert(ob.match_taker(4, OrderSide::Ask, 100, 10, trades, 1, 1) == 10);
+    assert(ob.memory().orders.blocks == 2);
+    assert(ob.cancel_order(2));
+    assert(ob.cancel_order(3));
+    assert(ob.num_orders() == 0);
+    assert(ob.memory().levels.bytes == 0 && ob.memory().levels.blocks == 0);
+    assert(ob.memory().orders.bytes == 0 && ob.memory().orders.blocks == 0);
+    assert(ob.memory().orders.peak_bytes == 3 * one.orders.bytes); // orders 1, 2 and 3 at once
+
+    // Engine sums its books
+    Engine engine;
+    const int64_t base = engine.memory_usage().bytes();
+    OrderNewBody n{};
+    n.client_order_id = 1;
+    n.price_ticks = 100;
+    n.qty = 5;
+    n.side = 0;
+    n.instrument_id = 1;
+    engine.on_new(n, true);
+    n.client_order_id = 2;
+    n.instrument_id = 2;
+    engine.on_new(n, true);
+    assert(engine.num_resting_orders() == 2);
+    const BookMemory m = engine.memory_usage();
+    assert(m.orders.blocks == 2 && m.levels.blocks == 2);
+    assert(m.bytes() > base);
+
+    std::cout << "ob_memory test passed\n";
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include "clock.hpp"
+#include "engine.hpp"
+#include "metrics.hpp"
+#include "order_book.hpp"
+#include "timer_wheel.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+struct Timer : TimerLink {
+    uint64_t expire_ns = 0;
+    bool fired = false;
+};
+
+struct Xorshift {
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    uint64_t next() {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return x;
+    }
+};
+
+static OrderNewBody order(uint64_t cid, uint8_t side, int64_t px, int32_t qty, uint8_t flags, uint16_t expire_after_s = 0) {
+    OrderNewBody o{};
+    o.client_order_id = cid;
+    o.instrument_id = 1;
+    o.side = side;
+    o.price_ticks = px;
+    o.qty = qty;
+    o.flags = flags;
+    o.expire_after_s = expire_after_s;
+    return o;
+}
+
+// Random expiries from one tick to years ahead, advanced in steps of every
+// size: each timer fires once, never before its time, never a tick late.
+static void check_wheel(uint64_t start_ns) {
+    constexpr uint64_t kTick = uint64_t(1) << TimerWheel::kTickShift;
+    TimerWheel wheel(start_ns);
+    Xorshift rng;
+    std::vector<Timer> timers(20'000);
+    for (size_t i = 0; i < timers.size(); ++i) {
+        const unsigned span_bits = 1 + unsigned(rng.next() % 56); // up to ~2 years
+        timers[i].expire_ns = start_ns + 1 + rng.next() % (uint64_t(1) << span_bits);
+        wheel.schedule(&timers[i], timers[i].expire_ns);
+        assert(timers[i].scheduled());
+    }
+    // every 10th is cancelled before it fires
+    for (size_t i = 0; i < timers.size(); i += 10) {
+        TimerWheel::unschedule(&timers[i]);
+        assert(!timers[i].scheduled());
+    }
+    uint64_t now = start_ns;
+    uint64_t last_tick = 0;
+    size_t fired = 0;
+    while (fired < timers.size() - timers.size() / 10) {
+        const unsigned step_bits = unsigned(rng.next() % 58);
+        now += rng.next() % (uint64_t(1) << step_bits) + 1;
+        fired += wheel.advance(now, [&](TimerLink* l) {
+            Timer& t = *static_cast<Timer*>(l);
+            assert(!t.fired && !t.scheduled());
+            assert(t.expire_ns <= now);                        // never early
+            assert(TimerWheel::tick_of(t.expire_ns) >= last_tick); // tick order
+            last_tick = TimerWheel::tick_of(t.expire_ns);
+            t.fired = true;
+        });
+        for (size_t i = 0; i < timers.size(); ++i) {
+            const Timer& t = timers[i];
+            if (i % 10 == 0) {
+                assert(!t.fired);
+            } else if (!t.fired) {
+                // still pending only while its tick is ahead
+                assert(TimerWheel::tick_of(t.expire_ns) > now / kTick && t.scheduled());
+            }
+        }
+    }
+    assert(wheel.advance(UINT64_MAX, [](TimerLink*) { assert(false); }) == 0);
+}
+
+int main() {
+    // --- wheel alone, from zero and from an arbitrary clock reading
+    check_wheel(0);
+    check_wheel(0x0123'4567'89ab'cdefull);
+    {
+        // a timer rescheduled from inside the callback, and one already due
+        TimerWheel wheel(1'000'000'000);
+        Timer a, b;
+        wheel.schedule(&a, 5);               // in the past: next tick
+        wheel.schedule(&b, 3'000'000'000);
+        size_t n = wheel.advance(1'000'000'000, [](TimerLink*) { assert(false); });
+        assert(n == 0);
+        n = wheel.advance(1'002'000'000, [&](TimerLink* l) {
+            assert(l == &a);
+            wheel.schedule(&a, 4'000'000'000);
+        });
+        assert(n == 1 && a.scheduled());
+        std::vector<TimerLink*> order;
+        n = wheel.advance(5'000'000'000, [&](TimerLink* l) { order.push_back(l); });
+        assert(n == 2 && order.size() == 2 && order[0] == &b && order[1] == &a);
+    }
+
+    // --- engine: GTT
+    const MetricValues before = metrics::read();
+    Engine engine;
+    std::vector<BboBody> bbos;
+    const uint64_t t0 = clk::now_ns();
+    const uint64_t kSec = 1'000'000'000;
+    assert(engine.on_new(order(1, 0, 100, 10, TIF_GTT, 5), true).ack.status == 0);  // bid 100, 5s
+    assert(engine.on_new(order(2, 0, 100, 10, TIF_GTT, 60), true).ack.status == 0); // bid 100, 60s
+    assert(engine.on_new(order(3, 0, 99, 10, TIF_GTT, 5), true).ack.status == 0);   // bid 99, 5s
+    assert(engine.on_new(order(4, 1, 110, 10, TIF_GTT, 5), true).ack.status == 0);  // ask 110, 5s
+    assert(engine.on_new(order(5, 1, 111, 10, 0), true).ack.status == 0);           // ask 111, no expiry
+    assert(engine.on_new(order(6, 1, 112, 10, TIF_GTT, 5), true).ack.status == 0);  // ask 112, 5s
+    assert(engine.on_new(order(7, 1, 113, 10, TIF_GTT, 5), true).ack.status == 0);  // ask 113, 5s
+    engine.flush_bbo(bbos);
+
+    // fills and cancels take the timer with the order; a partial fill keeps it
+    assert(engine.on_new(order(8, 0, 110, 10, TIF_IOC | TIF_GTT, 5), false).trades.size() == 1); // ask 110 gone
+    assert(engine.on_new(order(9, 1, 99, 14, TIF_IOC), false).trades.size() == 2);  // bid 100 #1 gone, #2 has 6
+    OrderCancelBody c{};
+    c.instrument_id = 1;
+    c.exch_order_id = 6; // ask 112
+    assert(engine.on_cancel(c).ack.status == 0);
+    assert(engine.num_resting_orders() == 4);
+
+    EngineResult r = engine.expire(t0 + 4 * kSec);
+    assert(r.ack.status == 0 && r.ack.cancelled_count == 0 && r.levels.empty());
+    r = engine.expire(t0 + 6 * kSec);
+    assert(r.ack.cancelled_count == 2); // bid 99, ask 113
+    assert(r.levels.size() == 2);
+    assert(r.levels[0].side == 0 && r.levels[0].price_ticks == 99 && r.levels[0].action == uint8_t(LevelAction::DELETE));
+    assert(r.levels[1].side == 1 && r.levels[1].price_ticks == 113);
+    assert(engine.num_resting_orders() == 2);
+    bbos.clear();
+    engine.flush_bbo(bbos);
+    assert(bbos.size() == 1);
+    r = engine.expire(t0 + 61 * kSec);
+    assert(r.ack.cancelled_count == 1 && r.levels.size() == 1 && r.levels[0].price_ticks == 100);
+    assert(engine.num_resting_orders() == 1); // the order without expiry
+    assert(engine.expire(t0 + 3600 * kSec).ack.cancelled_count == 0);
+
+    // --- engine: DAY, refused until there is a day end ahead
+    Engine day;
+    assert(day.on_new(order(20, 0, 100, 10, TIF_DAY), true).ack.status == 1);
+    assert(day.on_new(order(21, 0, 100, 10, TIF_DAY | TIF_GTT, 5), true).ack.status == 1);
+    assert(day.on_new(order(22, 0, 100, 10, TIF_GTT, 0), true).ack.status == 1);
+    const uint64_t day_end = clk::now_ns() + 10 * kSec;
+    day.set_day_end(day_end);
+    assert(day.day_end() == day_end);
+    constexpr int kDay = 10'000;
+    for (int i = 0; i < kDay; ++i) {
+        const uint8_t side = uint8_t(i & 1);
+        const int64_t px = side == 0 ? 90 - i / 2 % 50 : 120 + i / 2 % 50;
+        assert(day.on_new(order(100 + uint64_t(i), side, px, 1, TIF_DAY), true, 1).ack.status == 0);
+    }
+    assert(day.num_session_orders(1) == kDay);
+    assert(day.expire(day_end - 1).ack.cancelled_count == 0);
+    r = day.expire(day_end + (uint64_t(1) << TimerWheel::kTickShift));
+    assert(r.ack.cancelled_count == kDay);
+    assert(r.levels.size() == 2 * 50); // one per level, in side / price order
+    for (size_t i = 1; i < r.levels.size(); ++i) {
+        const LevelUpdateBody& a = r.levels[i - 1];
+        const LevelUpdateBody& b = r.levels[i];
+        assert(a.side < b.side || (a.side == b.side && a.price_ticks < b.price_ticks));
+        assert(b.action == uint8_t(LevelAction::DELETE));
+    }
+    assert(day.num_session_orders(1) == 0 && day.num_resting_orders() == 0);
+    day.set_day_end(clk::now_ns());
+    assert(day.on_new(order(30, 0, 100, 10, TIF_DAY), true).ack.status == 1); // the day is over
+
+    // --- mass cancels unschedule too, whole-book and per side
+    day.set_day_end(clk::now_ns() + 10 * kSec);
+    for (uint64_t i = 0; i < 100; ++i) {
+        assert(day.on_new(order(200 + i, uint8_t(i & 1), i & 1 ? 130 : 80, 1, TIF_DAY), true).ack.status == 0);
+    }
+    MassCancelBody mc{};
+    mc.instrument_id = 1;
+    mc.side = 0;
+    assert(day.on_mass_cancel(mc, kAnyOwner).ack.cancelled_count == 50);
+    mc.side = kBothSides;
+    assert(day.on_mass_cancel(mc, kAnyOwner).ack.cancelled_count == 50);
+    assert(day.expire(day.day_end() + kSec).ack.cancelled_count == 0);
+
+    const MetricValues after = metrics::read();
+#ifndef MARKETFEED_NO_METRICS
+    const size_t expired = static_cast<size_t>(Metric::OrdersExpired);
+    assert(after[expired] - before[expired] == 3 + kDay);
+#else
+    (void)before;
+    (void)after;
+#endif
+
+    std::cout << "order_expiry test passed\n";
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "capture.hpp"
+#include "flow_gen.hpp"
+#include "replay.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+// Every result as bytes, ACK timestamps zeroed, so two runs compare exactly.
+class CollectSink : public ReplaySink {
+public:
+    void on_result(const Header& request, const AckBody& ack, std::span<const TradeBody> trades,
+                   std::span<const LevelUpdateBody> levels) override {
+        append(request.seqno);
+        AckBody a = ack;
+        a.ts_engine_recv_ns = a.ts_engine_ack_ns = 0;
+        append(a);
+        append(trades.size());
+        for (const TradeBody& t : trades) {
+            append(t);
+        }
+        append(levels.size());
+        for (const LevelUpdateBody& u : levels) {
+            append(u);
+        }
+    }
+
+    std::string bytes;
+
+private:
+    template <typename T>
+    void append(const T& v) {
+        bytes.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+};
+
+static std::string run(const std::string& path, const ReplayOptions& opt, ReplayStats& st) {
+    CaptureFile cap;
+    const bool opened = cap.open(path);
+    assert(opened);
+    (void)opened;
+    CollectSink sink;
+    st = replay(cap, opt, sink);
+    assert(st.consistent);
+    return sink.bytes;
+}
+
+int main() {
+    const std::string path = "/tmp/marketfeed_parallel_replay_" + std::to_string(::getpid()) + ".cap";
+    constexpr uint32_t kInstruments = 8;
+
+    // --- a generated flow, plus requests each engine must refuse the same way
+    {
+        CaptureWriter w;
+        const bool opened = w.open(path, 11);
+        assert(opened);
+        (void)opened;
+        FlowGenConfig cfg;
+        cfg.seed = 11;
+        cfg.num_instruments = kInstruments;
+        FlowGenerator gen(cfg);
+        for (uint64_t i = 0; i < 60'000; ++i) {
+            const FlowEvent ev = gen.next();
+            if (ev.type == MsgType::NEW) {
+                w.append(MsgType::NEW, ev.new_order, ev.ts_ns);
+            } else {
+                w.append(MsgType::CANCEL, ev.cancel, ev.ts_ns);
+            }
+            if (i % 1000 == 0) {
+                // unknown instrument, a DAY order with no day end, a zero qty,
+                // a cancel naming the wrong instrument: no exch id for any
+                OrderNewBody bad{};
+                bad.client_order_id = i;
+                bad.instrument_id = kInstruments + 1 + uint32_t(i % 3);
+                bad.qty = 1;
+                w.append(MsgType::NEW, bad, ev.ts_ns);
+                bad.instrument_id = 1;
+                bad.flags = TIF_DAY;
+                w.append(MsgType::NEW, bad, ev.ts_ns);
+                bad.flags = 0;
+                bad.qty = 0;
+                w.append(MsgType::NEW, bad, ev.ts_ns);
+                OrderCancelBody c{};
+                c.instrument_id = 2;
+                c.exch_order_id = i / 2 + 1;
+                w.append(MsgType::CANCEL, c, ev.ts_ns);
+            }
+        }
+        const bool closed = w.close();
+        assert(closed);
+        (void)closed;
+    }
+
+    ReplayOptions serial;
+    serial.num_instruments = kInstruments;
+    ReplayStats ref;
+    const std::string expected = run(path, serial, ref);
+    assert(ref.partitions == 1 && ref.news + ref.cancels == 60'000 + 60 * 4);
+    assert(ref.trades > 0 && ref.rejects >= 60 * 4);
+
+    // --- any thread count, any window: the same bytes
+    for (const unsigned threads : {1u, 2u, 3u, 8u}) {
+        for (const uint64_t window : {uint64_t(997), uint64_t(1) << 20}) {
+            ReplayOptions opt = serial;
+            opt.threads = threads;
+            opt.window_frames = window;
+            ReplayStats st;
+            const std::string got = run(path, opt, st);
+            assert(got == expected);
+            assert(st.news == ref.news && st.cancels == ref.cancels && st.rejects == ref.rejects);
+            assert(st.trades == ref.trades && st.levels == ref.levels);
+            assert(st.partitions == std::min<uint64_t>(kInstruments, threads * 4));
+        }
+    }
+
+    // --- an engine with fewer instruments refuses the rest, in both modes
+    {
+        ReplayOptions small;
+        ReplayStats a, b;
+        const std::string s = run(path, small, a);
+        small.threads = 2;
+        assert(run(path, small, b) == s);
+        assert(a.rejects > ref.rejects && a.rejects == b.rejects);
+    }
+
+    std::remove(path.c_str());
+    std::cout << "parallel_replay test passed\n";
+    return 0;
+}
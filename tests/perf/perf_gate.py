@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+# Performance regression gate (ctest -L perf).
+#
+# Runs a fixed subset of the bench_* cases and compares them with
+# tests/perf/baseline.json. Numbers are normalised by each run's `calibrate`
+# case (fixed CPU-bound work), so the baseline carries over between machines
+# and clock speeds reasonably well. A measurement pools every repetition of
+# --rounds runs (the harness's --samples). A case regresses only if
+#   - its normalised median is slower than the baseline's by more than its
+#     tolerance, and
+#   - a one-sided Mann-Whitney U test says its repetitions are slower than the
+#     baseline's scaled by (1 + tolerance), at --alpha; so a shifted median
+#     counts, a few slow outliers don't;
+# regressed cases are re-measured (--retries) and the best attempt counts, so a
+# burst of interference doesn't fail the build.
+#
+# --self-test checks the comparison itself (no benchmarks run): a 1.3x copy of
+# each baseline case, and of a synthetic spread as wide as the noisiest case,
+# must fail; an unchanged one must pass.
+#
+# Non-optimised builds exit 77 (ctest reports the test as skipped).
+# Refresh the baseline from an optimised build with --update.
+import argparse
+import json
+import math
+import os
+import random
+import re
+import subprocess
+import sys
+
+OPTIMIZED = {"Release", "RelWithDebInfo", "MinSizeRel"}
+SKIP = 77
+DEFAULT_TOLERANCE = 0.15
+
+# executable -> (extra args, gated cases)
+SUITES = {
+    "bench_orderbook": (["--max-depth", "10000", "--reps", "51"],
+                        ["add/depth:10000", "cancel_front/depth:10000", "cancel_back/depth:10000",
+                         "match/depth:10000/fills:10", "best_quote/depth:10000"]),
+    "bench_engine": (["--reps", "31"],
+                     ["engine_flow/messages:200000", "codec_pack_new", "codec_decode_new"]),
+}
+
+
+def case_id(result: dict) -> str:
+    params = [f"{k}:{v}" for k, v in result.items() if k not in ("name", "ops", "ns_per_op", "samples")]
+    return "/".join([result["name"]] + params)
+
+
+def median(xs: list) -> float:
+    s = sorted(xs)
+    n = len(s)
+    return s[n // 2] if n % 2 else (s[n // 2 - 1] + s[n // 2]) / 2
+
+
+def mann_whitney_greater(a: list, b: list) -> float:
+    """One-sided p-value that a is stochastically greater than b.
+
+    U statistic with mid-ranks for ties, normal approximation with tie and
+    continuity corrections; fine for the 50+ samples a case has."""
+    n1, n2 = len(a), len(b)
+    pooled = sorted([(x, 0) for x in a] + [(x, 1) for x in b])
+    ranks_a = 0.0
+    ties = 0.0
+    i = 0
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        rank = (i + j) / 2 + 1
+        t = j - i + 1
+        ties += t ** 3 - t
+        ranks_a += rank * sum(1 for k in range(i, j + 1) if pooled[k][1] == 0)
+        i = j + 1
+    u = ranks_a - n1 * (n1 + 1) / 2
+    n = n1 + n2
+    var = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)))
+    if var <= 0:
+        return 0.0 if u > n1 * n2 / 2 else 1.0
+    z = (u - n1 * n2 / 2 - 0.5) / math.sqrt(var)
+    return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+def compare(cur: list, base: list, tol: float, alpha: float) -> tuple:
+    """(median ratio, p-value, regressed) for normalised repetition samples."""
+    ratio = median(cur) / median(base)
+    p = mann_whitney_greater(cur, [x * (1.0 + tol) for x in base])
+    return ratio, p, ratio > 1.0 + tol and p < alpha
+
+
+def run_suite(bench_dir: str, exe: str, args: list, cases: list) -> dict:
+    cmd = [os.path.join(bench_dir, exe)] + args + ["--samples", "--filter", ",".join(["calibrate"] + cases)]
+    out = subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+    doc = json.loads(out)
+    return {case_id(r): r for r in doc["results"]}
+
+
+def measure(bench_dir: str, exe: str, args: list, cases: list, rounds: int) -> dict:
+    """Per case: normalised repetition samples pooled over `rounds` runs, with
+    their median, and the raw median ns and calibrate median they came from."""
+    pooled = {c: {"samples": [], "raw": [], "calibrate": []} for c in cases}
+    for _ in range(rounds):
+        res = run_suite(bench_dir, exe, args, cases)
+        calib = res["calibrate"]["ns_per_op"]["median"]
+        for c in cases:
+            pooled[c]["samples"] += [x / calib for x in res[c]["samples"]]
+            pooled[c]["raw"] += res[c]["samples"]
+            pooled[c]["calibrate"].append(calib)
+    return {c: {"samples": p["samples"], "median": median(p["samples"]), "raw": median(p["raw"]),
+                "calibrate": median(p["calibrate"])} for c, p in pooled.items()}
+
+
+def self_test(baseline: dict, alpha: float) -> int:
+    """The comparison must flag a 1.3x slowdown at the default tolerance and
+    pass an unchanged result, on every baseline case and on synthetic data."""
+    rng = random.Random(33)
+    cases = []
+    for exe, suite in baseline.get("suites", {}).items():
+        for c, base in suite.items():
+            if base.get("samples"):
+                cases.append((f"{exe}:{c}", base["samples"], base.get("tolerance", baseline["default_tolerance"])))
+    # a fresh draw, not a copy: as wide as match/depth:10000 (p10 -32%, p90 +16%)
+    def draw(scale: float) -> list:
+        return [scale * 100.0 * math.exp(rng.gauss(0.0, 0.2)) for _ in range(255)]
+    synthetic_base = draw(1.0)
+    failures = []
+    for name, base, tol in cases:
+        if tol > DEFAULT_TOLERANCE:
+            continue  # hand-widened: not expected to catch 1.3x
+        if not compare([x * 1.3 for x in base], base, tol, alpha)[2]:
+            failures.append(f"{name}: 1.3x not flagged")
+        if compare(list(base), base, tol, alpha)[2]:
+            failures.append(f"{name}: unchanged flagged")
+    if not compare(draw(1.3), synthetic_base, DEFAULT_TOLERANCE, alpha)[2]:
+        failures.append("synthetic: 1.3x not flagged")
+    if compare(draw(1.0), synthetic_base, DEFAULT_TOLERANCE, alpha)[2]:
+        failures.append("synthetic: same distribution flagged")
+    if compare(draw(1.05), synthetic_base, DEFAULT_TOLERANCE, alpha)[2]:
+        failures.append("synthetic: 1.05x flagged")
+    for f in failures:
+        print(f"perf gate self-test: {f}")
+    if failures:
+        return 1
+    print(f"perf gate self-test: passed ({len(cases)} baseline cases + synthetic)")
+    return 0
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--bench-dir")
+    ap.add_argument("--baseline", required=True)
+    ap.add_argument("--build-type", default="")
+    ap.add_argument("--tolerance", type=float, default=None, help="override every case's tolerance")
+    ap.add_argument("--alpha", type=float, default=0.01, help="significance of the Mann-Whitney test")
+    ap.add_argument("--rounds", type=int, default=5, help="runs per measurement; their repetitions are pooled")
+    ap.add_argument("--retries", type=int, default=2, help="re-measurements of a regressed case")
+    ap.add_argument("--update", action="store_true", help="rewrite the baseline from this machine")
+    ap.add_argument("--self-test", action="store_true", help="check the comparison on the baseline and exit")
+    args = ap.parse_args()
+
+    old = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            old = json.load(f)
+
+    if args.self_test:
+        if not old:
+            print(f"perf gate self-test: no baseline at {args.baseline}")
+            return 1
+        return self_test(old, args.alpha)
+
+    if not args.bench_dir:
+        ap.error("--bench-dir is required")
+    if args.build_type not in OPTIMIZED and not os.environ.get("MARKETFEED_PERF_FORCE"):
+        print(f"perf gate: skipped, build type '{args.build_type}' is not optimised "
+              f"(configure with -DCMAKE_BUILD_TYPE=Release, or set MARKETFEED_PERF_FORCE=1)")
+        return SKIP
+
+    if args.update:
+        baseline = {"version": 2, "default_tolerance": old.get("default_tolerance", DEFAULT_TOLERANCE),
+                    "suites": {}}
+        for exe, (extra, cases) in SUITES.items():
+            m = measure(args.bench_dir, exe, extra, cases, args.rounds)
+            suite = {}
+            for c in cases:
+                suite[c] = {"median_ns": round(m[c]["raw"], 3),
+                            "calibrate_ns": round(m[c]["calibrate"], 4),
+                            "samples": sorted(float(f"{x:.5g}") for x in m[c]["samples"])}
+                # hand-tuned per-case tolerances survive a refresh
+                old_case = old.get("suites", {}).get(exe, {}).get(c, {})
+                if "tolerance" in old_case:
+                    suite[c]["tolerance"] = old_case["tolerance"]
+            baseline["suites"][exe] = suite
+        text = json.dumps(baseline, indent=2)
+        # one line per samples list
+        text = re.sub(r"\[\s*([-0-9.e,\s]+?)\s*\]", lambda m: "[" + re.sub(r"\s+", " ", m.group(1)) + "]", text)
+        with open(args.baseline, "w") as f:
+            f.write(text + "\n")
+        print(f"perf gate: baseline written to {args.baseline}")
+        return 0
+
+    if not old:
+        print(f"perf gate: no baseline at {args.baseline}, run with --update")
+        return 1
+    default_tol = old.get("default_tolerance", DEFAULT_TOLERANCE)
+
+    rows = []
+    failed = False
+    for exe, (extra, cases) in SUITES.items():
+        base_suite = old["suites"].get(exe, {})
+        pending = [c for c in cases if base_suite.get(c, {}).get("samples")]
+        best = {}  # case -> (ratio, p, regressed, current raw median ns)
+        for attempt in range(1 + args.retries):
+            if not pending:
+                break
+            cur = measure(args.bench_dir, exe, extra, pending, args.rounds)
+            still = []
+            for c in pending:
+                base = base_suite[c]
+                tol = args.tolerance if args.tolerance is not None else base.get("tolerance", default_tol)
+                ratio, p, regressed = compare(cur[c]["samples"], base["samples"], tol, args.alpha)
+                if c not in best or ratio < best[c][0]:
+                    best[c] = (ratio, p, regressed, cur[c]["raw"])
+                if regressed:
+                    still.append(c)
+            pending = still
+        for c in cases:
+            if c not in best:
+                rows.append((exe, c, None, None, None, None, None, "no baseline (run --update)"))
+                continue
+            base = base_suite[c]
+            tol = args.tolerance if args.tolerance is not None else base.get("tolerance", default_tol)
+            ratio, p, regressed, cur_ns = best[c]
+            if regressed:
+                status = "REGRESSED"
+                failed = True
+            elif ratio < 1.0 - tol:
+                status = "faster (consider --update)"
+            else:
+                status = "ok"
+            rows.append((exe, c, base["median_ns"], cur_ns, ratio, tol, p, status))
+
+    print(f"{'suite':<16} {'case':<34} {'base ns':>10} {'now ns':>10} {'change':>8} {'tol':>6} {'p':>8}  status")
+    for exe, c, base_ns, cur_ns, ratio, tol, p, status in rows:
+        if ratio is None:
+            print(f"{exe:<16} {c:<34} {'-':>10} {'-':>10} {'-':>8} {'-':>6} {'-':>8}  {status}")
+            continue
+        print(f"{exe:<16} {c:<34} {base_ns:>10.1f} {cur_ns:>10.1f} {(ratio - 1) * 100:>+7.1f}% "
+              f"{tol * 100:>5.0f}% {p:>8.2g}  {status}")
+    print("(change is calibration-normalised, so it can differ from the raw ns columns; "
+          "p: Mann-Whitney, slower than baseline x (1 + tol))")
+
+    if failed:
+        print("perf gate: FAILED")
+        return 1
+    print("perf gate: passed")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -17,7 +17,7 @@ int main() {
     body.instrument_id = 1;
     body.side = 0; // 0 -> bid, 1 -> ask
     body.flags = 0;
-    body.pad = 0;
+    body.expire_after_s = 0;
 
     std::vector<uint8_t> bytes = codec::pack(hdr, body);
 
@@ -0,0 +1,120 @@
+#include "engine.hpp"
+#include "order_book.hpp"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+static size_t list_size(const OwnerList& list) {
+    size_t n = 0;
+    for (const OwnerLink* l = list.next; l != &list; l = l->next) {
+        ++n;
+    }
+    return n;
+}
+
+static OrderNewBody order(uint64_t cid, uint32_t instr, uint8_t side, int64_t px, int32_t qty) {
+    OrderNewBody o{};
+    o.client_order_id = cid;
+    o.instrument_id = instr;
+    o.side = side;
+    o.price_ticks = px;
+    o.qty = qty;
+    return o;
+}
+
+int main() {
+    // --- book: the list follows add, partial and full fill, cancel, mass cancel
+    OrderBook ob(7);
+    OwnerList mine;
+    std::vector<TradeBody> trades;
+    assert(mine.empty());
+    assert(ob.add_resting(1, OrderSide::Ask, 100, 10, 1, &mine));
+    assert(ob.add_resting(2, OrderSide::Ask, 101, 10, 1, &mine));
+    assert(ob.add_resting(3, OrderSide::Ask, 101, 10));            // no owner
+    assert(ob.add_resting(4, OrderSide::Bid, 90, 10, 1, &mine));
+    assert(list_size(mine) == 3);
+    assert(OrderBook::owned_order(mine.next).exch_order_id == 1);   // oldest first
+    assert(OrderBook::owned_order(mine.prev).exch_order_id == 4);
+    assert(OrderBook::owned_order(mine.next).instrument_id == 7);
+
+    assert(ob.match_taker(9, OrderSide::Bid, 100, 4, trades, 7, 0) == 4); // partial: stays
+    assert(list_size(mine) == 3);
+    assert(ob.match_taker(9, OrderSide::Bid, 100, 6, trades, 7, 0) == 6); // full: unlinked
+    assert(list_size(mine) == 2 && OrderBook::owned_order(mine.next).exch_order_id == 2);
+    assert(ob.cancel_order(4) && list_size(mine) == 1);
+    assert(ob.add_resting(5, OrderSide::Bid, 91, 10, 1, &mine) && list_size(mine) == 2);
+    std::vector<LevelUpdateBody> out;
+    assert(ob.mass_cancel(uint8_t(OrderSide::Ask), kAnyOwner, out, 7) == 2 && list_size(mine) == 1);
+    assert(ob.mass_cancel(kBothSides, kAnyOwner, out, 7) == 1 && mine.empty());
+
+    // --- engine: a session holding 100k live orders across two instruments
+    Engine engine;
+    constexpr uint64_t kOrders = 100'000;
+    uint64_t cid = 1;
+    for (uint64_t i = 0; i < kOrders; ++i) {
+        const uint32_t instr = 1 + uint32_t(i & 1);
+        const uint8_t side = uint8_t((i >> 1) & 1);
+        const int64_t level = int64_t((i >> 2) % 500);
+        const int64_t px = side == 0 ? 1000 - level : 2000 + level;
+        assert(engine.on_new(order(cid++, instr, side, px, 10), true, 1).ack.status == 0);
+    }
+    // another session quotes alongside it
+    for (uint64_t i = 0; i < 1000; ++i) {
+        assert(engine.on_new(order(cid++, 1, uint8_t(i & 1), (i & 1) ? 2000 : 1000, 5), true, 2).ack.status == 0);
+    }
+    assert(engine.num_session_orders(1) == kOrders && engine.num_session_orders(2) == 1000);
+
+    // fills and cancels on session 1's orders keep its list exact
+    EngineResult taker = engine.on_new(order(cid++, 1, 0, 2000, 25), false, 3); // IOC at the best ask
+    assert(!taker.trades.empty());
+    size_t session1_filled = 0;
+    for (const TradeBody& t : taker.trades) {
+        session1_filled += t.resting_exch_order_id <= kOrders && t.qty == 10; // fully filled makers of session 1
+    }
+    OrderCancelBody c{};
+    c.exch_order_id = 2; // session 1, instrument 2
+    c.instrument_id = 2;
+    assert(engine.on_cancel(c).ack.status == 0);
+    const size_t remaining = kOrders - session1_filled - 1;
+    assert(engine.num_session_orders(1) == remaining);
+
+    std::vector<BboBody> bbos;
+    engine.flush_bbo(bbos);
+    const size_t resting_before = engine.num_resting_orders();
+
+    // disconnect: exactly session 1's orders go, one update per level
+    EngineResult r = engine.cancel_session(1);
+    assert(r.ack.cancelled_count == remaining);
+    assert(engine.num_session_orders(1) == 0 && engine.num_session_orders(2) == 1000);
+    assert(engine.num_resting_orders() == resting_before - remaining);
+    assert(r.levels.size() == 2 * 2 * 500); // every level of both instruments, sides
+    for (size_t i = 1; i < r.levels.size(); ++i) {
+        const LevelUpdateBody& a = r.levels[i - 1];
+        const LevelUpdateBody& b = r.levels[i];
+        assert(a.instrument_id < b.instrument_id || (a.instrument_id == b.instrument_id && a.side <= b.side));
+    }
+    // levels shared with session 2 remain with its quantity
+    for (const LevelUpdateBody& u : r.levels) {
+        const bool shared = u.instrument_id == 1 && (u.price_ticks == 1000 || u.price_ticks == 2000);
+        assert(shared ? (u.action == uint8_t(LevelAction::UPDATE) && u.total_qty == 500 * 5)
+                      : u.action == uint8_t(LevelAction::DELETE));
+    }
+    bbos.clear();
+    engine.flush_bbo(bbos);
+    assert(bbos.size() == 2); // both instruments' tops moved
+
+    BboBody top{};
+    assert(engine.bbo(1, top) && top.bid_price_ticks == 1000 && top.ask_price_ticks == 2000);
+    assert(engine.bbo(2, top) && top.bid_total_qty == 0 && top.ask_total_qty == 0);
+
+    // nothing left: a second disconnect, an unknown session, no session at all
+    assert(engine.num_sessions() == 1); // session 1's list went with its orders; IOC-only 3 never had one
+    assert(engine.cancel_session(1).ack.cancelled_count == 0);
+    assert(engine.cancel_session(99).ack.cancelled_count == 0);
+    assert(engine.cancel_session(0).ack.cancelled_count == 0);
+    assert(engine.cancel_session(2).ack.cancelled_count == 1000 && engine.num_resting_orders() == 0);
+    assert(engine.num_sessions() == 0);
+
+    std::cout << "session_orders test passed\n";
+    return 0;
+}
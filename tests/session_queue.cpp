@@ -0,0 +1,96 @@
+#include "session_queue.hpp"
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// 64-byte frame whose first byte identifies it
+static std::vector<uint8_t> frame(uint8_t tag) {
+    std::vector<uint8_t> f(64, 0);
+    f[0] = tag;
+    return f;
+}
+
+static std::vector<uint8_t> read_tags(int fd) {
+    std::vector<uint8_t> tags;
+    uint8_t buf[64];
+    for (;;) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), MSG_DONTWAIT | MSG_WAITALL);
+        if (n != ssize_t(sizeof(buf))) {
+            break;
+        }
+        tags.push_back(buf[0]);
+    }
+    return tags;
+}
+
+int main() {
+    int sv[2];
+    int rc = ::socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    assert(rc == 0);
+    ::fcntl(sv[0], F_SETFL, ::fcntl(sv[0], F_GETFL, 0) | O_NONBLOCK);
+
+    OutQueueConfig cfg;
+    cfg.watermark = 200;
+    cfg.cap = 1000;
+    cfg.max_over_cap_ns = 1000;
+    SessionOutQueue q(cfg);
+
+    // --- 1) Below the watermark everything is queued in order
+    auto a1 = frame(1), a2 = frame(2), a3 = frame(3), a4 = frame(4);
+    q.push_reliable(a1.data(), a1.size());
+    q.push_reliable(a2.data(), a2.size());
+    q.push_reliable(a3.data(), a3.size());
+    q.push_reliable(a4.data(), a4.size());
+    assert(q.bytes_queued() == 256);
+
+    // --- 2) Above it, top-of-book is conflated: latest per instrument kept aside
+    auto b1_old = frame(10), b1_new = frame(11), b2 = frame(20);
+    q.push_conflatable(1, b1_old.data(), b1_old.size());
+    q.push_conflatable(2, b2.data(), b2.size());
+    q.push_conflatable(1, b1_new.data(), b1_new.size());
+    assert(q.bytes_queued() == 256); // nothing added to the stream
+    assert(q.conflated() == 1);
+    assert(q.has_output());
+
+    // --- 3) Draining the backlog releases the conflated frames after the ACKs
+    bool ok = q.flush(sv[0]);
+    assert(ok);
+    assert(!q.has_output());
+    std::vector<uint8_t> got = read_tags(sv[1]);
+    std::vector<uint8_t> want = {1, 2, 3, 4, 11, 20};
+    assert(got == want);
+
+    // --- 4) ACKs are never refused, even above the cap; staying there means disconnect
+    for (int i = 0; i < 20; ++i) {
+        q.push_reliable(a1.data(), a1.size());
+    }
+    assert(q.bytes_queued() == 20 * 64);
+    assert(!q.should_disconnect(5));       // just went over: grace period starts
+    assert(!q.should_disconnect(5 + 500));
+    assert(q.should_disconnect(5 + 2000)); // still over after max_over_cap_ns
+
+    q.push_conflatable(3, b2.data(), b2.size());
+    q.discard();
+    assert(q.dropped() == 1);
+    assert(!q.has_output());
+
+    // --- 5) Dropping back under the cap resets the grace period
+    SessionOutQueue q2(cfg);
+    for (int i = 0; i < 20; ++i) {
+        q2.push_reliable(a1.data(), a1.size());
+    }
+    assert(!q2.should_disconnect(10));
+    ok = q2.flush(sv[0]);
+    assert(ok);
+    assert(!q2.should_disconnect(10'000));
+    read_tags(sv[1]);
+
+    ::close(sv[0]);
+    ::close(sv[1]);
+    std::cout << "session_queue test passed\n";
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "consumer_book.hpp"
+#include "engine.hpp"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+// Stands in for the publisher: sequences the engine's level updates (plus the
+// trades, which share the md sequence) into frames.
+struct Feed {
+    uint64_t seqno = 0;
+    std::vector<std::pair<Header, LevelUpdateBody>> frames;
+
+    void publish(const EngineResult& r) {
+        for (size_t i = 0; i < r.trades.size(); ++i) {
+            frames.push_back({codec::make_header(MsgType::TRADE, sizeof(TradeBody), ++seqno, 0), {}});
+        }
+        for (const LevelUpdateBody& u : r.levels) {
+            frames.push_back({codec::make_header(MsgType::BOOK_UPDATE, sizeof(LevelUpdateBody), ++seqno, 0), u});
+        }
+    }
+};
+
+static void feed(SnapshotSync& sync, const std::pair<Header, LevelUpdateBody>& f) {
+    std::span<const uint8_t> body(reinterpret_cast<const uint8_t*>(&f.second), sizeof(LevelUpdateBody));
+    if (f.first.type == static_cast<uint8_t>(MsgType::TRADE)) {
+        static const TradeBody t{};
+        body = std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&t), sizeof(TradeBody));
+    }
+    sync.on_frame(f.first, body);
+}
+
+static OrderNewBody make_new(uint64_t cid, uint32_t instr, OrderSide side, int64_t px, int32_t qty) {
+    OrderNewBody o{};
+    o.client_order_id = cid;
+    o.instrument_id = instr;
+    o.side = static_cast<uint8_t>(side);
+    o.price_ticks = px;
+    o.qty = qty;
+    return o;
+}
+
+// Every level in the engine's book must be present, with the same aggregates, in the client's.
+static void assert_same_book(const Engine& eng, const SnapshotSync& sync, uint32_t instr) {
+    BookSnapshot truth;
+    eng.snapshot(instr, 0, truth);
+    size_t bids = 0, asks = 0;
+    for (const LevelUpdateBody& u : truth.levels) {
+        SnapshotSync::Level l;
+        assert(sync.level(u.side, u.price_ticks, l));
+        assert(l.total_qty == u.total_qty);
+        assert(l.order_count == u.order_count);
+        (u.side == 0 ? bids : asks)++;
+    }
+    assert(sync.num_levels(0) == bids);
+    assert(sync.num_levels(1) == asks);
+}
+
+int main() {
+    Engine eng;
+    Feed md;
+    uint64_t cid = 1;
+
+    // --- 1) Session runs for a while before the client joins
+    for (int i = 0; i < 20; ++i) {
+        md.publish(eng.on_new(make_new(cid++, 1, OrderSide::Bid, 100 - i % 5, 10 + i), true));
+        md.publish(eng.on_new(make_new(cid++, 1, OrderSide::Ask, 105 + i % 4, 5 + i), true));
+        md.publish(eng.on_new(make_new(cid++, 2, OrderSide::Ask, 50, 1), true)); // other instrument
+    }
+
+    // --- 2) Client subscribes at frame join_at; more activity happens before the snapshot
+    SnapshotSync sync(1);
+    const size_t join_at = md.frames.size();
+    md.publish(eng.on_new(make_new(cid++, 1, OrderSide::Bid, 106, 40), true));  // sweeps asks at 105/106
+    md.publish(eng.on_new(make_new(cid++, 1, OrderSide::Ask, 99, 15), false)); // IOC sell into bids
+
+    BookSnapshot snap;
+    bool found = eng.snapshot(1, md.seqno, snap);
+    assert(found && snap.md_seqno == md.seqno);
+    assert(!snap.levels.empty());
+
+    // --- 3) Activity continues while the snapshot is in flight
+    md.publish(eng.on_new(make_new(cid++, 1, OrderSide::Bid, 98, 7), true));
+    OrderCancelBody c{};
+    c.exch_order_id = 1; // first bid, still resting
+    c.instrument_id = 1;
+    md.publish(eng.on_cancel(c));
+
+    for (size_t i = join_at; i < md.frames.size(); ++i) {
+        feed(sync, md.frames[i]);
+    }
+    assert(sync.state() == SnapshotSync::State::Buffering);
+
+    // a snapshot from before the client joined cannot be bridged
+    BookSnapshot too_old = snap;
+    too_old.md_seqno = join_at - 1;
+    assert(!sync.apply_snapshot(too_old));
+
+    bool applied = sync.apply_snapshot(snap);
+    assert(applied);
+    assert(sync.state() == SnapshotSync::State::Synced);
+    assert(sync.last_seqno() == md.seqno);
+    assert_same_book(eng, sync, 1);
+
+    // --- 4) Live frames apply directly; duplicates are ignored, gaps go stale
+    size_t live_from = md.frames.size();
+    md.publish(eng.on_new(make_new(cid++, 1, OrderSide::Ask, 110, 3), true));
+    md.publish(eng.on_new(make_new(cid++, 1, OrderSide::Bid, 110, 3), true));
+    for (size_t i = live_from; i < md.frames.size(); ++i) {
+        feed(sync, md.frames[i]);
+        feed(sync, md.frames[i]);
+    }
+    assert(sync.state() == SnapshotSync::State::Synced);
+    assert_same_book(eng, sync, 1);
+
+    md.publish(eng.on_new(make_new(cid++, 1, OrderSide::Bid, 90, 1), true));
+    md.publish(eng.on_new(make_new(cid++, 1, OrderSide::Bid, 91, 1), true));
+    bool ok = sync.on_frame(md.frames.back().first,
+                            std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&md.frames.back().second),
+                                                     sizeof(LevelUpdateBody)));
+    assert(!ok);
+    assert(sync.state() == SnapshotSync::State::Stale);
+
+    // unknown instrument
+    BookSnapshot none;
+    assert(!eng.snapshot(999, md.seqno, none));
+    assert(!none.found && none.levels.empty());
+
+    std::cout << "snapshot_sync test passed\n";
+    return 0;
+}
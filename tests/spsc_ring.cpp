@@ -0,0 +1,54 @@
+#include "spsc_ring.hpp"
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+int main() {
+    // --- 1) Single-threaded semantics: capacity rounds up, full/empty reported
+    {
+        SpscRing<uint64_t> ring(5);
+        assert(ring.capacity() == 8);
+        uint64_t v = 0;
+        assert(!ring.try_pop(v));
+        for (uint64_t i = 0; i < 8; ++i) {
+            bool ok = ring.try_push(i);
+            assert(ok);
+        }
+        assert(!ring.try_push(99)); // full
+        for (uint64_t i = 0; i < 8; ++i) {
+            bool ok = ring.try_pop(v);
+            assert(ok && v == i);
+        }
+        assert(ring.empty());
+    }
+
+    // --- 2) Producer/consumer threads: every value arrives once, in order
+    {
+        constexpr uint64_t kN = 1'000'000;
+        SpscRing<uint64_t> ring(1024);
+        std::thread producer([&] {
+            for (uint64_t i = 1; i <= kN; ++i) {
+                while (!ring.try_push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        uint64_t expected = 1;
+        uint64_t v = 0;
+        while (expected <= kN) {
+            if (ring.try_pop(v)) {
+                assert(v == expected);
+                ++expected;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        assert(ring.empty());
+    }
+
+    std::cout << "spsc_ring test passed\n";
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "engine.hpp"
+#include "stage_latency.hpp"
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static OrderNewBody order(uint64_t cid, uint8_t side, int64_t px, int32_t qty) {
+    OrderNewBody o{};
+    o.client_order_id = cid;
+    o.instrument_id = 1;
+    o.side = side;
+    o.price_ticks = px;
+    o.qty = qty;
+    return o;
+}
+
+static uint64_t samples(LatencyStage s) {
+    return latency::read(s).count();
+}
+
+int main() {
+    static_assert(alignof(LatencyShard) == kCacheLine && sizeof(LatencyShard) % kCacheLine == 0);
+    assert(std::string(latency_stage_name(LatencyStage::NewTotal)) == "new_total");
+    assert(std::string(latency_stage_name(LatencyStage::Write)) == "write");
+    assert(match_stage(0) == LatencyStage::Match0 && match_stage(1) == LatencyStage::Match1);
+    assert(match_stage(2) == LatencyStage::Match2To4 && match_stage(4) == LatencyStage::Match2To4);
+    assert(match_stage(5) == LatencyStage::Match5To16 && match_stage(16) == LatencyStage::Match5To16);
+    assert(match_stage(17) == LatencyStage::Match17Plus);
+
+    // --- per-thread shards merged on read, same percentiles as one histogram
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (uint64_t v = 1; v <= 1000; ++v) {
+                latency::record(LatencyStage::Write, v * 1000 + t);
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    latency::record(LatencyStage::Decode, 100, 50); // a clock that stepped back records 0
+#ifndef MARKETFEED_NO_METRICS
+    LatencyHistogram expect;
+    for (uint64_t t = 0; t < 4; ++t) {
+        for (uint64_t v = 1; v <= 1000; ++v) {
+            expect.record(v * 1000 + t);
+        }
+    }
+    const LatencyHistogram w = latency::read(LatencyStage::Write);
+    assert(w.count() == 4000 && w.min() == 1000 && w.max() == 1'000'003);
+    assert(w.mean() == expect.mean());
+    for (double p : {50.0, 90.0, 99.0, 99.9}) {
+        assert(w.percentile(p) == expect.percentile(p));
+    }
+    assert(samples(LatencyStage::Decode) == 1 && latency::read(LatencyStage::Decode).max() == 0);
+#else
+    assert(samples(LatencyStage::Write) == 0);
+#endif
+
+    // --- engine stages: validation, matching bucketed by fills, cancels
+    Engine engine;
+    for (uint64_t i = 0; i < 6; ++i) {
+        engine.on_new(order(1 + i, 1, 101, 1), true);    // 6 asks at 101
+    }
+    engine.on_new(order(10, 0, 101, 1), true);           // 1 fill
+    engine.on_new(order(11, 0, 101, 5), true);           // 5 fills
+    engine.on_new(order(12, 0, 0, 0), true);             // rejected before validation ends
+    OrderCancelBody c{};
+    c.exch_order_id = 42;
+    c.instrument_id = 1;
+    engine.on_cancel(c);                                 // unknown order: still reaches the book
+    MassCancelBody mc{};
+    mc.side = kBothSides;
+    engine.on_mass_cancel(mc, kAnyOwner);
+#ifndef MARKETFEED_NO_METRICS
+    assert(samples(LatencyStage::Validate) == 10);
+    assert(samples(LatencyStage::Match0) == 6);
+    assert(samples(LatencyStage::Match1) == 1);
+    assert(samples(LatencyStage::Match5To16) == 1);
+    assert(samples(LatencyStage::Match2To4) == 0 && samples(LatencyStage::Match17Plus) == 0);
+    assert(samples(LatencyStage::Cancel) == 2);
+#endif
+
+    // --- STATS reply frames and the dump
+    const std::vector<LatencyBody> bodies = latency::latency_bodies(9);
+    const std::string dump = latency::format();
+#ifndef MARKETFEED_NO_METRICS
+    assert(!bodies.empty());
+    uint8_t prev = 0;
+    for (const LatencyBody& b : bodies) {
+        assert(b.request_id == 9 && b.count > 0 && b.stage >= prev);
+        assert(b.min_ns <= b.p50_ns && b.p50_ns <= b.p90_ns && b.p90_ns <= b.p99_ns && b.p99_ns <= b.p999_ns &&
+               b.p999_ns <= b.max_ns);
+        prev = b.stage;
+    }
+    assert(bodies.back().stage == static_cast<uint8_t>(LatencyStage::Write) && bodies.back().count == 4000);
+    assert(dump.find("write n=4000 min=1000 ") != std::string::npos);
+    assert(dump.find("match_2_4") == std::string::npos); // empty stages are left out
+#else
+    assert(bodies.empty() && dump.empty());
+#endif
+
+    std::cout << "stage_latency test passed\n";
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include "engine.hpp"
+#include "top_of_book.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Publish number v of an instrument: every field is derived from v, so a
+// read mixing two publishes cannot pass check().
+static BboBody quote(uint32_t instrument_id, uint64_t v) {
+    BboBody b{};
+    b.instrument_id = instrument_id;
+    b.bid_price_ticks = int64_t(v);
+    b.ask_price_ticks = int64_t(v) + 1;
+    b.bid_total_qty = int64_t(v * 7);
+    b.ask_total_qty = int64_t(v * 11);
+    b.bid_order_count = uint32_t(v);
+    b.ask_order_count = uint32_t(v * 3);
+    return b;
+}
+
+static bool check(const TopOfBook& t, uint32_t instrument_id) {
+    const BboBody want = quote(instrument_id, t.version);
+    return std::memcmp(&want, &t.bbo, sizeof(BboBody)) == 0;
+}
+
+int main() {
+    // --- single thread: capacity, unpublished slots, versions
+    {
+        TopOfBookCache cache(4);
+        TopOfBook t{};
+        assert(cache.max_instruments() == 4);
+        assert(!cache.read(1, t) && !cache.read(0, t) && !cache.read(5, t));
+        assert(cache.publish(quote(1, 1)) && !cache.publish(quote(5, 1)) && !cache.publish(quote(0, 1)));
+        assert(cache.read(1, t) && t.version == 1 && check(t, 1));
+        assert(cache.publish(quote(1, 2)) && cache.version(1) == 2 && cache.version(2) == 0);
+        assert(cache.read(1, t) && t.version == 2 && check(t, 1));
+    }
+
+    // --- one writer, four readers: every read is one whole publish, and
+    // versions never go backwards for a reader
+    {
+        constexpr uint32_t kInstruments = 64;
+        constexpr uint64_t kPublishes = 2'000'000;
+        constexpr int kReaders = 4;
+        TopOfBookCache cache(kInstruments);
+        std::atomic<bool> done{false};
+        std::atomic<uint64_t> torn{0};
+        std::atomic<uint64_t> reads{0};
+        std::vector<std::thread> readers;
+        for (int r = 0; r < kReaders; ++r) {
+            readers.emplace_back([&, r] {
+                std::vector<uint64_t> seen(kInstruments + 1, 0);
+                uint64_t n = 0;
+                uint32_t id = 1 + uint32_t(r);
+                while (!done.load(std::memory_order_relaxed)) {
+                    TopOfBook t;
+                    if (cache.read(id, t)) {
+                        if (!check(t, id) || t.version < seen[id]) {
+                            torn.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        seen[id] = t.version;
+                        ++n;
+                    }
+                    id = id % kInstruments + 1;
+                }
+                reads.fetch_add(n, std::memory_order_relaxed);
+            });
+        }
+        std::vector<uint64_t> version(kInstruments + 1, 0);
+        for (uint64_t i = 0; i < kPublishes; ++i) {
+            // hot instruments change more often, as in a real session
+            const uint32_t id = 1 + uint32_t((i * i) % kInstruments);
+            cache.publish(quote(id, ++version[id]));
+        }
+        done.store(true, std::memory_order_relaxed);
+        for (std::thread& t : readers) {
+            t.join();
+        }
+        assert(torn.load() == 0);
+        assert(reads.load() > 0);
+        for (uint32_t id = 1; id <= kInstruments; ++id) {
+            TopOfBook t;
+            assert(cache.version(id) == version[id]);
+            assert(version[id] == 0 || (cache.read(id, t) && check(t, id)));
+        }
+    }
+
+    // --- engine: quotes appear on attach and after each batch
+    {
+        Engine engine;
+        TopOfBookCache cache(engine.num_instruments());
+        engine.set_top_of_book(&cache);
+        TopOfBook t;
+        assert(cache.read(1, t) && t.version == 1 && t.bbo.bid_total_qty == 0 && t.bbo.instrument_id == 1);
+
+        OrderNewBody o{};
+        o.client_order_id = 1;
+        o.instrument_id = 2;
+        o.side = 0;
+        o.price_ticks = 100;
+        o.qty = 10;
+        engine.on_new(o, true);
+        o.price_ticks = 101;
+        engine.on_new(o, true);
+        assert(cache.version(2) == 1); // not before the batch ends
+        std::vector<BboBody> bbos;
+        engine.flush_bbo(bbos);
+        assert(bbos.size() == 1);
+        assert(cache.read(2, t) && t.version == 2 && std::memcmp(&t.bbo, &bbos[0], sizeof(BboBody)) == 0);
+        assert(t.bbo.bid_price_ticks == 101 && t.bbo.bid_order_count == 1);
+        bbos.clear();
+        engine.flush_bbo(bbos); // nothing changed: nothing published
+        assert(bbos.empty() && cache.version(2) == 2 && cache.version(1) == 1);
+        engine.set_top_of_book(nullptr);
+    }
+
+    std::cout << "top_of_book test passed\n";
+    return 0;
+}
@@ -19,7 +19,7 @@ int main() {
     body.instrument_id = 1; // AAPL
     body.side = 0; // 0 -> bid, 1 -> ask
     body.flags = 0;
-    body.pad = 0;
+    body.expire_after_s = 0;
 
     std::array<uint8_t, sizeof(Header) + sizeof(OrderNewBody)> buffer{};
     std::memcpy(buffer.data(), &hdr, sizeof(Header));